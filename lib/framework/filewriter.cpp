@@ -0,0 +1,222 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Writing files on a background thread, see filewriter.h.
+ */
+
+#include <QtCore/QJsonDocument>
+
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/framework/wzapp.h"
+
+#include "filewriter.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+struct FileWriterJob
+{
+	std::string fileName;
+	std::vector<char> data;  ///< What to write, unless isJson.
+	QJsonObject json;        ///< What to encode and write, if isJson.
+	bool isJson;
+};
+
+static bool fileWriterBatch = false;  ///< Only used by the main thread.
+
+// Protected by fileWriterMutex.
+static WZ_MUTEX *fileWriterMutex = nullptr;
+static WZ_SEMAPHORE *fileWriterSemaphore = nullptr;      ///< Posted once per job queued, and once to quit.
+static WZ_SEMAPHORE *fileWriterIdleSemaphore = nullptr;  ///< Posted when the queue runs empty, if fileWriterWaiting.
+static WZ_THREAD *fileWriterThread = nullptr;
+static std::deque<FileWriterJob> fileWriterJobs;
+static FileWriterProgress fileWriterCount = {0, 0, 0};
+static bool fileWriterWaiting = false;
+static bool fileWriterQuit = false;
+
+static int fileWriterThreadFunc(void *)
+{
+	wzMutexLock(fileWriterMutex);
+	while (true)
+	{
+		wzMutexUnlock(fileWriterMutex);
+		wzSemaphoreWait(fileWriterSemaphore);  // Go to sleep until needed.
+		wzMutexLock(fileWriterMutex);
+
+		if (fileWriterJobs.empty())
+		{
+			if (fileWriterQuit)
+			{
+				break;
+			}
+			continue;
+		}
+
+		FileWriterJob job = std::move(fileWriterJobs.front());
+		fileWriterJobs.pop_front();
+		wzMutexUnlock(fileWriterMutex);
+
+		bool ok;
+		if (job.isJson)
+		{
+			QByteArray json = QJsonDocument(job.json).toJson();
+			job.json = QJsonObject();  // Let go of the snapshot, so the game doesn't need to copy it when changing it.
+			ok = saveFile(job.fileName.c_str(), json.constData(), json.size());
+		}
+		else
+		{
+			ok = saveFile(job.fileName.c_str(), job.data.data(), job.data.size());
+		}
+		debug(LOG_SAVE, "Wrote %s in the background", job.fileName.c_str());
+
+		wzMutexLock(fileWriterMutex);
+		++fileWriterCount.done;
+		fileWriterCount.failed += !ok;
+		if (fileWriterJobs.empty() && fileWriterWaiting)
+		{
+			fileWriterWaiting = false;
+			wzSemaphorePost(fileWriterIdleSemaphore);
+		}
+	}
+	wzMutexUnlock(fileWriterMutex);
+
+	return 0;
+}
+
+static void fileWriterQueue(FileWriterJob &&job)
+{
+	if (fileWriterThread == nullptr)
+	{
+		fileWriterMutex = wzMutexCreate();
+		fileWriterSemaphore = wzSemaphoreCreate(0);
+		fileWriterIdleSemaphore = wzSemaphoreCreate(0);
+		fileWriterQuit = false;
+		fileWriterThread = wzThreadCreate(fileWriterThreadFunc, nullptr);
+		wzThreadStart(fileWriterThread);
+	}
+
+	wzMutexLock(fileWriterMutex);
+	fileWriterJobs.push_back(std::move(job));
+	++fileWriterCount.total;
+	wzMutexUnlock(fileWriterMutex);
+	wzSemaphorePost(fileWriterSemaphore);
+}
+
+void fileWriterBeginBatch()
+{
+	ASSERT(!fileWriterBatch, "Already in a batch");
+	fileWriterBatch = true;
+}
+
+void fileWriterEndBatch()
+{
+	ASSERT(fileWriterBatch, "Not in a batch");
+	fileWriterBatch = false;
+}
+
+bool fileWriterSave(const char *fileName, const char *data, size_t size)
+{
+	if (!fileWriterBatch)
+	{
+		return saveFile(fileName, data, size);
+	}
+
+	FileWriterJob job;
+	job.fileName = fileName;
+	job.data.assign(data, data + size);
+	job.isJson = false;
+	fileWriterQueue(std::move(job));
+	return true;
+}
+
+bool fileWriterSaveJson(QString const &fileName, QJsonObject const &json)
+{
+	if (!fileWriterBatch)
+	{
+		QByteArray data = QJsonDocument(json).toJson();
+		return saveFile(fileName.toUtf8().constData(), data.constData(), data.size());
+	}
+
+	FileWriterJob job;
+	job.fileName = fileName.toUtf8().constData();
+	job.json = json;
+	job.isJson = true;
+	fileWriterQueue(std::move(job));
+	return true;
+}
+
+FileWriterProgress fileWriterProgress()
+{
+	if (fileWriterThread == nullptr)
+	{
+		return fileWriterCount;
+	}
+
+	wzMutexLock(fileWriterMutex);
+	FileWriterProgress progress = fileWriterCount;
+	wzMutexUnlock(fileWriterMutex);
+	return progress;
+}
+
+bool fileWriterWait()
+{
+	if (fileWriterThread == nullptr)
+	{
+		return true;
+	}
+
+	wzMutexLock(fileWriterMutex);
+	if (fileWriterCount.done != fileWriterCount.total)
+	{
+		fileWriterWaiting = true;
+		wzMutexUnlock(fileWriterMutex);
+		wzSemaphoreWait(fileWriterIdleSemaphore);
+		wzMutexLock(fileWriterMutex);
+	}
+	bool ok = fileWriterCount.failed == 0;
+	fileWriterCount = {0, 0, 0};
+	wzMutexUnlock(fileWriterMutex);
+	return ok;
+}
+
+void fileWriterShutdown()
+{
+	if (fileWriterThread == nullptr)
+	{
+		return;
+	}
+
+	fileWriterWait();
+
+	wzMutexLock(fileWriterMutex);
+	fileWriterQuit = true;
+	wzMutexUnlock(fileWriterMutex);
+	wzSemaphorePost(fileWriterSemaphore);  // Wake up the thread.
+	wzThreadJoin(fileWriterThread);
+	fileWriterThread = nullptr;
+
+	wzMutexDestroy(fileWriterMutex);
+	fileWriterMutex = nullptr;
+	wzSemaphoreDestroy(fileWriterSemaphore);
+	fileWriterSemaphore = nullptr;
+	wzSemaphoreDestroy(fileWriterIdleSemaphore);
+	fileWriterIdleSemaphore = nullptr;
+}
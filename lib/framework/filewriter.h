@@ -0,0 +1,66 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Writing files on a background thread.
+ *
+ *  Between fileWriterBeginBatch() and fileWriterEndBatch(), fileWriterSave() and fileWriterSaveJson() (and so WzConfig
+ *  in ReadAndWrite mode) only copy what is to be written, and a worker thread encodes and writes it later, in the order
+ *  queued. Outside a batch, they write at once, like saveFile(). Copying a QJsonObject is cheap, since Qt only copies
+ *  the data if either copy is changed afterwards.
+ *
+ *  Batches are only opened, ended and waited for by the main thread.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_FILEWRITER_H__
+#define __INCLUDED_LIB_FRAMEWORK_FILEWRITER_H__
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+
+#include "lib/framework/types.h"
+
+struct FileWriterProgress
+{
+	unsigned done;    ///< Files written, or failed to be written, since the last fileWriterWait().
+	unsigned total;   ///< Files queued since the last fileWriterWait().
+	unsigned failed;  ///< Files which could not be written since the last fileWriterWait().
+};
+
+/// Starts queueing writes, instead of doing them at once.
+void fileWriterBeginBatch();
+
+/// Stops queueing writes. The queued ones carry on in the background.
+void fileWriterEndBatch();
+
+/// Saves data to fileName, or queues it if in a batch. Only returns false if the file was written at once, and failed.
+WZ_DECL_NONNULL(1) bool fileWriterSave(const char *fileName, const char *data, size_t size);
+
+/// Saves json to fileName, formatted like QJsonDocument::toJson(), or queues it if in a batch.
+bool fileWriterSaveJson(QString const &fileName, QJsonObject const &json);
+
+/// Returns how far the worker has got.
+FileWriterProgress fileWriterProgress();
+
+/// Waits for all queued files to be written, and resets the progress. Returns false if any of them failed.
+bool fileWriterWait();
+
+/// Waits for all queued files, and stops the worker thread.
+void fileWriterShutdown();
+
+#endif // __INCLUDED_LIB_FRAMEWORK_FILEWRITER_H__
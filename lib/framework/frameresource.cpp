@@ -29,6 +29,13 @@
 
 #include "file.h"
 #include "resly.h"
+#include "wzworkers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
 
 // Local prototypes
 static RES_TYPE *psResTypes = nullptr;
@@ -46,6 +53,35 @@ static void ResetResourceFile();
 // callback to resload screen.
 static RESLOAD_CALLBACK resLoadCallback = nullptr;
 
+#define RES_PROFILE_MAX_EVENTS (1 << 16)
+
+/// A file listed in a wrf, waiting to be loaded.
+struct ResLoadEntry
+{
+	RES_TYPE *psT;
+	std::string file;           ///< Name in the wrf, which becomes the ID of the resource.
+	std::string fileName;       ///< Path to load, including the directory, and translated if there is a translation.
+	void *pDecoded;             ///< What psT->decode made, until loaded.
+	bool decodeOk;
+	uint64_t decodeStart;       ///< Microseconds since resProfileStart.
+	uint64_t decodeEnd;
+};
+
+/// Time spent decoding or loading a file, or a whole wrf, for resProfileWriteTrace().
+struct ResProfileEvent
+{
+	std::string name;
+	std::string type;           ///< Resource type, or "wrf" for the whole file.
+	uint64_t start;             ///< Microseconds since resProfileStart.
+	uint32_t duration;          ///< Microseconds.
+	unsigned thread;            ///< 0 for the main thread, else the worker, see wzWorkersThreadOf().
+	bool decode;                ///< Whether decoding, rather than loading.
+};
+
+static std::vector<ResLoadEntry> *resLoadQueue = nullptr;  ///< Where resLoadFile() puts files, while resLoad() parses a wrf.
+static std::vector<ResProfileEvent> resProfileEvents;
+static std::chrono::steady_clock::time_point resProfileStart = std::chrono::steady_clock::now();
+
 
 /* next four used in HashPJW */
 #define	BITS_IN_int		32
@@ -179,11 +215,88 @@ void resSetBaseDir(const char *pResDir)
 	sstrcpy(aResDir, pResDir);
 }
 
+static uint64_t resProfileTime()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - resProfileStart).count();
+}
+
+static void resProfileRecord(std::string const &name, std::string const &type, uint64_t start, uint64_t end, unsigned thread, bool decode)
+{
+	if (resProfileEvents.size() >= RES_PROFILE_MAX_EVENTS)
+	{
+		return;  // Only meant for profiling startup, which is well within this.
+	}
+	ResProfileEvent event;
+	event.name = name;
+	event.type = type;
+	event.start = start;
+	event.duration = end - start;
+	event.thread = thread;
+	event.decode = decode;
+	resProfileEvents.push_back(event);
+}
+
+static void resDecodeEntry(ResLoadEntry &entry);
+static bool resLoadEntry(ResLoadEntry &entry);
+
+/// Loads the files listed in a wrf in order, while the files which can be decoded on any thread are decoded in parallel.
+static bool resLoadEntries(const char *pResFile, std::vector<ResLoadEntry> &entries)
+{
+	uint64_t start = resProfileTime();
+
+	std::vector<unsigned> decodes;  // The entries to decode, in order.
+	for (unsigned i = 0; i < entries.size(); ++i)
+	{
+		if (entries[i].psT->decode != nullptr)
+		{
+			decodes.push_back(i);
+		}
+	}
+	std::shared_ptr<WzWorkBatch> batch = wzWorkersStart(decodes.size(), [&entries, &decodes](unsigned index) {
+		resDecodeEntry(entries[decodes[index]]);
+	});
+
+	bool ok = true;
+	unsigned decoded = 0;
+	uint64_t decodeTime = 0;
+	for (ResLoadEntry &entry : entries)
+	{
+		if (entry.psT->decode != nullptr)
+		{
+			wzWorkersFinish(*batch, decoded);
+			resProfileRecord(entry.file, entry.psT->aType, entry.decodeStart, entry.decodeEnd, wzWorkersThreadOf(*batch, decoded), true);
+			decodeTime += entry.decodeEnd - entry.decodeStart;
+			++decoded;
+		}
+		if (!ok)
+		{
+			// Already failed, so just free what was decoded.
+			if (entry.pDecoded != nullptr)
+			{
+				entry.psT->decodedRelease(entry.pDecoded);
+			}
+			continue;
+		}
+
+		uint64_t loadStart = resProfileTime();
+		ok = resLoadEntry(entry);
+		resProfileRecord(entry.file, entry.psT->aType, loadStart, resProfileTime(), 0, false);
+	}
+
+	uint64_t end = resProfileTime();
+	resProfileRecord(pResFile, "wrf", start, end, 0, false);
+	debug(LOG_WZ, "resLoad: loaded %u files from %s in %u ms, %u of them decoded in parallel, taking %u ms on %u threads",
+	      (unsigned)entries.size(), pResFile, (unsigned)((end - start) / 1000), decoded, (unsigned)(decodeTime / 1000), wzWorkersCount() + 1);
+
+	return ok;
+}
+
 /* Parse the res file */
 bool resLoad(const char *pResFile, SDWORD blockID)
 {
 	bool retval = true;
 	lexerinput_t input;
+	std::vector<ResLoadEntry> entries;
 
 	sstrcpy(aCurrResDir, aResDir);
 
@@ -201,17 +314,25 @@ bool resLoad(const char *pResFile, SDWORD blockID)
 		return false;
 	}
 
-	// and parse it
+	// and parse it, listing the files in entries
+	resLoadQueue = &entries;
 	res_set_extra(&input);
 	if (res_parse() != 0)
 	{
 		debug(LOG_FATAL, "Failed to parse %s", pResFile);
 		retval = false;
 	}
+	resLoadQueue = nullptr;
 
 	res_lex_destroy();
 	PHYSFS_close(input.input.physfsfile);
 
+	// then load the files listed before any error
+	if (!resLoadEntries(pResFile, entries))
+	{
+		retval = false;
+	}
+
 	return retval;
 }
 
@@ -246,6 +367,9 @@ bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffLoad, RES_FREE relea
 
 	psT->buffLoad = buffLoad;
 	psT->fileLoad = nullptr;
+	psT->decode = nullptr;
+	psT->decodedLoad = nullptr;
+	psT->decodedRelease = nullptr;
 	psT->release = release;
 
 	psT->psNext = psResTypes;
@@ -262,6 +386,28 @@ bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release)
 
 	psT->buffLoad = nullptr;
 	psT->fileLoad = fileLoad;
+	psT->decode = nullptr;
+	psT->decodedLoad = nullptr;
+	psT->decodedRelease = nullptr;
+	psT->release = release;
+
+	psT->psNext = psResTypes;
+	psResTypes = psT;
+
+	return true;
+}
+
+
+/* Add a decode and load function for a file type */
+bool resAddDecodeLoad(const char *pType, RES_FILEDECODE decode, RES_DECODEDLOAD decodedLoad, RES_FREE decodedRelease, RES_FREE release)
+{
+	RES_TYPE	*psT = resAlloc(pType);
+
+	psT->buffLoad = nullptr;
+	psT->fileLoad = nullptr;
+	psT->decode = decode;
+	psT->decodedLoad = decodedLoad;
+	psT->decodedRelease = decodedRelease;
 	psT->release = release;
 
 	psT->psNext = psResTypes;
@@ -349,7 +495,7 @@ static SDWORD FindEmptyResourceFile()
 
 
 // Get a resource data file ... either loads it or just returns a pointer
-static bool RetreiveResourceFile(char *ResourceName, RESOURCEFILE **NewResource)
+static bool RetreiveResourceFile(const char *ResourceName, RESOURCEFILE **NewResource)
 {
 	SDWORD ResID;
 	RESOURCEFILE *ResData;
@@ -459,64 +605,82 @@ static void makeLocaleFile(char *fileName, size_t maxlen)  // given string must
 }
 
 
-/*!
- * Call the load function (registered in data.c)
- * for this filetype
- */
-bool resLoadFile(const char *pType, const char *pFile)
+/// Returns whether a file of the type with the same name has already been loaded.
+static bool resIsDuplicate(RES_TYPE *psT, const char *pFile)
 {
-	RES_TYPE	*psT = nullptr;
-	void		*pData = nullptr;
-	RES_DATA	*psRes = nullptr;
-	char		aFileName[PATH_MAX];
-	UDWORD HashedName, HashedType = HashString(pType);
-
-	// Find the resource-type
-	for (psT = psResTypes; psT != nullptr; psT = psT->psNext)
-	{
-		if (psT->HashedType == HashedType)
-		{
-			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
-			break;
-		}
-	}
-
-	if (psT == nullptr)
-	{
-		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
-		return false;
-	}
-
-	// Check for duplicates
-	HashedName = HashStringIgnoreCase(pFile);
-	for (psRes = psT->psRes; psRes; psRes = psRes->psNext)
+	UDWORD HashedName = HashStringIgnoreCase(pFile);
+	for (RES_DATA *psRes = psT->psRes; psRes; psRes = psRes->psNext)
 	{
 		if (psRes->HashedID == HashedName)
 		{
 			ASSERT(strcasecmp(psRes->aID, pFile) == 0, "Hash collision \"%s\" vs \"%s\"", psRes->aID, pFile);
 			debug(LOG_WZ, "Duplicate file name: %s (hash %x) for type %s",
 			      pFile, HashedName, psT->aType);
-			// assume that they are actually both the same and silently fail
-			// lovely little hack to allow some files to be loaded from disk (believe it or not!).
 			return true;
 		}
 	}
+	return false;
+}
 
-	// Create the file name
-	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+/// Decodes the file of an entry, if its type has a decode function. May be called on any thread.
+static void resDecodeEntry(ResLoadEntry &entry)
+{
+	entry.decodeStart = resProfileTime();
+	entry.decodeOk = entry.psT->decode(entry.fileName.c_str(), &entry.pDecoded);
+	entry.decodeEnd = resProfileTime();
+}
+
+/// Loads the file of an entry, using what was decoded if its type has a decode function, and adds it to the resources.
+static bool resLoadEntry(ResLoadEntry &entry)
+{
+	RES_TYPE	*psT = entry.psT;
+	void		*pData = nullptr;
+	RES_DATA	*psRes = nullptr;
+	const char	*pType = psT->aType;
+	const char	*pFile = entry.file.c_str();
+	const char	*aFileName = entry.fileName.c_str();
+
+	// Check for duplicates again, in case the wrf listed the file twice
+	if (resIsDuplicate(psT, pFile))
 	{
-		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
-		return false;
+		if (entry.pDecoded != nullptr)
+		{
+			psT->decodedRelease(entry.pDecoded);
+			entry.pDecoded = nullptr;
+		}
+		// assume that they are actually both the same and silently fail
+		// lovely little hack to allow some files to be loaded from disk (believe it or not!).
+		return true;
 	}
-	sstrcpy(aFileName, aCurrResDir);
-	sstrcat(aFileName, pFile);
-
-	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
 
 	SetLastResourceFilename(pFile); // Save the filename in case any routines need it
 
 	// load the resource
-	if (psT->buffLoad)
+	if (psT->decode)
+	{
+		// Finish loading what was decoded, which belongs to decodedLoad from now on
+		bool ok = entry.decodeOk;
+		if (ok)
+		{
+			ok = psT->decodedLoad(aFileName, entry.pDecoded, &pData);
+		}
+		else if (entry.pDecoded != nullptr)
+		{
+			psT->decodedRelease(entry.pDecoded);
+		}
+		entry.pDecoded = nullptr;
+
+		if (!ok)
+		{
+			ASSERT(false, "The load function for resource type \"%s\" failed for file \"%s\"", pType, pFile);
+			if (psT->release != nullptr)
+			{
+				psT->release(pData);
+			}
+			return false;
+		}
+	}
+	else if (psT->buffLoad)
 	{
 		RESOURCEFILE *Resource;
 
@@ -578,6 +742,73 @@ bool resLoadFile(const char *pType, const char *pFile)
 	return true;
 }
 
+/*!
+ * Call the load function (registered in data.c)
+ * for this filetype, or while resLoad() is parsing a wrf, list the file for it to load
+ */
+bool resLoadFile(const char *pType, const char *pFile)
+{
+	RES_TYPE	*psT = nullptr;
+	char		aFileName[PATH_MAX];
+	UDWORD HashedType = HashString(pType);
+
+	// Find the resource-type
+	for (psT = psResTypes; psT != nullptr; psT = psT->psNext)
+	{
+		if (psT->HashedType == HashedType)
+		{
+			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
+			break;
+		}
+	}
+
+	if (psT == nullptr)
+	{
+		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
+		return false;
+	}
+
+	// Check for duplicates
+	if (resIsDuplicate(psT, pFile))
+	{
+		// assume that they are actually both the same and silently fail
+		// lovely little hack to allow some files to be loaded from disk (believe it or not!).
+		return true;
+	}
+
+	// Create the file name
+	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+	{
+		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
+		return false;
+	}
+	sstrcpy(aFileName, aCurrResDir);
+	sstrcat(aFileName, pFile);
+
+	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
+
+	ResLoadEntry entry;
+	entry.psT = psT;
+	entry.file = pFile;
+	entry.fileName = aFileName;
+	entry.pDecoded = nullptr;
+	entry.decodeOk = false;
+	entry.decodeStart = 0;
+	entry.decodeEnd = 0;
+
+	if (resLoadQueue != nullptr)
+	{
+		resLoadQueue->push_back(std::move(entry));
+		return true;
+	}
+
+	if (psT->decode != nullptr)
+	{
+		resDecodeEntry(entry);
+	}
+	return resLoadEntry(entry);
+}
+
 /* Return the resource for a type and hashedname */
 void *resGetDataFromHash(const char *pType, UDWORD HashedID)
 {
@@ -857,3 +1088,57 @@ void resReleaseBlockData(SDWORD blockID)
 		psNT = psT->psNext;
 	}
 }
+
+bool resProfileWriteTrace(const char *fileName)
+{
+	struct TypeTotals
+	{
+		unsigned files = 0;
+		uint64_t decode = 0;
+		uint64_t load = 0;
+	};
+	std::map<std::string, TypeTotals> totals;
+	std::vector<ResProfileEvent const *> slowest;
+
+	std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (size_t n = 0; n < resProfileEvents.size(); ++n)
+	{
+		ResProfileEvent const &event = resProfileEvents[n];
+		char line[PATH_MAX + 256];
+		ssprintf(line, "{\"name\":\"%s\",\"cat\":\"%s%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u}",
+		         event.name.c_str(), event.type.c_str(), event.decode ? " decode" : "", event.thread + 1, (unsigned long long)event.start, event.duration);
+		trace += line;
+		trace += n + 1 < resProfileEvents.size() ? ",\n" : "\n";
+
+		if (event.type == "wrf")
+		{
+			continue;
+		}
+		TypeTotals &total = totals[event.type];
+		total.files += !event.decode;
+		(event.decode ? total.decode : total.load) += event.duration;
+		slowest.push_back(&event);
+	}
+	trace += "]}\n";
+
+	size_t numSlowest = std::min<size_t>(slowest.size(), 10);
+	std::partial_sort(slowest.begin(), slowest.begin() + numSlowest, slowest.end(), [](ResProfileEvent const *a, ResProfileEvent const *b) {
+		return a->duration > b->duration;
+	});
+
+	debug(LOG_INFO, "Resource loading profile, decoding on up to %u threads:", wzWorkersCount() + 1);
+	for (auto const &total : totals)
+	{
+		debug(LOG_INFO, "  %-12s %4u files, decode %8llu us, load %8llu us", total.first.c_str(), total.second.files,
+		      (unsigned long long)total.second.decode, (unsigned long long)total.second.load);
+	}
+	debug(LOG_INFO, "Slowest files:");
+	for (size_t n = 0; n < numSlowest; ++n)
+	{
+		debug(LOG_INFO, "  %-12s %-40s %s %8u us", slowest[n]->type.c_str(), slowest[n]->name.c_str(), slowest[n]->decode ? "decode" : "load  ", slowest[n]->duration);
+	}
+
+	resProfileEvents.clear();
+
+	return saveFile(fileName, trace.data(), trace.size());
+}
@@ -39,6 +39,12 @@ typedef bool (*RES_FILELOAD)(const char *pFile, void **pData);
 /** Function pointer for releasing a resource loaded by the above functions. */
 typedef void (*RES_FREE)(void *pData);
 
+/** Function pointer for a function that decodes a file, on any thread, for a RES_DECODEDLOAD function to load. */
+typedef bool (*RES_FILEDECODE)(const char *pFile, void **pDecoded);
+
+/** Function pointer for a function that loads decoded data, on the main thread. It takes ownership of pDecoded. */
+typedef bool (*RES_DECODEDLOAD)(const char *pFile, void *pDecoded, void **pData);
+
 /** callback type for resload display callback. */
 typedef void (*RESLOAD_CALLBACK)();
 
@@ -71,6 +77,11 @@ struct RES_TYPE
 	UDWORD	HashedType;				// hashed version of the name of the id - // a null hashedtype indicates end of list
 
 	RES_FILELOAD	fileLoad;		// This isn't really used any more ?
+
+	RES_FILEDECODE decode;          ///< Decodes the file in parallel with the other files in the wrf, if not NULL.
+	RES_DECODEDLOAD decodedLoad;    ///< Loads what decode made, in the order of the wrf.
+	RES_FREE decodedRelease;        ///< Frees what decode made, if it is not loaded.
+
 	RES_TYPE       *psNext;
 };
 
@@ -106,6 +117,10 @@ WZ_DECL_NONNULL(1) bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffL
 /** Add a file name load and release function for a file type. */
 WZ_DECL_NONNULL(1) bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release);
 
+/** Add a decode, load and release function for a file type. Files of the type are decoded on the worker threads
+ *  while resLoad() loads the rest of the wrf, see wzworkers.h. */
+WZ_DECL_NONNULL(1, 2, 3, 4) bool resAddDecodeLoad(const char *pType, RES_FILEDECODE decode, RES_DECODEDLOAD decodedLoad, RES_FREE decodedRelease, RES_FREE release);
+
 /** Call the load function for a file. */
 WZ_DECL_NONNULL(1, 2) bool resLoadFile(const char *pType, const char *pFile);
 
@@ -132,4 +147,8 @@ const char *GetLastResourceFilename() WZ_DECL_PURE;
 /** Set the resource name of the last resource file loaded. */
 WZ_DECL_NONNULL(1) void SetLastResourceFilename(const char *pName);
 
+/** Writes how long each file loaded by resLoad() took to decode and load, to the given file in the write directory,
+ *  in the Chrome trace event format, like tickProfileWriteTrace(), and logs a summary. */
+WZ_DECL_NONNULL(1) bool resProfileWriteTrace(const char *fileName);
+
 #endif // _frameresource_h
@@ -0,0 +1,126 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A queue for passing values from one thread to another, without locking.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_SPSCQUEUE_H__
+#define __INCLUDED_LIB_FRAMEWORK_SPSCQUEUE_H__
+
+#include <atomic>
+#include <utility>
+
+/** An unbounded single producer, single consumer queue
+ *
+ *  One thread may call push(), and one other thread may call pop() and empty(). Neither ever waits for the other.
+ *
+ *  The values are kept in a linked list of nodes. Nodes which the consumer has finished with are reused by the producer,
+ *  so once the queue has grown large enough, pushing and popping don't allocate, except for what the values themselves
+ *  allocate.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+	SpscQueue()
+	{
+		Node *node = new Node;
+		tail.store(node, std::memory_order_relaxed);
+		head = node;
+		first = node;
+		tailCopy = node;
+	}
+
+	~SpscQueue()
+	{
+		Node *node = first;
+		while (node != nullptr)
+		{
+			Node *next = node->next.load(std::memory_order_relaxed);
+			delete node;
+			node = next;
+		}
+	}
+
+	SpscQueue(SpscQueue const &) = delete;
+	SpscQueue &operator =(SpscQueue const &) = delete;
+
+	/// Adds a value to the queue. Only called by the producer.
+	void push(T &&value)
+	{
+		Node *node = allocNode();
+		node->value = std::move(value);
+		node->next.store(nullptr, std::memory_order_relaxed);
+		head->next.store(node, std::memory_order_release);
+		head = node;
+	}
+
+	/// Takes the oldest value out of the queue, or returns false if there isn't one. Only called by the consumer.
+	bool pop(T &value)
+	{
+		Node *oldTail = tail.load(std::memory_order_relaxed);
+		Node *node = oldTail->next.load(std::memory_order_acquire);
+		if (node == nullptr)
+		{
+			return false;
+		}
+		value = std::move(node->value);
+		tail.store(node, std::memory_order_release);  // The old tail may now be reused by the producer.
+		return true;
+	}
+
+	/// Returns true if there is nothing to pop. Only called by the consumer.
+	bool empty() const
+	{
+		return tail.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+	struct Node
+	{
+		std::atomic<Node *> next{nullptr};
+		T value;
+	};
+
+	/// Reuses a node already popped by the consumer, or allocates a new one. Only called by the producer.
+	Node *allocNode()
+	{
+		if (first == tailCopy)
+		{
+			tailCopy = tail.load(std::memory_order_acquire);
+			if (first == tailCopy)
+			{
+				return new Node;
+			}
+		}
+		Node *node = first;
+		first = first->next.load(std::memory_order_relaxed);
+		return node;
+	}
+
+	// Only written by the consumer.
+	std::atomic<Node *> tail;  ///< Last node popped, whose next is the next to pop.
+
+	// Only used by the producer.
+	Node *head;                ///< Last node pushed.
+	Node *first;               ///< Oldest node, nodes from here to tailCopy have been popped and can be reused.
+	Node *tailCopy;            ///< Copy of tail, so the producer doesn't need to read tail every time.
+};
+
+#endif // __INCLUDED_LIB_FRAMEWORK_SPSCQUEUE_H__
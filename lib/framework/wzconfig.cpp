@@ -30,39 +30,45 @@
 // Qt headers MUST come before platform specific stuff!
 #include "wzconfig.h"
 #include "file.h"
+#include "filewriter.h"
 
 WzConfig::~WzConfig()
 {
 	if (mWarning == ReadAndWrite)
 	{
 		ASSERT(mObjStack.empty(), "Some json groups have not been closed, stack size %d.", mObjStack.size());
-		QJsonDocument doc(mObj);
-		QByteArray json = doc.toJson();
-		saveFile(mFilename.toUtf8().constData(), json.constData(), json.size());
+		fileWriterSaveJson(mFilename, mObj);
 	}
 	debug(LOG_SAVE, "%s %s", mWarning == ReadAndWrite? "Saving" : "Closing", mFilename.toUtf8().constData());
 }
 
 static QJsonObject jsonMerge(QJsonObject original, const QJsonObject& override)
 {
-	for (const QString &key : override.keys())
+	for (QJsonObject::const_iterator i = override.constBegin(); i != override.constEnd(); ++i)
 	{
-		if (override[key].isObject() && original.contains(key))
+		QJsonObject::const_iterator o = original.constFind(i.key());
+		if (i.value().isObject() && o != original.constEnd())
 		{
-			original[key] = jsonMerge(original[key].toObject(), override[key].toObject());
+			original.insert(i.key(), jsonMerge(o.value().toObject(), i.value().toObject()));
 		}
-		else if (override[key].isNull())
+		else if (i.value().isNull())
 		{
-			original.remove(key);
+			original.remove(i.key());
 		}
 		else
 		{
-			original[key] = override[key];
+			original.insert(i.key(), i.value());
 		}
 	}
 	return original;
 }
 
+/// Reads an element of a vector, which may be written as a number, or as a string of one.
+static double jsonVectorElement(QJsonValue const &value)
+{
+	return value.isString() ? value.toString().toDouble() : value.toDouble();
+}
+
 WzConfig::WzConfig(const QString &name, WzConfig::warning warning, QObject *parent)
 {
 	UDWORD size;
@@ -72,6 +78,7 @@ WzConfig::WzConfig(const QString &name, WzConfig::warning warning, QObject *pare
 	mFilename = name;
 	mStatus = true;
 	mWarning = warning;
+	mArrayIndex = 0;
 
 	if (!PHYSFS_exists(name.toUtf8().constData()))
 	{
@@ -126,11 +133,12 @@ WzConfig::WzConfig(const QString &name, WzConfig::warning warning, QObject *pare
 QStringList WzConfig::childGroups() const
 {
 	QStringList keys;
-	for (QString const &key : mObj.keys())
+	keys.reserve(mObj.size());
+	for (QJsonObject::const_iterator i = mObj.constBegin(); i != mObj.constEnd(); ++i)
 	{
-		if (mObj[key].isObject())
+		if (i.value().isObject())
 		{
-			keys.push_back(key);
+			keys.push_back(i.key());
 		}
 	}
 	return keys;
@@ -148,26 +156,22 @@ bool WzConfig::contains(const QString &key) const
 
 QVariant WzConfig::value(const QString &key, const QVariant &defaultValue) const
 {
-	if (!contains(key))
+	QJsonObject::const_iterator i = mObj.constFind(key);
+	if (i == mObj.constEnd())
 	{
 		return defaultValue;
 	}
-	else
-	{
-		return mObj.value(key).toVariant();
-	}
+	return i.value().toVariant();
 }
 
 QJsonValue WzConfig::json(const QString &key, const QJsonValue &defaultValue) const
 {
-	if (!contains(key))
+	QJsonObject::const_iterator i = mObj.constFind(key);
+	if (i == mObj.constEnd())
 	{
 		return defaultValue;
 	}
-	else
-	{
-		return mObj.value(key);
-	}
+	return i.value();
 }
 
 void WzConfig::setVector3f(const QString &name, const Vector3f &v)
@@ -182,11 +186,11 @@ Vector3f WzConfig::vector3f(const QString &name)
 	{
 		return r;
 	}
-	QStringList v = value(name).toStringList();
-	ASSERT(v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().constData(), name.toUtf8().constData());
-	r.x = v[0].toDouble();
-	r.y = v[1].toDouble();
-	r.z = v[2].toDouble();
+	QJsonArray v = json(name).toArray();
+	ASSERT_OR_RETURN(r, v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().constData(), name.toUtf8().constData());
+	r.x = jsonVectorElement(v[0]);
+	r.y = jsonVectorElement(v[1]);
+	r.z = jsonVectorElement(v[2]);
 	return r;
 }
 
@@ -202,11 +206,11 @@ Vector3i WzConfig::vector3i(const QString &name)
 	{
 		return r;
 	}
-	QStringList v = value(name).toStringList();
-	ASSERT(v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().constData(), name.toUtf8().constData());
-	r.x = v[0].toInt();
-	r.y = v[1].toInt();
-	r.z = v[2].toInt();
+	QJsonArray v = json(name).toArray();
+	ASSERT_OR_RETURN(r, v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().constData(), name.toUtf8().constData());
+	r.x = jsonVectorElement(v[0]);
+	r.y = jsonVectorElement(v[1]);
+	r.z = jsonVectorElement(v[2]);
 	return r;
 }
 
@@ -222,10 +226,10 @@ Vector2i WzConfig::vector2i(const QString &name)
 	{
 		return r;
 	}
-	QStringList v = value(name).toStringList();
-	ASSERT(v.size() == 2, "Bad list of %s", name.toUtf8().constData());
-	r.x = v[0].toInt();
-	r.y = v[1].toInt();
+	QJsonArray v = json(name).toArray();
+	ASSERT_OR_RETURN(r, v.size() == 2, "Bad list of %s", name.toUtf8().constData());
+	r.x = jsonVectorElement(v[0]);
+	r.y = jsonVectorElement(v[1]);
 	return r;
 }
 
@@ -240,14 +244,14 @@ bool WzConfig::beginGroup(const QString &prefix)
 	}
 	else
 	{
-		if (!contains(prefix)) // handled in this way for backwards compatibility
+		QJsonObject::const_iterator i = mObj.constFind(prefix);
+		if (i == mObj.constEnd()) // handled in this way for backwards compatibility
 		{
 			mObj = QJsonObject();
 			return false;
 		}
-		QJsonValue value = mObj.value(prefix);
-		ASSERT(value.isObject(), "%s: beginGroup() on non-object key \"%s\"", mFilename.toUtf8().constData(), prefix.toUtf8().constData());
-		mObj = value.toObject();
+		ASSERT(i.value().isObject(), "%s: beginGroup() on non-object key \"%s\"", mFilename.toUtf8().constData(), prefix.toUtf8().constData());
+		mObj = i.value().toObject();  // Shares the data with the parent, nothing is copied unless written to.
 	}
 	return true;
 }
@@ -281,13 +285,14 @@ void WzConfig::beginArray(const QString &name)
 	}
 	else
 	{
-		if (!contains(name)) // handled in this way for backwards compatibility
+		QJsonObject::const_iterator i = mObj.constFind(name);
+		if (i == mObj.constEnd()) // handled in this way for backwards compatibility
 		{
 			return;
 		}
-		QJsonValue value = mObj.value(name);
-		ASSERT(value.isArray(), "%s: beginArray() on non-array key \"%s\"", mFilename.toUtf8().constData(), name.toUtf8().constData());
-		mArray = value.toArray();
+		ASSERT(i.value().isArray(), "%s: beginArray() on non-array key \"%s\"", mFilename.toUtf8().constData(), name.toUtf8().constData());
+		mArray = i.value().toArray();
+		mArrayIndex = 0;
 		ASSERT(mArray.first().isObject(), "%s: beginArray() on non-object array \"%s\"", mFilename.toUtf8().constData(), name.toUtf8().constData());
 		mObj = mArray.first().toObject();
 	}
@@ -302,10 +307,11 @@ void WzConfig::nextArrayItem()
 	}
 	else
 	{
-		mArray.removeFirst();
-		if (!mArray.empty())
+		// Step through the array, rather than removing items from it, which would copy it out of the document.
+		++mArrayIndex;
+		if (mArrayIndex < mArray.size())
 		{
-			mObj = mArray.first().toObject();
+			mObj = mArray.at(mArrayIndex).toObject();
 		}
 		else
 		{
@@ -316,7 +322,11 @@ void WzConfig::nextArrayItem()
 
 int WzConfig::remainingArrayItems()
 {
-	return mArray.size();
+	if (mWarning == ReadAndWrite)
+	{
+		return mArray.size();
+	}
+	return std::max(mArray.size() - mArrayIndex, 0);
 }
 
 void WzConfig::endArray()
@@ -340,6 +350,7 @@ void WzConfig::endArray()
 		mObj = mObjStack.takeLast();
 	}
 	mArray = QJsonArray();
+	mArrayIndex = 0;
 }
 
 void WzConfig::setValue(const QString &key, const QVariant &value)
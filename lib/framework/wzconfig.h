@@ -41,6 +41,7 @@ public:
 private:
 	QJsonObject mObj;
 	QJsonArray mArray;
+	int mArrayIndex;  ///< The item of mArray in mObj, when reading.
 	QString mName;
 	QList<QJsonObject> mObjStack;
 	QStringList mObjNameStack;
@@ -0,0 +1,264 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A pool of worker threads, see wzworkers.h.
+ */
+
+#include <thread>
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+
+#include "wzworkers.h"
+
+#include <deque>
+#include <vector>
+
+enum WORK_STATE
+{
+	WORK_QUEUED,
+	WORK_RUNNING,
+	WORK_DONE
+};
+
+struct WzWorkBatch
+{
+	~WzWorkBatch()
+	{
+		wzSemaphoreDestroy(doneSemaphore);
+	}
+
+	std::function<void (unsigned)> job;
+	// Protected by wzWorkersMutex.
+	std::vector<uint8_t> state;         ///< WORK_STATE of each job.
+	std::vector<uint8_t> thread;        ///< Which thread ran each job, once running.
+	unsigned next;                      ///< No job before this one is still queued.
+	WZ_SEMAPHORE *doneSemaphore;        ///< Posted when a job finishes, if waiting.
+	bool waiting;
+};
+
+// Protected by wzWorkersMutex.
+static WZ_MUTEX *wzWorkersMutex = nullptr;
+static WZ_SEMAPHORE *wzWorkersSemaphore = nullptr;  ///< Posted once per job queued, and once per thread to quit.
+static std::vector<WZ_THREAD *> wzWorkersThreads;
+static std::deque<std::shared_ptr<WzWorkBatch>> wzWorkersBatches;  ///< Batches which may still have queued jobs.
+static bool wzWorkersQuit = false;
+static bool wzWorkersStarted = false;
+
+/// Takes the next queued job of the batch, if any. Must hold wzWorkersMutex.
+static bool takeJob(WzWorkBatch &batch, unsigned &index)
+{
+	while (batch.next < batch.state.size() && batch.state[batch.next] != WORK_QUEUED)
+	{
+		++batch.next;
+	}
+	if (batch.next == batch.state.size())
+	{
+		return false;
+	}
+	index = batch.next++;
+	batch.state[index] = WORK_RUNNING;
+	return true;
+}
+
+/// Runs a job taken with takeJob(). Must hold wzWorkersMutex, which is released while the job runs.
+static void runJob(WzWorkBatch &batch, unsigned index, unsigned thread)
+{
+	batch.thread[index] = thread;
+	wzMutexUnlock(wzWorkersMutex);
+	batch.job(index);
+	wzMutexLock(wzWorkersMutex);
+	batch.state[index] = WORK_DONE;
+	if (batch.waiting)
+	{
+		batch.waiting = false;
+		wzSemaphorePost(batch.doneSemaphore);
+	}
+}
+
+static int wzWorkersThreadFunc(void *data)
+{
+	unsigned thread = (uintptr_t)data;
+
+	wzMutexLock(wzWorkersMutex);
+	while (true)
+	{
+		wzMutexUnlock(wzWorkersMutex);
+		wzSemaphoreWait(wzWorkersSemaphore);  // Go to sleep until needed.
+		wzMutexLock(wzWorkersMutex);
+
+		while (!wzWorkersBatches.empty())
+		{
+			std::shared_ptr<WzWorkBatch> batch = wzWorkersBatches.front();  // Keep the batch alive while running its job.
+			unsigned index;
+			if (takeJob(*batch, index))
+			{
+				runJob(*batch, index, thread);
+				break;
+			}
+			wzWorkersBatches.pop_front();  // The caller took all the jobs left.
+		}
+
+		if (wzWorkersBatches.empty() && wzWorkersQuit)
+		{
+			break;
+		}
+	}
+	wzMutexUnlock(wzWorkersMutex);
+
+	return 0;
+}
+
+static void wzWorkersInit()
+{
+	if (wzWorkersStarted)
+	{
+		return;
+	}
+	wzWorkersStarted = true;
+
+	int count = 0;
+#if !defined(WZ_CC_MINGW)
+	count = (int)std::thread::hardware_concurrency() - 1;  // The caller also does some of the work.
+#endif
+	wzWorkersQuit = false;
+	wzWorkersMutex = wzMutexCreate();
+	wzWorkersSemaphore = wzSemaphoreCreate(0);
+	for (int i = 0; i < count; ++i)
+	{
+		WZ_THREAD *thread = wzThreadCreate(wzWorkersThreadFunc, (void *)(uintptr_t)(i + 1));
+		wzThreadStart(thread);
+		wzWorkersThreads.push_back(thread);
+	}
+	debug(LOG_WZ, "Started %d worker threads", count);
+}
+
+std::shared_ptr<WzWorkBatch> wzWorkersStart(unsigned count, std::function<void (unsigned index)> job)
+{
+	wzWorkersInit();
+
+	std::shared_ptr<WzWorkBatch> batch = std::make_shared<WzWorkBatch>();
+	batch->job = std::move(job);
+	batch->state.assign(count, WORK_QUEUED);
+	batch->thread.assign(count, 0);
+	batch->next = 0;
+	batch->doneSemaphore = wzSemaphoreCreate(0);
+	batch->waiting = false;
+
+	if (wzWorkersThreads.empty() || count == 0)
+	{
+		return batch;  // The caller runs every job, when waiting for it.
+	}
+
+	wzMutexLock(wzWorkersMutex);
+	wzWorkersBatches.push_back(batch);
+	wzMutexUnlock(wzWorkersMutex);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		wzSemaphorePost(wzWorkersSemaphore);
+	}
+	return batch;
+}
+
+void wzWorkersFinish(WzWorkBatch &batch, unsigned index)
+{
+	ASSERT_OR_RETURN(, index < batch.state.size(), "Job %u out of range", index);
+
+	wzMutexLock(wzWorkersMutex);
+	if (batch.state[index] == WORK_QUEUED)
+	{
+		batch.state[index] = WORK_RUNNING;
+		runJob(batch, index, 0);
+	}
+	while (batch.state[index] != WORK_DONE)
+	{
+		batch.waiting = true;
+		wzMutexUnlock(wzWorkersMutex);
+		wzSemaphoreWait(batch.doneSemaphore);
+		wzMutexLock(wzWorkersMutex);
+	}
+	wzMutexUnlock(wzWorkersMutex);
+}
+
+void wzWorkersFinishAll(WzWorkBatch &batch)
+{
+	wzMutexLock(wzWorkersMutex);
+	unsigned index;
+	while (takeJob(batch, index))
+	{
+		runJob(batch, index, 0);
+	}
+	for (index = 0; index < batch.state.size(); ++index)
+	{
+		while (batch.state[index] != WORK_DONE)
+		{
+			batch.waiting = true;
+			wzMutexUnlock(wzWorkersMutex);
+			wzSemaphoreWait(batch.doneSemaphore);
+			wzMutexLock(wzWorkersMutex);
+		}
+	}
+	wzMutexUnlock(wzWorkersMutex);
+}
+
+unsigned wzWorkersThreadOf(WzWorkBatch const &batch, unsigned index)
+{
+	ASSERT_OR_RETURN(0, index < batch.thread.size(), "Job %u out of range", index);
+	return batch.thread[index];
+}
+
+void wzWorkersParallelFor(unsigned count, std::function<void (unsigned index)> job)
+{
+	std::shared_ptr<WzWorkBatch> batch = wzWorkersStart(count, std::move(job));
+	wzWorkersFinishAll(*batch);
+}
+
+unsigned wzWorkersCount()
+{
+	wzWorkersInit();
+	return wzWorkersThreads.size();
+}
+
+void wzWorkersShutdown()
+{
+	if (!wzWorkersStarted)
+	{
+		return;
+	}
+
+	wzMutexLock(wzWorkersMutex);
+	wzWorkersQuit = true;
+	wzMutexUnlock(wzWorkersMutex);
+	for (size_t i = 0; i < wzWorkersThreads.size(); ++i)
+	{
+		wzSemaphorePost(wzWorkersSemaphore);  // Wake up threads.
+	}
+	for (WZ_THREAD *thread : wzWorkersThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	wzWorkersThreads.clear();
+	wzWorkersBatches.clear();
+
+	wzMutexDestroy(wzWorkersMutex);
+	wzWorkersMutex = nullptr;
+	wzSemaphoreDestroy(wzWorkersSemaphore);
+	wzWorkersSemaphore = nullptr;
+	wzWorkersStarted = false;
+}
@@ -0,0 +1,64 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A pool of worker threads, for loading and decoding files in parallel.
+ *
+ *  A batch is a numbered list of jobs, job(0) to job(count - 1), which the workers start in order. The thread which
+ *  started the batch waits for a job with wzWorkersFinish(), which runs the job itself if no worker has started it yet,
+ *  so a batch never takes longer than running it on one thread would, even if the workers are busy with another batch.
+ *
+ *  There is one worker less than the number of cores, since the calling thread helps. Without std::thread (MinGW)
+ *  there are no workers, and every job is run by the thread waiting for it.
+ *
+ *  Batches are only started and waited for by the main thread. Jobs must not touch anything the main thread uses
+ *  before it has waited for them.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_WZWORKERS_H__
+#define __INCLUDED_LIB_FRAMEWORK_WZWORKERS_H__
+
+#include <functional>
+#include <memory>
+
+#include "lib/framework/types.h"
+
+struct WzWorkBatch;
+
+/// Queues job(0) to job(count - 1) for the workers.
+std::shared_ptr<WzWorkBatch> wzWorkersStart(unsigned count, std::function<void (unsigned index)> job);
+
+/// Waits for job(index) of the batch to finish, or runs it now, if no worker has started it.
+void wzWorkersFinish(WzWorkBatch &batch, unsigned index);
+
+/// Runs any jobs of the batch no worker has started, and waits for the rest.
+void wzWorkersFinishAll(WzWorkBatch &batch);
+
+/// Which thread ran job(index) of a finished batch, 0 if the caller, else 1 to wzWorkersCount().
+unsigned wzWorkersThreadOf(WzWorkBatch const &batch, unsigned index);
+
+/// Runs job(0) to job(count - 1), shared between the caller and the workers, and returns when all have finished.
+void wzWorkersParallelFor(unsigned count, std::function<void (unsigned index)> job);
+
+/// Number of worker threads, not counting the caller. Starts the workers, if not already started.
+unsigned wzWorkersCount();
+
+/// Finishes all started batches, and stops the workers.
+void wzWorkersShutdown();
+
+#endif // __INCLUDED_LIB_FRAMEWORK_WZWORKERS_H__
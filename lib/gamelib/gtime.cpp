@@ -31,6 +31,7 @@
 #include "gtime.h"
 #include "src/multiplay.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 
 
 #include <time.h>
@@ -52,6 +53,9 @@ static uint32_t prevRealTime;
   **/
 static UDWORD	stopCount;
 
+/// If true, the game time ticks as fast as the game loop allows, instead of following the real time.
+static bool unthrottled = false;
+
 static uint32_t gameQueueTime[MAX_PLAYERS];
 static uint32_t gameQueueCheckTime[MAX_PLAYERS];
 static uint32_t gameQueueCheckCrc[MAX_PLAYERS];
@@ -175,6 +179,13 @@ void gameTimeUpdate(bool mayUpdate)
 
 	uint32_t newGraphicsTime = graphicsTime + newDeltaGraphicsTime;
 
+	if (unthrottled)
+	{
+		// Catch up with the game time, and tick as soon as the graphics time has caught up.
+		newGraphicsTime = std::max<uint32_t>(newGraphicsTime, gameTime + (graphicsTime == gameTime ? 1 : 0));
+		newDeltaGraphicsTime = newGraphicsTime - graphicsTime;
+	}
+
 	if (newGraphicsTime > gameTime && !mayUpdate)
 	{
 		newGraphicsTime = gameTime;
@@ -276,6 +287,11 @@ Rational gameTimeGetMod()
 	return modifier;
 }
 
+void gameTimeSetUnthrottled(bool enable)
+{
+	unthrottled = enable;
+}
+
 bool gameTimeIsStopped(void)
 {
 	return stopCount != 0;
@@ -371,7 +387,7 @@ void sendPlayerGameTime()
 
 		NETbeginEncode(NETgameQueue(player), GAME_GAME_TIME);
 		NETuint32_t(&latencyTicks);
-		NETuint32_t(&checkTime);
+		NETdeltaUint32(&checkTime, 0);  // Usually GAME_TICKS_PER_UPDATE more than last time.
 		NETuint16_t(&checkCrc);
 		NETuint16_t(&wantedLatency);
 		NETend();
@@ -386,7 +402,7 @@ void recvPlayerGameTime(NETQUEUE queue)
 
 	NETbeginDecode(queue, GAME_GAME_TIME);
 	NETuint32_t(&latencyTicks);
-	NETuint32_t(&checkTime);
+	NETdeltaUint32(&checkTime, 0);
 	NETuint16_t(&checkCrc);
 	NETuint16_t(&wantedLatencies[queue.index]);
 	NETend();
@@ -397,7 +413,9 @@ void recvPlayerGameTime(NETQUEUE queue)
 
 	gameQueueCheckTime[queue.index] = checkTime;
 	gameQueueCheckCrc[queue.index] = checkCrc;
-	if (!checkDebugSync(checkTime, checkCrc))
+	bool crcMatched = checkDebugSync(checkTime, checkCrc);
+	NETreplayCheckpoint(crcMatched);
+	if (!crcMatched)
 	{
 		crcError = true;
 		if (NetPlay.players[queue.index].allocated)
@@ -99,6 +99,9 @@ void gameTimeSetMod(Rational mod);
 /** Get the current time modifier. */
 Rational gameTimeGetMod();
 
+/** Let the game time run as fast as possible, ignoring the real time and the time modifier. Still waits for other players. */
+void gameTimeSetUnthrottled(bool enable);
+
 /**
  * Returns the game time, modulo the time period, scaled to 0..requiredRange.
  * For instance getModularScaledGameTime(4096,256) will return a number that cycles through the values
@@ -21,6 +21,7 @@
 
 #include "lib/framework/frameresource.h"
 #include "lib/framework/file.h"
+#include "lib/framework/wzworkers.h"
 
 #include "bitimage.h"
 #include "tex.h"
@@ -189,6 +190,7 @@ IMAGEFILE *iV_LoadImageFile(const char *fileName)
 	imageFile->imageNames.resize(numImages);
 	ImageMerge pageLayout;
 	pageLayout.images.resize(numImages);
+	std::vector<std::string> spriteNames(numImages);
 	ptr = pFileData;
 	numImages = 0;
 	while (ptr < pFileData + pFileSize)
@@ -207,26 +209,32 @@ IMAGEFILE *iV_LoadImageFile(const char *fileName)
 		}
 		imageFile->imageNames[numImages].first = tmpName;
 		imageFile->imageNames[numImages].second = numImages;
-		std::string spriteName = imageDir + tmpName;
+		spriteNames[numImages] = imageDir + tmpName;
+		numImages++;
+		ptr += temp;
+		while (ptr < pFileData + pFileSize && *ptr++ != '\n') {} // skip rest of line
+	}
+	free(pFileData);
 
-		ImageMergeRectangle *imageRect = &pageLayout.images[numImages];
-		imageRect->index = numImages;
-		imageRect->data = new iV_Image;
-		if (!iV_loadImage_PNG(spriteName.c_str(), imageRect->data))
+	// Decode the images on the worker threads, since there are hundreds of them in intfac.img.
+	std::vector<char> loaded(numImages);
+	wzWorkersParallelFor(numImages, [&](unsigned i) {
+		ImageMergeRectangle *imageRect = &pageLayout.images[i];
+		imageRect->index = i;
+		imageRect->data = new iV_Image();
+		loaded[i] = iV_loadImage_PNG(spriteNames[i].c_str(), imageRect->data);
+		imageRect->siz = Vector2i(imageRect->data->width, imageRect->data->height);
+	});
+	for (int i = 0; i < numImages; ++i)
+	{
+		if (!loaded[i])
 		{
-			debug(LOG_ERROR, "Failed to find image \"%s\" listed in \"%s\".", spriteName.c_str(), fileName);
+			debug(LOG_ERROR, "Failed to find image \"%s\" listed in \"%s\".", spriteNames[i].c_str(), fileName);
 			delete imageFile;
-			free(pFileData);
 			return nullptr;
 		}
-		imageRect->siz = Vector2i(imageRect->data->width, imageRect->data->height);
-		numImages++;
-		ptr += temp;
-		while (ptr < pFileData + pFileSize && *ptr++ != '\n') {} // skip rest of line
-
-		images.insert(tmpName, ImageDef);
+		images.insert(QString::fromUtf8(imageFile->imageNames[i].first.c_str()), &imageFile->imageDefs[i]);
 	}
-	free(pFileData);
 
 	std::sort(imageFile->imageNames.begin(), imageFile->imageNames.end());
 
@@ -39,6 +39,7 @@
 #include "ivisdef.h" // for imd structures
 #include "imd.h" // for imd structures
 #include "tex.h" // texture page loading
+#include "screen.h"
 
 // Scale animation numbers from int to float
 #define INT_SCALE       1000
@@ -101,7 +102,10 @@ static void iV_IMDRelease(iIMDShape *s)
 			free(s->shadowEdgeList);
 			s->shadowEdgeList = nullptr;
 		}
-		glDeleteBuffers(VBO_COUNT, s->buffers);
+		if (!wz_headless)
+		{
+			glDeleteBuffers(VBO_COUNT, s->buffers);
+		}
 		// shader deleted later, if any
 		d = s->next;
 		delete s;
@@ -799,7 +803,6 @@ static iIMDShape *_imd_load_level(const QString &filename, const char **ppFileDa
 	}
 
 	// FINALLY, massage the data into what can stream directly to OpenGL
-	glGenBuffers(VBO_COUNT, s->buffers);
 	vertexCount = 0;
 	for (int k = 0; k < MAX(1, s->numFrames); k++)
 	{
@@ -814,15 +817,19 @@ static iIMDShape *_imd_load_level(const QString &filename, const char **ppFileDa
 			indices.append(addVertex(s, 2, pPolys, k));
 		}
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_VERTEX]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.constData(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_NORMAL]);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(GLfloat), normals.constData(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s->buffers[VBO_INDEX]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.constData(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_TEXCOORD]);
-	glBufferData(GL_ARRAY_BUFFER, texcoords.size() * sizeof(GLfloat), texcoords.constData(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+	if (!wz_headless)
+	{
+		glGenBuffers(VBO_COUNT, s->buffers);
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_VERTEX]);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.constData(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_NORMAL]);
+		glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(GLfloat), normals.constData(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s->buffers[VBO_INDEX]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.constData(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffers[VBO_TEXCOORD]);
+		glBufferData(GL_ARRAY_BUFFER, texcoords.size() * sizeof(GLfloat), texcoords.constData(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+	}
 
 	indices.resize(0);
 	vertices.resize(0);
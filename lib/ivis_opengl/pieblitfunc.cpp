@@ -73,12 +73,20 @@ static Vector2i makePieImage(IMAGEFILE *imageFile, unsigned id, PIERECT *dest =
 
 GFX::GFX(GFXTYPE type, GLenum drawType, int coordsPerVertex) : mType(type), mdrawType(drawType), mCoordsPerVertex(coordsPerVertex), mSize(0)
 {
+	if (wz_headless)
+	{
+		return;  // No GPU resources, and all other member functions do nothing.
+	}
 	glGenBuffers(VBO_MINIMAL, mBuffers);
 }
 
 void GFX::loadTexture(const char *filename, GLenum filter)
 {
 	ASSERT(mType == GFX_TEXTURE, "Wrong GFX type");
+	if (wz_headless)
+	{
+		return;
+	}
 	const char *extension = strrchr(filename, '.'); // determine the filetype
 	iV_Image image;
 	if (!extension || strcmp(extension, ".png") != 0)
@@ -96,6 +104,13 @@ void GFX::loadTexture(const char *filename, GLenum filter)
 void GFX::makeTexture(int width, int height, GLenum filter, const gfx_api::pixel_format& format, const GLvoid *image)
 {
 	ASSERT(mType == GFX_TEXTURE, "Wrong GFX type");
+	mWidth = width;
+	mHeight = height;
+	mFormat = format;
+	if (wz_headless)
+	{
+		return;
+	}
 	pie_SetTexturePage(TEXPAGE_EXTERN);
 	if (mTexture)
 		delete mTexture;
@@ -106,14 +121,15 @@ void GFX::makeTexture(int width, int height, GLenum filter, const gfx_api::pixel
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	mWidth = width;
-	mHeight = height;
-	mFormat = format;
 }
 
 void GFX::updateTexture(const void *image, int width, int height)
 {
 	ASSERT(mType == GFX_TEXTURE, "Wrong GFX type");
+	if (wz_headless)
+	{
+		return;
+	}
 	if (width == -1)
 	{
 		width = mWidth;
@@ -128,6 +144,10 @@ void GFX::updateTexture(const void *image, int width, int height)
 
 void GFX::buffers(int vertices, const GLvoid *vertBuf, const GLvoid *auxBuf)
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	glBindBuffer(GL_ARRAY_BUFFER, mBuffers[VBO_VERTEX]);
 	glBufferData(GL_ARRAY_BUFFER, vertices * mCoordsPerVertex * sizeof(GLfloat), vertBuf, GL_STATIC_DRAW);
 	if (mType == GFX_TEXTURE)
@@ -151,6 +171,10 @@ void GFX::buffers(int vertices, const GLvoid *vertBuf, const GLvoid *auxBuf)
 
 void GFX::draw(const glm::mat4 &modelViewProjectionMatrix)
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	if (mType == GFX_TEXTURE)
 	{
 		pie_SetTexturePage(TEXPAGE_EXTERN);
@@ -187,6 +211,10 @@ void GFX::draw(const glm::mat4 &modelViewProjectionMatrix)
 
 GFX::~GFX()
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	glDeleteBuffers(VBO_MINIMAL, mBuffers);
 	if (mTexture)
 		delete mTexture;
@@ -32,6 +32,7 @@
 #include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/pieclip.h"
+#include "screen.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <array>
 
@@ -189,7 +190,10 @@ void pie_Skybox_Init()
 void pie_Skybox_Texture(const char *filename)
 {
 	skyboxGfx->loadTexture(filename);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	if (!wz_headless)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	}
 }
 
 void pie_Skybox_Shutdown()
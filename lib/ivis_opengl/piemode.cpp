@@ -94,6 +94,11 @@ void pie_ScreenFlip(int clearMode)
 {
 	GLbitfield clearFlags = 0;
 
+	if (wz_headless)
+	{
+		return;
+	}
+
 	screenDoDumpToDiskIfRequired();
 	wzScreenFlip();
 	wzPerfFrame();
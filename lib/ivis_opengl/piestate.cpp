@@ -221,6 +221,11 @@ SHADER_MODE pie_LoadShader(const char *programName, const char *vertexPath, cons
 	bool success = true; // Assume overall success
 	char *buffer[2];
 
+	if (wz_headless)
+	{
+		return SHADER_NONE;
+	}
+
 	program.program = glCreateProgram();
 	glBindAttribLocation(program.program, 0, "vertex");
 	glBindAttribLocation(program.program, 1, "vertexTexCoord");
@@ -336,6 +341,11 @@ bool pie_LoadShaders()
 	pie_internal::SHADER_PROGRAM program;
 	int result;
 
+	if (wz_headless)
+	{
+		return true;  // Nothing is drawn.
+	}
+
 	// Load some basic shaders
 	memset(&program, 0, sizeof(program));
 	pie_internal::shaderProgram.push_back(program);
@@ -556,6 +566,10 @@ pie_internal::SHADER_PROGRAM &pie_ActivateShaderDeprecated(SHADER_MODE shaderMod
 
 void pie_SetDepthBufferStatus(DEPTH_MODE depthMode)
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	switch (depthMode)
 	{
 	case DEPTH_CMP_LEQ_WRT_ON:
@@ -580,6 +594,10 @@ void pie_SetDepthBufferStatus(DEPTH_MODE depthMode)
 /// Negative values are closer to the screen
 void pie_SetDepthOffset(float offset)
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	if (offset == 0.0f)
 	{
 		glDisable(GL_POLYGON_OFFSET_FILL);
@@ -618,7 +636,7 @@ void pie_SetFogStatus(bool val)
 void pie_SetTexturePage(SDWORD num)
 {
 	// Only bind textures when they're not bound already
-	if (num != rendStates.texPage)
+	if (num != rendStates.texPage && !wz_headless)
 	{
 		switch (num)
 		{
@@ -636,7 +654,7 @@ void pie_SetTexturePage(SDWORD num)
 
 void pie_SetRendMode(REND_MODE rendMode)
 {
-	if (rendMode != rendStates.rendMode)
+	if (rendMode != rendStates.rendMode && !wz_headless)
 	{
 		rendStates.rendMode = rendMode;
 		switch (rendMode)
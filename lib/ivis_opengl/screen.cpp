@@ -56,6 +56,9 @@
 /* global used to indicate preferred internal OpenGL format */
 bool wz_texture_compression = 0;
 
+/* global used to run without a window or OpenGL context */
+bool wz_headless = false;
+
 // for compatibility with older versions of GLEW
 #ifndef GLEW_ARB_timer_query
 #define GLEW_ARB_timer_query false
@@ -147,6 +150,14 @@ bool screenInitialise()
 	GLint glMaxTUs;
 	GLenum err;
 
+	if (wz_headless)
+	{
+		// There is no OpenGL context, so only create the objects the rest of the game expects to exist.
+		pie_Skybox_Init();
+		backdropGfx = new GFX(GFX_TEXTURE, GL_TRIANGLE_STRIP, 2);
+		return true;
+	}
+
 	err = glewInit();
 	if (GLEW_OK != err)
 	{
@@ -423,7 +434,10 @@ void screenShutDown()
 
 	delete backdropGfx;
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	if (!wz_headless)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
 }
 
 /// Display a random backdrop from files in dirname starting with basename.
@@ -100,6 +100,14 @@ int pie_AddTexPage(iV_Image *s, const char *filename, bool gameTexture, int page
 	}
 	debug(LOG_TEXTURE, "%s page=%d", filename, page);
 
+	if (wz_headless)
+	{
+		// Nothing is drawn, so only the page name is needed.
+		free(s->bmp);
+		s->bmp = nullptr;
+		return page;
+	}
+
 	if (gameTexture) // this is a game texture, use texture compression
 	{
 		gfx_api::pixel_format format{};
@@ -30,6 +30,7 @@
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/piepalette.h"
 #include "lib/ivis_opengl/textdraw.h"
+#include "lib/ivis_opengl/screen.h"
 #include "lib/ivis_opengl/bitimage.h"
 #include "src/multiplay.h"
 #include <algorithm>
@@ -847,6 +848,11 @@ void WzText::drawAndCacheText(const std::string &string, iV_fonts fontID)
 		texture = nullptr;
 	}
 
+	if (wz_headless)
+	{
+		return;  // Only the metrics are needed.
+	}
+
 	if (dimensions.x > 0 && dimensions.y > 0)
 	{
 		pie_SetTexturePage(TEXPAGE_EXTERN);
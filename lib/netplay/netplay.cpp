@@ -28,6 +28,7 @@
 #include "lib/framework/string_ext.h"
 #include "lib/framework/crc.h"
 #include "lib/framework/file.h"
+#include "lib/framework/spscqueue.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/exceptionhandler/dumpinfo.h"
 #include "src/console.h"
@@ -40,10 +41,12 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
 
 #include "netplay.h"
 #include "netlog.h"
 #include "netsocket.h"
+#include "netreplay.h"
 
 #include <miniupnpc/miniwget.h>
 #include <miniupnpc/miniupnpc.h>
@@ -171,6 +174,42 @@ static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}};
 static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}};
 static int nStatsLastUpdateTime = 0;
 
+#define NET_LATENCY_BUCKETS 24
+
+/// How long messages read by the socket thread waited before the game thread took them. counts[0] is the number of messages
+/// which waited less than 1 us, and counts[n] the number which waited at least 2^(n - 1) us but less than 2^n us, except that
+/// the last bucket also counts anything longer.
+struct NetLatencyHistogram
+{
+	unsigned counts[NET_LATENCY_BUCKETS];
+};
+
+static NetLatencyHistogram nLatency              = {{0}};
+static NetLatencyHistogram nLatencyLastSec       = {{0}};
+static NetLatencyHistogram nLatencySecondLastSec = {{0}};
+static const NetLatencyHistogram nZeroLatency    = {{0}};
+
+/// A message split from the data read by the socket thread, waiting for the game thread.
+struct NetReceivedMessage
+{
+	NetMessage message;
+	std::chrono::steady_clock::time_point received;     ///< When the socket thread read the end of the message.
+};
+
+/// Reading from the socket of a player, on the socket thread. The socket thread splits the data into messages, and the game
+/// thread takes them in NETrecvNet().
+struct NetConnectionReader
+{
+	NetMessageSplitter splitter;                        ///< Only used by the socket thread, while the socket is being read.
+	SpscQueue<NetReceivedMessage> messages;
+	std::atomic<bool> disconnected{false};              ///< Set after pushing the last message.
+	std::atomic<unsigned> rawBytes{0};                  ///< Statistics not yet added to nStats.
+	std::atomic<unsigned> uncompressedBytes{0};
+	std::atomic<unsigned> packets{0};
+};
+
+static NetConnectionReader netReaders[MAX_CONNECTED_PLAYERS];
+
 unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -230,69 +269,106 @@ void NETresetGamePassword()
 
 // *********** Socket with buffer that read NETMSGs ******************
 
-static size_t NET_fillBuffer(Socket **pSocket, SocketSet *socket_set, uint8_t *bufstart, int bufsize)
+/// Called on the socket thread, with data from a socket given to NETstartReading().
+static void NETreaderReceived(void *context, uint8_t const *data, size_t size, size_t rawSize, bool disconnected)
 {
-	Socket *socket = *pSocket;
-	ssize_t size;
+	NetConnectionReader &reader = *static_cast<NetConnectionReader *>(context);
 
-	if (!socketReadReady(socket))
+	if (disconnected)
 	{
-		return 0;
+		reader.disconnected.store(true, std::memory_order_release);
+		return;
 	}
 
-	size_t rawBytes;
-	size = readNoInt(socket, bufstart, bufsize, &rawBytes);
+	reader.rawBytes.fetch_add(rawSize, std::memory_order_relaxed);
+	reader.uncompressedBytes.fetch_add(size, std::memory_order_relaxed);
+	reader.packets.fetch_add(1, std::memory_order_relaxed);
 
-	if ((size != 0 || !socketReadDisconnected(socket)) && size != SOCKET_ERROR)
+	reader.splitter.writeRawData(data, size);
+	NetReceivedMessage received;
+	received.received = std::chrono::steady_clock::now();
+	while (reader.splitter.readMessage(received.message))
 	{
-		nStats.rawBytes.received          += rawBytes;
-		nStats.uncompressedBytes.received += size;
-		nStats.packets.received           += 1;
+		reader.messages.push(std::move(received));
+	}
+}
+
+/// Makes the socket thread read the socket of a player. Data already read, but not yet forming a whole message, is moved
+/// from the queue of the player to the reader. Any previous socket of the player must already have been closed.
+static void NETstartReading(unsigned player, Socket *socket)
+{
+	NetConnectionReader &reader = netReaders[player];
 
-		return size;
+	// Forget anything left from the previous socket.
+	NetReceivedMessage received;
+	while (reader.messages.pop(received))
+	{}
+	reader.splitter.clear();
+	reader.disconnected.store(false, std::memory_order_relaxed);
+	reader.rawBytes.store(0, std::memory_order_relaxed);
+	reader.uncompressedBytes.store(0, std::memory_order_relaxed);
+	reader.packets.store(0, std::memory_order_relaxed);
+
+	NETtakeIncompleteRawData(NETnetQueue(player), reader.splitter);
+	socketReadInThread(socket, NETreaderReceived, &reader);
+}
+
+static void NETrecordLatency(std::chrono::steady_clock::duration wait)
+{
+	uint64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+	unsigned bucket = 0;
+	while (microseconds != 0 && bucket < NET_LATENCY_BUCKETS - 1)
+	{
+		microseconds >>= 1;
+		++bucket;
 	}
-	else
+	++nLatency.counts[bucket];
+}
+
+/// Takes the messages the socket thread read from the socket of a player. Returns false if the connection was lost, in
+/// which case the socket has been closed, and *pSocket set to NULL.
+static bool NETtakeReadMessages(unsigned player, Socket **pSocket)
+{
+	NetConnectionReader &reader = netReaders[player];
+	Socket *socket = *pSocket;
+
+	nStats.rawBytes.received          += reader.rawBytes.exchange(0, std::memory_order_relaxed);
+	nStats.uncompressedBytes.received += reader.uncompressedBytes.exchange(0, std::memory_order_relaxed);
+	nStats.packets.received           += reader.packets.exchange(0, std::memory_order_relaxed);
+
+	bool disconnected = reader.disconnected.load(std::memory_order_acquire);  // Before popping, so as to get all the messages before the disconnect.
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	NetReceivedMessage received;
+	while (reader.messages.pop(received))
 	{
-		if (size == 0)
-		{
-			debug(LOG_NET, "Connection closed from the other side");
-			NETlogEntry("Connection closed from the other side..", SYNC_FLAG, selectedPlayer);
-		}
-		else
-		{
-			debug(LOG_NET, "%s tcp_socket %p is now invalid", strSockError(getSockErr()), socket);
-		}
+		NETrecordLatency(now - received.received);
+		NETinsertMessageFromNet(NETnetQueue(player), std::move(received.message));
+	}
 
-		// an error occurred, or the remote host has closed the connection.
-		if (socket_set != nullptr)
-		{
-			SocketSet_DelSocket(socket_set, socket);
-		}
+	if (!disconnected)
+	{
+		return true;
+	}
 
-		ASSERT(size <= bufsize, "Socket buffer is too small!");
+	debug(LOG_NET, "Connection to player %u lost, socket %p", player, socket);
+	NETlogEntry("Connection closed or broken..", SYNC_FLAG, selectedPlayer);
 
-		if (size > bufsize)
-		{
-			debug(LOG_ERROR, "Fatal connection error: buffer size of (%d) was too small, current byte count was %ld", bufsize, (long)size);
-			NETlogEntry("Fatal connection error: buffer size was too small!", SYNC_FLAG, selectedPlayer);
-		}
-		if (bsocket == socket)
-		{
-			debug(LOG_NET, "Host connection was lost!");
-			NETlogEntry("Host connection was lost!", SYNC_FLAG, selectedPlayer);
-			bsocket = nullptr;
-			//Game is pretty much over --should just end everything when HOST dies.
-			NetPlay.isHostAlive = false;
-			ingame.localJoiningInProgress = false;
-			setLobbyError(ERROR_HOSTDROPPED);
-			NETclose();
-			return 0;
-		}
-		socketClose(socket);
-		*pSocket = nullptr;
+	if (bsocket == socket)
+	{
+		debug(LOG_NET, "Host connection was lost!");
+		NETlogEntry("Host connection was lost!", SYNC_FLAG, selectedPlayer);
+		bsocket = nullptr;
+		//Game is pretty much over --should just end everything when HOST dies.
+		NetPlay.isHostAlive = false;
+		ingame.localJoiningInProgress = false;
+		setLobbyError(ERROR_HOSTDROPPED);
+		NETclose();
+		return false;
 	}
+	socketClose(socket);
+	*pSocket = nullptr;
 
-	return 0;
+	return false;
 }
 
 static int playersPerTeam()
@@ -1151,6 +1227,9 @@ int NETshutdown()
 	nStats = nZeroStats;
 	nStatsLastSec = nZeroStats;
 	nStatsSecondLastSec = nZeroStats;
+	nLatency = nZeroLatency;
+	nLatencyLastSec = nZeroLatency;
+	nLatencySecondLastSec = nZeroLatency;
 
 	return 0;
 }
@@ -1236,10 +1315,63 @@ int NETclose()
 // ////////////////////////////////////////////////////////////////////////
 // Send and Recv functions
 
+/// Returns the upper bound in microseconds of the bucket reached by the given percentage of the messages counted in histogram since earlier, or 0 if there are none.
+static unsigned NETlatencyPercentile(NetLatencyHistogram const &histogram, NetLatencyHistogram const &earlier, unsigned percent)
+{
+	uint64_t total = 0;
+	for (unsigned n = 0; n < NET_LATENCY_BUCKETS; ++n)
+	{
+		total += histogram.counts[n] - earlier.counts[n];
+	}
+	if (total == 0)
+	{
+		return 0;
+	}
+
+	uint64_t wanted = (total * percent + 99) / 100;
+	uint64_t seen = 0;
+	for (unsigned n = 0; n < NET_LATENCY_BUCKETS - 1; ++n)
+	{
+		seen += histogram.counts[n] - earlier.counts[n];
+		if (seen >= wanted)
+		{
+			return 1u << n;
+		}
+	}
+	return 1u << (NET_LATENCY_BUCKETS - 1);
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // return bytes of data sent recently.
 unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 {
+	int time = wzGetTicks();
+	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
+	{
+		nStatsLastUpdateTime = time;
+		nStatsSecondLastSec = nStatsLastSec;
+		nStatsLastSec = nStats;
+		nLatencySecondLastSec = nLatencyLastSec;
+		nLatencyLastSec = nLatency;
+	}
+
+	unsigned percent;
+	switch (type)
+	{
+	case NetStatisticLatencyMedian:     percent = 50;  break;
+	case NetStatisticLatency99th:       percent = 99;  break;
+	case NetStatisticLatencyMax:        percent = 100; break;
+	default:                            percent = 0;   break;
+	}
+	if (percent != 0)
+	{
+		if (isTotal)
+		{
+			return NETlatencyPercentile(nLatency, nZeroLatency, percent);
+		}
+		return NETlatencyPercentile(nLatencyLastSec, nLatencySecondLastSec, percent);
+	}
+
 	unsigned Statistic::*statisticType = sent ? &Statistic::sent : &Statistic::received;
 	Statistic NETSTATS::*statsType;
 	switch (type)
@@ -1250,14 +1382,6 @@ unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 	default: ASSERT(false, " "); return 0;
 	}
 
-	int time = wzGetTicks();
-	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
-	{
-		nStatsLastUpdateTime = time;
-		nStatsSecondLastSec = nStatsLastSec;
-		nStatsLastSec = nStats;
-	}
-
 	if (isTotal)
 	{
 		return nStats.*statsType.*statisticType;
@@ -1298,6 +1422,12 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		ASSERT_OR_RETURN(false, false, "Wrong queue type.");
 	}
 
+	// The raw data is the header followed by the message data, written straight from the message without copying it, and
+	// encoded only once for all the players it is sent to.
+	uint8_t rawHeader[NET_MESSAGE_MAX_HEADER];
+	SocketSlice rawData[2] = {{rawHeader, message->rawHeader(rawHeader)}, {message->data.data(), message->data.size()}};
+	ssize_t rawLen = rawData[0].size + rawData[1].size;
+
 	if (NetPlay.isHost)
 	{
 		int firstPlayer = player == NET_ALL_PLAYERS ? 0                         : player;
@@ -1307,11 +1437,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 			// We are the host, send directly to player.
 			if (sockets[player] != nullptr && player != queue.exclude)
 			{
-				uint8_t *rawData = message->rawDataDup();
-				ssize_t rawLen   = message->rawLen();
 				size_t compressedRawLen;
-				result = writeAll(sockets[player], rawData, rawLen, &compressedRawLen);
-				delete[] rawData;  // Done with the data.
+				result = writeAllSlices(sockets[player], rawData, 2, &compressedRawLen);
 
 				if (result == rawLen)
 				{
@@ -1338,11 +1465,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		// We are a client, send directly to player, who happens to be the host.
 		if (bsocket)
 		{
-			uint8_t *rawData = message->rawDataDup();
-			ssize_t rawLen   = message->rawLen();
 			size_t compressedRawLen;
-			result = writeAll(bsocket, rawData, rawLen, &compressedRawLen);
-			delete[] rawData;  // Done with the data.
+			result = writeAllSlices(bsocket, rawData, 2, &compressedRawLen);
 
 			if (result == rawLen)
 			{
@@ -1826,16 +1950,9 @@ bool NETrecvNet(NETQUEUE *queue, uint8_t *type)
 		NETcheckPlayers();		// make sure players are still alive & well
 	}
 
-	if (socket_set == nullptr || checkSockets(socket_set, NET_READ_TIMEOUT) <= 0)
-	{
-		goto checkMessages;
-	}
-
 	for (current = 0; current < MAX_CONNECTED_PLAYERS; ++current)
 	{
 		Socket **pSocket = NetPlay.isHost ? &connected_bsocket[current] : &bsocket;
-		uint8_t buffer[NET_BUFFER_SIZE];
-		size_t dataLen;
 
 		if (!NetPlay.isHost && current != NET_HOST_ONLY)
 		{
@@ -1847,15 +1964,9 @@ bool NETrecvNet(NETQUEUE *queue, uint8_t *type)
 			continue;
 		}
 
-		dataLen = NET_fillBuffer(pSocket, socket_set, buffer, sizeof(buffer));
-		if (dataLen > 0)
+		if (!NETtakeReadMessages(current, pSocket))
 		{
-			// we received some data, add to buffer
-			NETinsertRawData(NETnetQueue(current), buffer, dataLen);
-		}
-		else if (*pSocket == nullptr)
-		{
-			// If there is a error in NET_fillBuffer() then socket is already invalid.
+			// If the connection was lost, then NETtakeReadMessages() closed the socket.
 			// This means that the player dropped / disconnected for whatever reason.
 			debug(LOG_INFO, "Player, (player %u) seems to have dropped/disconnected.", (unsigned)current);
 
@@ -1867,13 +1978,12 @@ bool NETrecvNet(NETQUEUE *queue, uint8_t *type)
 			}
 			else
 			{
-				// lobby errors were set in NET_fillBuffer()
+				// lobby errors were set in NETtakeReadMessages()
 				return false;
 			}
 		}
 	}
 
-checkMessages:
 	for (current = 0; current < MAX_CONNECTED_PLAYERS; ++current)
 	{
 		*queue = NETnetQueue(current);
@@ -1897,12 +2007,13 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 		*queue = NETgameQueue(current);
 		while (!checkPlayerGameTime(current))  // Check for any messages that are scheduled to be read now.
 		{
-			if (!NETisMessageReady(*queue))
+			if (!NETisMessageReady(*queue) && !NETreplayLoadNetMessages(current))
 			{
 				return false;  // Still waiting for messages from this player, and all players should process messages in the same order. Will have to freeze the game while waiting.
 			}
 
 			*type = NETgetMessage(*queue)->type;
+			NETreplaySaveNetMessage(*NETgetMessage(*queue), current);
 
 			if (*type == GAME_GAME_TIME)
 			{
@@ -2485,8 +2596,8 @@ static void NETallowJoining()
 					SocketSet_DelSocket(tmp_socket_set, tmp_socket[i]);
 					connected_bsocket[index] = tmp_socket[i];
 					tmp_socket[i] = nullptr;
-					SocketSet_AddSocket(socket_set, connected_bsocket[index]);
 					NETmoveQueue(NETnetTmpQueue(i), NETnetQueue(index));
+					NETstartReading(index, connected_bsocket[index]);
 
 					// Copy player's IP address.
 					sstrcpy(NetPlay.players[index].IPtextAddress, getSocketTextAddress(connected_bsocket[index]));
@@ -2964,6 +3075,8 @@ bool NETjoinGame(const char *host, uint32_t port, const char *playername)
 	bsocket = tcp_socket;
 	tcp_socket = nullptr;
 	socketBeginCompression(bsocket);
+	SocketSet_DelSocket(socket_set, bsocket);
+	NETstartReading(NET_HOST_ONLY, bsocket);
 
 	// Send a join message to the host
 	NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_JOIN);
@@ -3161,206 +3274,126 @@ bool NETcheckPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player)
 	return realTime < NET_PlayerConnectionStatus[status][player];
 }
 
-struct SyncDebugEntry
-{
-	char const *function;
-};
-
-struct SyncDebugString : public SyncDebugEntry
+/// Adds value to crc as size big-endian bytes, so the CRC doesn't depend on the platform.
+static uint32_t crcSumValue(uint32_t crc, uint64_t value, unsigned size)
 {
-	void set(uint32_t &crc, char const *f, char const *string)
+	uint8_t bytes[8];
+	for (unsigned n = 0; n < size; ++n)
 	{
-		function = f;
-		crc = crcSum(crc, function, strlen(function) + 1);
-		crc = crcSum(crc, string,   strlen(string) + 1);
+		bytes[n] = value >> 8 * (size - 1 - n);
 	}
-	int snprint(char *buf, size_t bufSize, char const *&string) const
-	{
-		int ret = snprintf(buf, bufSize, "[%s] %s\n", function, string);
-		string += strlen(string) + 1;
-		return ret;
-	}
-};
+	return crcSum(crc, bytes, size);
+}
 
-struct SyncDebugValueChange : public SyncDebugEntry
+/** The syncDebug() calls of one tick
+ *
+ *  Each entry is stored in a byte buffer as a header, followed by each argument's type and raw value, and strings are
+ *  copied. The buffer keeps its size when cleared, so recording doesn't allocate, once it has grown large enough for a
+ *  tick. The CRC is of the arguments, not of the text, which is only made by snprint(), if the log is dumped.
+ */
+struct SyncDebugLog
 {
-	void set(uint32_t &crc, char const *f, char const *vn, int nv, int i)
+	SyncDebugLog() : time(0), crc(0x00000000), numEntries(0) {}
+	void clear()
 	{
-		function = f;
-		variableName = vn;
-		newValue = nv;
-		id = i;
-		uint32_t valueBytes = htonl(newValue);
-		crc = crcSum(crc, function,     strlen(function) + 1);
-		crc = crcSum(crc, variableName, strlen(variableName) + 1);
-		crc = crcSum(crc, &valueBytes,  4);
+		data.clear();
+		numEntries = 0;
+		time = 0;
+		crc = 0x00000000;
 	}
-	int snprint(char *buf, size_t bufSize) const
+	void entry(SyncDebugFormat const &format, SyncDebugArg const *args, size_t numArgs)
 	{
-		if (id != -1)
+		size_t headerPos = beginEntry(format.function, format.format, numArgs);
+		crc = crcSumValue(crc, format.crc, 4);
+		for (size_t n = 0; n < numArgs; ++n)
 		{
-			return snprintf(buf, bufSize, "[%s] %d %s = %d\n", function, id, variableName, newValue);
+			SyncDebugArg const &arg = args[n];
+			put<uint8_t>(arg.type);
+			switch (arg.type)
+			{
+			case SyncDebugArg::INT:
+			case SyncDebugArg::UINT:
+				put<uint32_t>(arg.u);
+				crc = crcSumValue(crc, arg.u, 4);
+				break;
+			case SyncDebugArg::LONG:
+			case SyncDebugArg::ULONG:
+			case SyncDebugArg::LONGLONG:
+			case SyncDebugArg::ULONGLONG:
+				put<uint64_t>(arg.u);
+				crc = crcSumValue(crc, arg.u, 8);  // 8 bytes even if long is 4 bytes, to get the same CRC on each platform.
+				break;
+			case SyncDebugArg::STRING:
+				{
+					char const *string = arg.s != nullptr ? arg.s : "(null)";
+					uint32_t len = strlen(string) + 1;
+					put<uint32_t>(len);
+					size_t offset = data.size();
+					data.resize(offset + len);
+					memcpy(&data[offset], string, len);
+					crc = crcSum(crc, string, len);
+					break;
+				}
+			}
 		}
-		return snprintf(buf, bufSize, "[%s] %s = %d\n", function, variableName, newValue);
+		endEntry(headerPos);
 	}
-
-	int         newValue;
-	int         id;
-	char const *variableName;
-};
-
-struct SyncDebugIntList : public SyncDebugEntry
-{
-	void set(uint32_t &crc, char const *f, char const *s, int const *ints, size_t num)
+	void intList(char const *f, char const *s, int const *ints, size_t num)
 	{
-		function = f;
-		string = s;
-		uint32_t valueBytes[40];
-		numInts = std::min(num, ARRAY_SIZE(valueBytes));
-		for (unsigned n = 0; n < numInts; ++n)
+		size_t headerPos = beginEntry(f, s, num);
+		for (size_t n = 0; n < num; ++n)
 		{
-			valueBytes[n] = htonl(ints[n]);
+			put<uint8_t>(SyncDebugArg::INT);
+			put<int32_t>(ints[n]);
+			crc = crcSumValue(crc, (uint32_t)ints[n], 4);
 		}
-		crc = crcSum(crc, valueBytes, 4 * numInts);
+		endEntry(headerPos);
 	}
-	int snprint(char *buf, size_t bufSize, int const *&ints) const
+	int snprint(char *buf, size_t bufSize) const
 	{
 		size_t index = 0;
-		if (index < bufSize)
+		size_t pos = 0;
+		for (unsigned n = 0; n < numEntries && index < bufSize; ++n)
 		{
-			index += snprintf(buf + index, bufSize - index, "[%s] ", function);
-		}
-		if (index < bufSize)
-		{
-			switch (numInts)
+			Header header = get<Header>(pos);
+			index += snprintf(buf + index, bufSize - index, "[%s] ", header.function);
+			uint32_t arg = 0;
+			for (char const *c = header.format; *c != '\0' && index < bufSize; ++c)
 			{
-			case  0: index += snprintf(buf + index, bufSize - index, "%s", string); break;
-			case  1: index += snprintf(buf + index, bufSize - index, string, ints[0]); break;
-			case  2: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1]); break;
-			case  3: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2]); break;
-			case  4: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3]); break;
-			case  5: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4]); break;
-			case  6: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5]); break;
-			case  7: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6]); break;
-			case  8: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7]); break;
-			case  9: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8]); break;
-			case 10: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9]); break;
-			case 11: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10]); break;
-			case 12: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11]); break;
-			case 13: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12]); break;
-			case 14: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13]); break;
-			case 15: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14]); break;
-			case 16: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15]); break;
-			case 17: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16]); break;
-			case 18: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17]); break;
-			case 19: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18]); break;
-			case 20: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19]); break;
-			case 21: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20]); break;
-			case 22: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21]); break;
-			case 23: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22]); break;
-			case 24: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23]); break;
-			case 25: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24]); break;
-			case 26: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25]); break;
-			case 27: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26]); break;
-			case 28: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27]); break;
-			case 29: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28]); break;
-			case 30: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29]); break;
-			case 31: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30]); break;
-			case 32: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31]); break;
-			case 33: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32]); break;
-			case 34: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33]); break;
-			case 35: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34]); break;
-			case 36: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35]); break;
-			case 37: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36]); break;
-			case 38: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37]); break;
-			case 39: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38]); break;
-			case 40: index += snprintf(buf + index, bufSize - index, string, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38], ints[39]); break;
-			default: index += snprintf(buf + index, bufSize - index, "Too many ints in intlist."); break;
+				if (*c != '%' || c[1] == '%')
+				{
+					c += *c == '%';
+					buf[index++] = *c;
+					continue;
+				}
+				// Copy the conversion specification, up to its conversion character, and print the next argument with it.
+				char spec[32];
+				size_t specLen = 0;
+				spec[specLen++] = *c;
+				while (c[1] != '\0' && strchr("diouxXcspfFeEgGaAn", c[1]) == nullptr && specLen < sizeof(spec) - 2)
+				{
+					spec[specLen++] = *++c;
+				}
+				if (c[1] == '\0')
+				{
+					break;
+				}
+				spec[specLen++] = *++c;
+				spec[specLen] = '\0';
+				if (arg++ < header.numArgs)
+				{
+					index += snprintArg(buf + index, bufSize - index, spec, pos);
+				}
+				else
+				{
+					index += snprintf(buf + index, bufSize - index, "%s", spec);
+				}
 			}
-		}
-		if (index < bufSize)
-		{
-			index += snprintf(buf + index, bufSize - index, "\n");
-		}
-		ints += numInts;
-		return index;
-	}
-
-	char const *string;
-	unsigned numInts;
-};
-
-struct SyncDebugLog
-{
-	SyncDebugLog() : time(0), crc(0x00000000) {}
-	void clear()
-	{
-		log.clear();
-		time = 0;
-		crc = 0x00000000;
-		//printf("Freeing %d strings, %d valueChanges, %d intLists, %d chars, %d ints\n", (int)strings.size(), (int)valueChanges.size(), (int)intLists.size(), (int)chars.size(), (int)ints.size());
-		strings.clear();
-		valueChanges.clear();
-		intLists.clear();
-		chars.clear();
-		ints.clear();
-	}
-	void string(char const *f, char const *s)
-	{
-		size_t offset = chars.size();
-		chars.resize(chars.size() + strlen(s) + 1);
-		char *buf = &chars[offset];
-		strcpy(buf, s);
-
-		strings.resize(strings.size() + 1);
-		strings.back().set(crc, f, buf);
-
-		log.push_back('s');
-	}
-	void valueChange(char const *f, char const *vn, int nv, int i)
-	{
-		valueChanges.resize(valueChanges.size() + 1);
-		valueChanges.back().set(crc, f, vn, nv, i);
-		log.push_back('v');
-	}
-	void intList(char const *f, char const *s, int *begin, size_t num)
-	{
-		size_t offset = ints.size();
-		ints.resize(ints.size() + num);
-		int *buf = &ints[offset];
-		std::copy(begin, begin + num, buf);
-
-		intLists.resize(intLists.size() + 1);
-		intLists.back().set(crc, f, s, buf, num);
-		log.push_back('i');
-	}
-	int snprint(char *buf, size_t bufSize)
-	{
-		SyncDebugString const *stringPtr = strings.empty() ? nullptr : &strings[0]; // .empty() check, since &strings[0] is undefined if strings is empty(), even if it's likely to work, anyway.
-		SyncDebugValueChange const *valueChangePtr = valueChanges.empty() ? nullptr : &valueChanges[0];
-		SyncDebugIntList const *intListPtr = intLists.empty() ? nullptr : &intLists[0];
-		char const *charPtr = chars.empty() ? nullptr : &chars[0];
-		int const *intPtr = ints.empty() ? nullptr : &ints[0];
-
-		int index = 0;
-		for (size_t n = 0; n < log.size() && (size_t)index < bufSize; ++n)
-		{
-			char type = log[n];
-			switch (type)
+			if (index < bufSize)
 			{
-			case 's':
-				index += stringPtr++->snprint(buf + index, bufSize - index, charPtr);
-				break;
-			case 'v':
-				index += valueChangePtr++->snprint(buf + index, bufSize - index);
-				break;
-			case 'i':
-				index += intListPtr++->snprint(buf + index, bufSize - index, intPtr);
-				break;
-			default:
-				abort();
-				break;
+				index += snprintf(buf + index, bufSize - index, "\n");
 			}
+			pos = header.end;
 		}
 		return index;
 	}
@@ -3374,7 +3407,7 @@ struct SyncDebugLog
 	}
 	unsigned getNumEntries() const
 	{
-		return log.size();
+		return numEntries;
 	}
 	void setGameTime(uint32_t newTime)
 	{
@@ -3386,23 +3419,74 @@ struct SyncDebugLog
 	}
 
 private:
-	std::vector<char> log;
-	uint32_t time;
-	uint32_t crc;
+	struct Header
+	{
+		char const *function;
+		char const *format;
+		uint32_t numArgs;
+		uint32_t end;            ///< Position of the next entry.
+	};
 
-	std::vector<SyncDebugString> strings;
-	std::vector<SyncDebugValueChange> valueChanges;
-	std::vector<SyncDebugIntList> intLists;
+	template <typename T>
+	void put(T const &value)
+	{
+		size_t offset = data.size();
+		data.resize(offset + sizeof(T));
+		memcpy(&data[offset], &value, sizeof(T));
+	}
+	template <typename T>
+	T get(size_t &pos) const
+	{
+		T value;
+		memcpy(&value, &data[pos], sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+	size_t beginEntry(char const *function, char const *format, size_t numArgs)
+	{
+		size_t headerPos = data.size();
+		Header header = {function, format, (uint32_t)numArgs, 0};
+		put(header);
+		++numEntries;
+		return headerPos;
+	}
+	void endEntry(size_t headerPos)
+	{
+		uint32_t end = data.size();
+		memcpy(&data[headerPos + offsetof(Header, end)], &end, sizeof(end));
+	}
+	int snprintArg(char *buf, size_t bufSize, char const *spec, size_t &pos) const
+	{
+		switch (get<uint8_t>(pos))
+		{
+		case SyncDebugArg::INT:       return snprintf(buf, bufSize, spec, get<int32_t>(pos));
+		case SyncDebugArg::UINT:      return snprintf(buf, bufSize, spec, get<uint32_t>(pos));
+		case SyncDebugArg::LONG:      return snprintf(buf, bufSize, spec, (long)get<int64_t>(pos));
+		case SyncDebugArg::ULONG:     return snprintf(buf, bufSize, spec, (unsigned long)get<uint64_t>(pos));
+		case SyncDebugArg::LONGLONG:  return snprintf(buf, bufSize, spec, (long long)get<int64_t>(pos));
+		case SyncDebugArg::ULONGLONG: return snprintf(buf, bufSize, spec, (unsigned long long)get<uint64_t>(pos));
+		case SyncDebugArg::STRING:
+			{
+				uint32_t len = get<uint32_t>(pos);
+				char const *string = (char const *)&data[pos];
+				pos += len;
+				return snprintf(buf, bufSize, spec, string);
+			}
+		}
+		abort();
+		return 0;
+	}
 
-	std::vector<char> chars;
-	std::vector<int> ints;
+	std::vector<uint8_t> data;
+	uint32_t time;
+	uint32_t crc;
+	unsigned numEntries;
 
 private:
 	SyncDebugLog(SyncDebugLog const &)/* = delete*/;
 	SyncDebugLog &operator =(SyncDebugLog const &)/* = delete*/;
 };
 
-#define MAX_LEN_LOG_LINE 512  // From debug.c - no use printing something longer.
 #define MAX_SYNC_HISTORY 12
 
 static unsigned syncDebugNext = 0;
@@ -3412,23 +3496,22 @@ static uint32_t syncDebugExtraCrc;
 
 static uint32_t syncDebugNumDumps = 0;
 
-void _syncDebug(const char *function, const char *str, ...)
+void _syncDebugArgs(SyncDebugFormat &format, const char *function, const char *str, SyncDebugArg const *args, size_t numArgs)
 {
+	if (format.format == nullptr)
+	{
 #ifdef WZ_CC_MSVC
-	char const *f = function; while (*f != '\0') if (*f++ == ':')
-		{
-			function = f;    // Strip "Class::" from "Class::myFunction".
-		}
+		char const *f = function; while (*f != '\0') if (*f++ == ':')
+			{
+				function = f;    // Strip "Class::" from "Class::myFunction".
+			}
 #endif
+		format.function = function;
+		format.format = str;
+		format.crc = crcSum(crcSum(0x00000000, function, strlen(function) + 1), str, strlen(str) + 1);
+	}
 
-	va_list ap;
-	char outputBuffer[MAX_LEN_LOG_LINE];
-
-	va_start(ap, str);
-	vssprintf(outputBuffer, str, ap);
-	va_end(ap);
-
-	syncDebugLog[syncDebugNext].string(function, outputBuffer);
+	syncDebugLog[syncDebugNext].entry(format, args, numArgs);
 }
 
 void _syncDebugIntList(const char *function, const char *str, int *ints, size_t numInts)
@@ -290,7 +290,8 @@ void NETaddRedirects();
 void NETremRedirects();
 void NETdiscoverUPnPDevices();
 
-enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets};
+/// The latency statistics are how long received messages waited, in microseconds, between the socket thread reading them and the game taking them, rounded up to a power of 2. They ignore sent.
+enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets, NetStatisticLatencyMedian, NetStatisticLatency99th, NetStatisticLatencyMax};
 unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false);     // Return some statistic. Call regularly for good results.
 
 void NETplayerKicked(UDWORD index);			// Cleanup after player has been kicked
@@ -334,9 +335,59 @@ bool NETcheckPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player);
 
 const char *messageTypeToString(unsigned messageType);
 
+/// A syncDebug() argument, after the usual promotion of variadic arguments. Floats and pointers other than strings aren't allowed.
+struct SyncDebugArg
+{
+	enum Type
+	{
+		INT, UINT, LONG, ULONG, LONGLONG, ULONGLONG, STRING
+	};
+
+	SyncDebugArg() : type(INT), i(0) {}
+	SyncDebugArg(int v) : type(INT), i(v) {}
+	SyncDebugArg(unsigned v) : type(UINT), u(v) {}
+	SyncDebugArg(long v) : type(LONG), i(v) {}
+	SyncDebugArg(unsigned long v) : type(ULONG), u(v) {}
+	SyncDebugArg(long long v) : type(LONGLONG), i(v) {}
+	SyncDebugArg(unsigned long long v) : type(ULONGLONG), u(v) {}
+	SyncDebugArg(char const *v) : type(STRING), s(v) {}
+
+	Type type;
+	union
+	{
+		int64_t i;
+		uint64_t u;
+		char const *s;
+	};
+};
+
+/// Describes one syncDebug() call site. Filled in on the first call, so the function name and format are only hashed once.
+struct SyncDebugFormat
+{
+	char const *function;
+	char const *format;
+	uint32_t crc;            ///< Of function and format.
+};
+
 /// Sync debugging. Only prints anything, if different players would print different things.
-#define syncDebug(...) do { _syncDebug(__FUNCTION__, __VA_ARGS__); } while(0)
-void _syncDebug(const char *function, const char *str, ...) WZ_DECL_FORMAT(printf, 2, 3);
+/// The arguments are recorded as they are, and only formatted if the log is dumped, so may not include floats, and strings
+/// are copied. The format may not use '*' widths.
+#define syncDebug(...) do { static SyncDebugFormat _syncDebugFormatDesc = {nullptr, nullptr, 0}; (void)sizeof((_syncDebugCheckFormat(__VA_ARGS__), 0)); _syncDebugRecord(_syncDebugFormatDesc, __FUNCTION__, __VA_ARGS__); } while(0)
+void _syncDebugCheckFormat(const char *str, ...) WZ_DECL_FORMAT(printf, 1, 2);  ///< Never called, only lets the compiler check syncDebug() formats.
+void _syncDebugArgs(SyncDebugFormat &format, const char *function, const char *str, SyncDebugArg const *args, size_t numArgs);
+template <typename... Args>
+inline void _syncDebugRecord(SyncDebugFormat &format, const char *function, const char *str, Args... args)
+{
+	SyncDebugArg const argList[] = {SyncDebugArg(+args)..., SyncDebugArg()};  // Unary + gives the promoted type, and decays arrays.
+	_syncDebugArgs(format, function, str, argList, sizeof...(Args));
+}
+/// Like syncDebug, for callers which pass on the name of their caller. Hashes the function name and format every time.
+template <typename... Args>
+inline void _syncDebug(const char *function, const char *str, Args... args)
+{
+	SyncDebugFormat format = {nullptr, nullptr, 0};
+	_syncDebugRecord(format, function, str, args...);
+}
 /// Faster than syncDebug. Make sure that str is a format string that takes ints only.
 void _syncDebugIntList(const char *function, const char *str, int *ints, size_t numInts);
 #define syncDebugBacktrace() do { _syncDebugBacktrace(__FUNCTION__); } while(0)
@@ -24,6 +24,8 @@
 #include "lib/framework/frame.h"
 #include "netqueue.h"
 
+#include <algorithm>
+
 // See comments in netqueue.h.
 
 
@@ -100,22 +102,19 @@ bool decode_uint32_t(uint8_t b, uint32_t &v, unsigned n)
 	return !isLastByte;
 }
 
-uint8_t *NetMessage::rawDataDup() const
+size_t NetMessage::rawHeader(uint8_t (&header)[NET_MESSAGE_MAX_HEADER]) const
 {
 	unsigned encodedLengthOfSize = encodedlength_uint32_t(data.size());
 
-	uint8_t *ret = new uint8_t[1 + encodedLengthOfSize + data.size()];
-
-	ret[0] = type;
+	header[0] = type;
 
 	uint32_t len = data.size();
 	for (unsigned n = 0; n < encodedLengthOfSize; ++n)
 	{
-		encode_uint32_t(ret[n + 1], len, n);
+		encode_uint32_t(header[n + 1], len, n);
 	}
 
-	std::copy(data.begin(), data.end(), ret + 1 + encodedLengthOfSize);
-	return ret;
+	return 1 + encodedLengthOfSize;
 }
 
 size_t NetMessage::rawLen() const
@@ -123,49 +122,91 @@ size_t NetMessage::rawLen() const
 	return 1 + encodedlength_uint32_t(data.size()) + data.size();
 }
 
+#define NET_QUEUE_INITIAL_SLOTS   16    ///< Must be a power of 2.
+#define NET_QUEUE_KEEP_BUFFER_SIZE 4096  ///< Data buffers up to this size are kept for reuse, larger ones are freed.
+
 NetQueue::NetQueue()
 	: canGetMessagesForNet(true)
 	, canGetMessages(true)
+	, messages(NET_QUEUE_INITIAL_SLOTS)
+{}
+
+NetMessage &NetQueue::newMessageSlot()
 {
-	dataPos = messages.end();
-	messagePos = messages.end();
+	if (endPos - firstPos == messages.size())
+	{
+		// Full, so double the size. Moving the messages keeps their data buffers where they are.
+		std::vector<NetMessage> oldMessages(messages.size() * 2);
+		oldMessages.swap(messages);
+		for (uint64_t n = firstPos; n != firstPos + oldMessages.size(); ++n)
+		{
+			slot(n) = std::move(oldMessages[n & (oldMessages.size() - 1)]);
+		}
+	}
+	return slot(endPos);
 }
 
-void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
+void NetMessageSplitter::writeRawData(const uint8_t *netData, size_t netLen)
 {
-	size_t used = 0;
-	std::vector<uint8_t> &buffer = incompleteReceivedMessageData;  // Short alias.
+	// Recycle old data.
+	buffer.erase(buffer.begin(), buffer.begin() + used);
+	used = 0;
 
 	// Insert the data.
 	buffer.insert(buffer.end(), netData, netData + netLen);
+}
 
-	// Extract the messages.
-	while (buffer.size() - used > 1)
+bool NetMessageSplitter::readMessage(NetMessage &message)
+{
+	if (buffer.size() - used <= 1)
 	{
-		uint8_t type = buffer[used];
+		return false;
+	}
 
-		uint32_t len = 0;
-		bool moreBytes = true;
-		unsigned n;
-		for (n = 0; moreBytes && buffer.size() - used > 1 + n; ++n)
-		{
-			moreBytes = decode_uint32_t(buffer[used + 1 + n], len, n);
-		}
-		unsigned headerLen = 1 + n;
+	uint8_t type = buffer[used];
 
-		ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
-		if (buffer.size() - used - headerLen < len)
-		{
-			break;  // Don't have a whole message ready yet.
-		}
+	uint32_t len = 0;
+	bool moreBytes = true;
+	unsigned n;
+	for (n = 0; moreBytes && buffer.size() - used > 1 + n; ++n)
+	{
+		moreBytes = decode_uint32_t(buffer[used + 1 + n], len, n);
+	}
+	unsigned headerLen = 1 + n;
 
-		messages.push_front(NetMessage(type));
-		messages.front().data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
-		used += headerLen + len;
+	ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
+	if (moreBytes || buffer.size() - used - headerLen < len)
+	{
+		return false;  // Don't have a whole message ready yet.
 	}
 
-	// Recycle old data.
-	buffer.erase(buffer.begin(), buffer.begin() + used);
+	message.type = type;
+	message.data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
+	used += headerLen + len;
+	return true;
+}
+
+void NetMessageSplitter::clear()
+{
+	buffer.clear();
+	used = 0;
+}
+
+void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
+{
+	incompleteReceivedMessageData.writeRawData(netData, netLen);
+
+	// Extract the messages, directly into the queue.
+	while (incompleteReceivedMessageData.readMessage(newMessageSlot()))
+	{
+		++endPos;
+	}
+}
+
+void NetQueue::takeIncompleteRawData(NetMessageSplitter &splitter)
+{
+	splitter = std::move(incompleteReceivedMessageData);
+	incompleteReceivedMessageData.clear();
 }
 
 void NetQueue::setWillNeverGetMessagesForNet()
@@ -178,10 +219,7 @@ unsigned NetQueue::numMessagesForNet() const
 	unsigned count = 0;
 	if (canGetMessagesForNet)
 	{
-		for (List::iterator i = dataPos; i != messages.begin(); --i)
-		{
-			++count;
-		}
+		count = (unsigned)(endPos - dataPos);
 	}
 
 	return count;
@@ -190,21 +228,19 @@ unsigned NetQueue::numMessagesForNet() const
 const NetMessage &NetQueue::getMessageForNet() const
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for getMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to get!");
+	ASSERT(dataPos != endPos, "No message to get!");
 
 	// Return the message.
-	List::iterator i = dataPos;
-	--i;
-	return *i;
+	return slot(dataPos);
 }
 
 void NetQueue::popMessageForNet()
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for popMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to pop!");
+	ASSERT(dataPos != endPos, "No message to pop!");
 
 	// Pop the message.
-	--dataPos;
+	++dataPos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -212,7 +248,18 @@ void NetQueue::popMessageForNet()
 
 void NetQueue::pushMessage(const NetMessage &message)
 {
-	messages.push_front(message);
+	NetMessage &newMessage = newMessageSlot();
+	newMessage.type = message.type;
+	newMessage.data.assign(message.data.begin(), message.data.end());  // Reuses the buffer of the slot, if big enough.
+	++endPos;
+}
+
+void NetQueue::pushMessage(NetMessage &&message)
+{
+	NetMessage &newMessage = newMessageSlot();
+	newMessage.type = message.type;
+	std::swap(newMessage.data, message.data);
+	++endPos;
 }
 
 void NetQueue::setWillNeverGetMessages()
@@ -223,27 +270,25 @@ void NetQueue::setWillNeverGetMessages()
 bool NetQueue::haveMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for haveMessage.");
-	return messagePos != messages.begin();
+	return messagePos != endPos;
 }
 
 const NetMessage &NetQueue::getMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for getMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to get!");
+	ASSERT(messagePos != endPos, "No message to get!");
 
 	// Return the message.
-	List::iterator i = messagePos;
-	--i;
-	return *i;
+	return slot(messagePos);
 }
 
 void NetQueue::popMessage()
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for popMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to pop!");
+	ASSERT(messagePos != endPos, "No message to pop!");
 
 	// Pop the message.
-	--messagePos;
+	++messagePos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -253,27 +298,20 @@ void NetQueue::popOldMessages()
 {
 	if (!canGetMessagesForNet)
 	{
-		dataPos = messages.begin();
+		dataPos = endPos;
 	}
 	if (!canGetMessages)
 	{
-		messagePos = messages.begin();
-	}
-
-	List::iterator i = messages.end();
-	while (i != dataPos && i != messagePos)
-	{
-		--i;
+		messagePos = endPos;
 	}
 
-	if (i == dataPos)
-	{
-		dataPos = messages.end();  // Old iterator will become invalid.
-	}
-	if (i == messagePos)
+	uint64_t newFirstPos = std::min(dataPos, messagePos);
+	for (; firstPos != newFirstPos; ++firstPos)
 	{
-		messagePos = messages.end();  // Old iterator will become invalid.
+		std::vector<uint8_t> &data = slot(firstPos).data;
+		if (data.capacity() > NET_QUEUE_KEEP_BUFFER_SIZE)
+		{
+			std::vector<uint8_t>().swap(data);
+		}
 	}
-
-	messages.erase(i, messages.end());
 }
@@ -26,7 +26,6 @@
 
 #include "lib/framework/frame.h"
 #include <vector>
-#include <list>
 #include <deque>
 
 // At game level:
@@ -40,13 +39,15 @@
 // There should be a NetQueuePair per socket.
 
 
+#define NET_MESSAGE_MAX_HEADER 6  ///< The type, and up to 5 bytes of length.
+
 /// A NetMessage consists of a type (uint8_t) and some data, the meaning of which depends on the type.
 class NetMessage
 {
 public:
 	NetMessage(uint8_t type_ = 0xFF) : type(type_) {}
-	uint8_t *rawDataDup() const;  ///< Returns data compatible with NetQueue::writeRawData(). Must be delete[]d.
-	size_t rawLen() const;        ///< Returns the length of the return value of rawDataDup().
+	size_t rawHeader(uint8_t (&header)[NET_MESSAGE_MAX_HEADER]) const;  ///< Writes the type and length, which come before the data in the raw data, and returns their length.
+	size_t rawLen() const;        ///< Returns the length of the raw data, compatible with NetQueue::writeRawData(), which is the header followed by the data.
 	uint8_t type;
 	std::vector<uint8_t> data;
 };
@@ -75,29 +76,47 @@ class MessageReader
 public:
 	enum { Read, Write, Direction = Read };
 
-	MessageReader(const NetMessage *m = nullptr) : message(m), index(0) {}
-	MessageReader(const NetMessage &m) : message(&m), index(0) {}
+	MessageReader(const NetMessage *m = nullptr) : data(m != nullptr ? m->data.data() : nullptr), size(m != nullptr ? m->data.size() : 0), index(0) {}
+	MessageReader(const NetMessage &m) : data(m.data.data()), size(m.data.size()), index(0) {}
 	void byte(uint8_t &v) const
 	{
-		v = index >= message->data.size() ? 0x00 : message->data[index];
+		v = index >= size ? 0x00 : data[index];
 		++index;
 	}
 	bool valid() const
 	{
-		return index <= message->data.size();
+		return index <= size;
 	}
-	const NetMessage *message;
+	const uint8_t *data;  ///< The data of the message being read, which must not be changed or freed while reading. Not a NetMessage *, since NetQueue may move the NetMessage itself, while keeping its data.
+	size_t size;
 	mutable size_t index;
 };
 
+/// A NetMessageSplitter converts a stream of bytes from the network back into NetMessages, keeping data which has not yet formed an entire message.
+class NetMessageSplitter
+{
+public:
+	void writeRawData(const uint8_t *netData, size_t netLen);          ///< Appends data from the network.
+	bool readMessage(NetMessage &message);                             ///< Extracts the next complete message, or returns false if there isn't one yet.
+	void clear();                                                      ///< Throws away any data not yet extracted.
+
+private:
+	std::vector<uint8_t> buffer;                                       ///< Data from network which has not yet been extracted.
+	size_t used = 0;                                                   ///< Bytes at the start of buffer already extracted.
+};
+
 /// A NetQueue is a queue of NetMessages. A NetQueue can convert the messages into a stream of bytes, which can be sent over the network, and converted back into a queue of NetMessages by the NetQueue at the other end.
 class NetQueue
 {
 public:
 	NetQueue();
 
+	NetQueue(NetQueue const &) = delete;
+	NetQueue &operator =(NetQueue const &) = delete;
+
 	// Network related, receiving
 	void writeRawData(const uint8_t *netData, size_t netLen);          ///< Inserts data from the network into the NetQueue.
+	void takeIncompleteRawData(NetMessageSplitter &splitter);          ///< Moves data from the network which has not yet formed an entire message out of the NetQueue, for when the rest of the data will be split elsewhere.
 	// Network related, sending
 	void setWillNeverGetMessagesForNet();                              ///< Marks that we will not be sending this data over the network.
 	unsigned numMessagesForNet() const;                                ///< Checks that we didn't mark that we will not be sending this data over the network (returns 0), and returns the number of messages to be sent.
@@ -107,6 +126,7 @@ public:
 	// All game clients should check game messages from all queues, including their own, and only the net messages sent to them.
 	// Message related, storing.
 	void pushMessage(const NetMessage &message);                       ///< Adds a message to the queue.
+	void pushMessage(NetMessage &&message);                            ///< Adds a message to the queue, without copying it.
 	// Message related, extracting.
 	void setWillNeverGetMessages();                                    ///< Marks that we will not be reading any of the messages (only sending over the network).
 	bool haveMessage() const;                                          ///< Return true if we have a message ready to return.
@@ -115,19 +135,26 @@ public:
 
 private:
 	void popOldMessages();                                             ///< Pops any messages that are no longer needed.
-
-	// Disable copy constructor and assignment operator.
-	NetQueue(const NetQueue &);         // TODO When switching to C++0x, use "= delete" notation.
-	void operator =(const NetQueue &);  // TODO When switching to C++0x, use "= delete" notation.
+	NetMessage &slot(uint64_t n)                                       ///< Returns the slot of the message numbered n.
+	{
+		return messages[n & (messages.size() - 1)];
+	}
+	NetMessage const &slot(uint64_t n) const
+	{
+		return messages[n & (messages.size() - 1)];
+	}
+	NetMessage &newMessageSlot();                                      ///< Returns the slot for the next message pushed, making room if needed.
 
 	bool canGetMessagesForNet;                                         ///< True if we will send the messages over the network, false if we don't.
 	bool canGetMessages;                                               ///< True if we will get the messages, false if we don't use them ourselves.
 
-	typedef std::list<NetMessage> List;
-	List::iterator                dataPos;                             ///< Last message which was sent over the network.
-	List::iterator                messagePos;                          ///< Last message which was popped.
-	List                          messages;                            ///< List of messages. Messages are added to the front and read from the back.
-	std::vector<uint8_t>          incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
+	// Messages are numbered in the order they are pushed. Message n is kept in messages[n % messages.size()].
+	uint64_t                      firstPos = 0;                        ///< Oldest message still needed.
+	uint64_t                      dataPos = 0;                         ///< Next message to send over the network.
+	uint64_t                      messagePos = 0;                      ///< Next message to get.
+	uint64_t                      endPos = 0;                          ///< Number of messages pushed so far.
+	std::vector<NetMessage>       messages;                            ///< Ring buffer of messages, whose size is a power of 2. Slots of popped messages keep their data buffers for reuse.
+	NetMessageSplitter            incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
 };
 
 /// A NetQueuePair is used for talking to a socket. We insert NetMessages in the send NetQueue, which converts the messages into a stream of bytes for the
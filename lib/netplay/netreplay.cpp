@@ -0,0 +1,312 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording and replaying the game queues, see netreplay.h.
+ */
+
+#include "lib/framework/frame.h"
+
+#include <physfs.h>
+#include <zlib.h>
+#include <vector>
+
+#include "netreplay.h"
+#include "netplay.h"
+#include "nettypes.h"
+#include "netqueue.h"
+
+#define REPLAY_MAGIC "WZREPLAY"
+#define REPLAY_MAGIC_LEN 8
+#define REPLAY_VERSION 1
+#define REPLAY_END_PLAYER 0xFF
+#define REPLAY_FLUSH_SIZE 65536         ///< Bytes of records to collect, before compressing them.
+
+static PHYSFS_file *saveFile = nullptr;
+static z_stream saveDeflate;
+static std::vector<uint8_t> saveBuffer;       ///< Records not compressed yet.
+static std::vector<uint8_t> saveCompressed;
+
+static bool replayLoaded = false;
+static bool replayEnded = false;
+static std::vector<uint8_t> loadData;         ///< The uncompressed records.
+static size_t loadPos = 0;
+static unsigned checkpointsChecked = 0;
+static unsigned checkpointsMismatched = 0;
+
+static void writeUint32(std::vector<uint8_t> &buf, uint32_t v)
+{
+	uint8_t bytes[4] = {uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v)};
+	buf.insert(buf.end(), bytes, bytes + 4);
+}
+
+static uint32_t readUint32(uint8_t const *bytes)
+{
+	return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+}
+
+/// Compresses and writes the buffered records. With Z_FINISH, also ends the zlib stream.
+static bool saveFlush(int flush)
+{
+	saveDeflate.next_in = saveBuffer.data();
+	saveDeflate.avail_in = saveBuffer.size();
+	int ret;
+	do
+	{
+		saveCompressed.resize(REPLAY_FLUSH_SIZE);
+		saveDeflate.next_out = saveCompressed.data();
+		saveDeflate.avail_out = saveCompressed.size();
+		ret = deflate(&saveDeflate, flush);
+		ASSERT_OR_RETURN(false, ret != Z_STREAM_ERROR, "zlib compression failed!");
+		size_t len = saveCompressed.size() - saveDeflate.avail_out;
+		if (len > 0 && PHYSFS_write(saveFile, saveCompressed.data(), len, 1) != 1)
+		{
+			debug(LOG_ERROR, "Could not write replay: %s", PHYSFS_getLastError());
+			return false;
+		}
+	}
+	while (saveDeflate.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+	ASSERT(saveDeflate.avail_in == 0, "zlib didn't compress everything!");
+	saveBuffer.clear();
+	return true;
+}
+
+bool NETreplaySaveStart(std::string const &filename, std::string const &settings)
+{
+	NETreplaySaveStop();
+
+	saveFile = PHYSFS_openWrite(filename.c_str());
+	if (saveFile == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open %s for writing the replay: %s", filename.c_str(), PHYSFS_getLastError());
+		return false;
+	}
+
+	std::vector<uint8_t> header(REPLAY_MAGIC, REPLAY_MAGIC + REPLAY_MAGIC_LEN);
+	writeUint32(header, REPLAY_VERSION);
+	writeUint32(header, settings.size());
+	header.insert(header.end(), settings.begin(), settings.end());
+	if (PHYSFS_write(saveFile, header.data(), header.size(), 1) != 1)
+	{
+		debug(LOG_ERROR, "Could not write replay: %s", PHYSFS_getLastError());
+		PHYSFS_close(saveFile);
+		saveFile = nullptr;
+		return false;
+	}
+
+	memset(&saveDeflate, 0, sizeof(saveDeflate));
+	int ret = deflateInit(&saveDeflate, 6);
+	ASSERT(ret == Z_OK, "deflateInit failed! Can't record the replay.");
+	if (ret != Z_OK)
+	{
+		PHYSFS_close(saveFile);
+		saveFile = nullptr;
+		return false;
+	}
+
+	saveBuffer.clear();
+	saveBuffer.reserve(REPLAY_FLUSH_SIZE + 1024);
+	debug(LOG_NET, "Recording replay to %s", filename.c_str());
+	return true;
+}
+
+void NETreplaySaveNetMessage(NetMessage const &message, uint8_t player)
+{
+	if (saveFile == nullptr)
+	{
+		return;
+	}
+
+	uint8_t header[NET_MESSAGE_MAX_HEADER];
+	size_t headerLen = message.rawHeader(header);
+	saveBuffer.push_back(player);
+	saveBuffer.insert(saveBuffer.end(), header, header + headerLen);
+	saveBuffer.insert(saveBuffer.end(), message.data.begin(), message.data.end());
+
+	if (saveBuffer.size() >= REPLAY_FLUSH_SIZE && !saveFlush(Z_NO_FLUSH))
+	{
+		debug(LOG_ERROR, "Stopped recording the replay.");
+		deflateEnd(&saveDeflate);
+		PHYSFS_close(saveFile);
+		saveFile = nullptr;
+	}
+}
+
+bool NETreplaySaveStop()
+{
+	if (saveFile == nullptr)
+	{
+		return false;
+	}
+
+	saveBuffer.push_back(REPLAY_END_PLAYER);
+	bool ok = saveFlush(Z_FINISH);
+	deflateEnd(&saveDeflate);
+	ok = PHYSFS_close(saveFile) != 0 && ok;
+	saveFile = nullptr;
+	saveBuffer = std::vector<uint8_t>();
+	saveCompressed = std::vector<uint8_t>();
+	return ok;
+}
+
+bool NETreplayLoadStart(std::string const &filename, std::string &settings)
+{
+	NETreplayLoadStop();
+
+	PHYSFS_file *file = PHYSFS_openRead(filename.c_str());
+	if (file == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open replay %s: %s", filename.c_str(), PHYSFS_getLastError());
+		return false;
+	}
+	PHYSFS_sint64 fileLen = PHYSFS_fileLength(file);
+	std::vector<uint8_t> fileData(std::max<PHYSFS_sint64>(fileLen, 0));
+	bool readOk = fileLen >= 0 && (fileData.empty() || PHYSFS_read(file, fileData.data(), fileData.size(), 1) == 1);
+	PHYSFS_close(file);
+	if (!readOk)
+	{
+		debug(LOG_ERROR, "Could not read replay %s: %s", filename.c_str(), PHYSFS_getLastError());
+		return false;
+	}
+
+	size_t headerLen = REPLAY_MAGIC_LEN + 4 + 4;
+	if (fileData.size() < headerLen || memcmp(fileData.data(), REPLAY_MAGIC, REPLAY_MAGIC_LEN) != 0)
+	{
+		debug(LOG_ERROR, "%s is not a replay.", filename.c_str());
+		return false;
+	}
+	uint32_t version = readUint32(&fileData[REPLAY_MAGIC_LEN]);
+	uint32_t settingsLen = readUint32(&fileData[REPLAY_MAGIC_LEN + 4]);
+	if (version != REPLAY_VERSION || fileData.size() - headerLen < settingsLen)
+	{
+		debug(LOG_ERROR, "Replay %s has unknown version %u, or is truncated.", filename.c_str(), version);
+		return false;
+	}
+	settings.assign(fileData.begin() + headerLen, fileData.begin() + headerLen + settingsLen);
+
+	z_stream zInflate;
+	memset(&zInflate, 0, sizeof(zInflate));
+	int ret = inflateInit(&zInflate);
+	ASSERT_OR_RETURN(false, ret == Z_OK, "inflateInit failed! Can't load the replay.");
+	zInflate.next_in = fileData.data() + headerLen + settingsLen;
+	zInflate.avail_in = fileData.size() - headerLen - settingsLen;
+	loadData.clear();
+	do
+	{
+		size_t used = loadData.size();
+		loadData.resize(std::max<size_t>(used * 2, REPLAY_FLUSH_SIZE));
+		zInflate.next_out = loadData.data() + used;
+		zInflate.avail_out = loadData.size() - used;
+		ret = inflate(&zInflate, Z_NO_FLUSH);
+		loadData.resize(loadData.size() - zInflate.avail_out);
+	}
+	while (ret == Z_OK && (zInflate.avail_in != 0 || zInflate.avail_out == 0));
+	inflateEnd(&zInflate);
+	if (ret != Z_STREAM_END)
+	{
+		// Probably the game crashed while recording. Replay as much as we have.
+		debug(LOG_WARNING, "Replay %s is truncated or corrupt, zlib error %d.", filename.c_str(), ret);
+	}
+
+	loadPos = 0;
+	replayLoaded = true;
+	replayEnded = false;
+	checkpointsChecked = 0;
+	checkpointsMismatched = 0;
+	debug(LOG_NET, "Loaded replay %s, %u bytes of game messages.", filename.c_str(), (unsigned)loadData.size());
+	return true;
+}
+
+bool NETreplayLoadNetMessages(unsigned player)
+{
+	if (!replayLoaded || replayEnded)
+	{
+		return false;
+	}
+
+	while (loadPos < loadData.size())
+	{
+		uint8_t recordPlayer = loadData[loadPos];
+		if (recordPlayer == REPLAY_END_PLAYER || recordPlayer >= MAX_PLAYERS || loadData.size() - loadPos < 3)
+		{
+			break;
+		}
+
+		NetMessage message(loadData[loadPos + 1]);
+		size_t pos = loadPos + 2;
+		uint32_t len = 0;
+		bool moreBytes = true;
+		for (unsigned n = 0; moreBytes && pos < loadData.size(); ++n, ++pos)
+		{
+			moreBytes = decode_uint32_t(loadData[pos], len, n);
+		}
+		if (moreBytes || loadData.size() - pos < len)
+		{
+			debug(LOG_WARNING, "Replay ends in the middle of a message.");
+			break;
+		}
+		message.data.assign(loadData.begin() + pos, loadData.begin() + pos + len);
+		loadPos = pos + len;
+
+		NETinsertMessageFromNet(NETgameQueue(recordPlayer), std::move(message));
+		if (recordPlayer == player)
+		{
+			return true;
+		}
+	}
+
+	debug(LOG_NET, "Replay ended.");
+	replayEnded = true;
+	loadData = std::vector<uint8_t>();
+	loadPos = 0;
+	return false;
+}
+
+void NETreplayLoadStop()
+{
+	replayLoaded = false;
+	replayEnded = false;
+	loadData = std::vector<uint8_t>();
+	loadPos = 0;
+}
+
+bool NETisReplay()
+{
+	return replayLoaded;
+}
+
+bool NETreplayLoadEnded()
+{
+	return replayLoaded && replayEnded;
+}
+
+void NETreplayCheckpoint(bool matched)
+{
+	if (!replayLoaded)
+	{
+		return;
+	}
+	++checkpointsChecked;
+	checkpointsMismatched += !matched;
+}
+
+void NETreplayCheckpoints(unsigned &checked, unsigned &mismatched)
+{
+	checked = checkpointsChecked;
+	mismatched = checkpointsMismatched;
+}
@@ -0,0 +1,55 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording and replaying the game queues.
+ *
+ *  Every GAME_* message is recorded in the order NETrecvGame gives it to the game, together with the player whose game
+ *  queue it came from. Since all players process game messages in the same order, feeding the recorded messages back
+ *  into the game queues re-simulates the game exactly. The GAME_GAME_TIME messages carry the CRCs of the sync debug
+ *  logs, so checkDebugSync verifies the replay as it goes, and dumps the logs on the first difference.
+ *
+ *  A replay file is "WZREPLAY", a version, the length of the settings and the settings, which the caller chooses, then
+ *  a zlib compressed list of (player, raw message) records, ending with a player of 0xFF.
+ */
+
+#ifndef __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
+#define __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
+
+#include "lib/framework/types.h"
+
+#include <string>
+
+class NetMessage;
+
+bool NETreplaySaveStart(std::string const &filename, std::string const &settings);  ///< Starts recording game messages.
+void NETreplaySaveNetMessage(NetMessage const &message, uint8_t player);            ///< Records a game message, if recording.
+bool NETreplaySaveStop();                                                           ///< Finishes and closes the recording, if any.
+
+bool NETreplayLoadStart(std::string const &filename, std::string &settings);  ///< Reads a replay, and returns its settings.
+bool NETreplayLoadNetMessages(unsigned player);  ///< Moves recorded messages into the game queues, until one for player is moved. Returns false if there are no more.
+void NETreplayLoadStop();
+bool NETisReplay();                              ///< True while a replay is loaded, even after all its messages were used.
+bool NETreplayLoadEnded();                       ///< True once all the recorded messages have been used.
+
+/// Counts a checked CRC of the sync debug logs, as reported by checkDebugSync.
+void NETreplayCheckpoint(bool matched);
+/// The number of CRCs checked and mismatched, since the replay was loaded.
+void NETreplayCheckpoints(unsigned &checked, unsigned &mismatched);
+
+#endif // __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
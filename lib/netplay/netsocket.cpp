@@ -84,11 +84,38 @@ static WZ_THREAD *socketThread = nullptr;
 static bool socketThreadQuit;
 typedef std::map<Socket *, std::vector<uint8_t> > SocketThreadWriteMap;
 static SocketThreadWriteMap socketThreadWrites;
+struct SocketThreadRead
+{
+	SocketReadFunction function;
+	void *context;
+};
+typedef std::map<Socket *, SocketThreadRead> SocketThreadReadMap;
+static SocketThreadReadMap socketThreadReads;         ///< Sockets read by the socket thread, see socketReadInThread().
+static bool socketThreadSleeping = false;             ///< True if the socket thread is waiting for socketThreadSemaphore, since there was nothing to read or write.
+static SOCKET socketThreadWakeFd = INVALID_SOCKET;    ///< UDP socket connected to itself. Writing to it makes select() return in the socket thread.
+
+#define SOCKET_THREAD_MAX_READS 16                    ///< Maximum number of reads from one socket, before giving other sockets a turn.
 
 
 static void socketCloseNow(Socket *sock);
 
 
+/// Makes the socket thread notice new data to write, or new sockets to read. Called with socketThreadMutex locked.
+static void socketThreadWake()
+{
+	if (socketThreadSleeping)
+	{
+		socketThreadSleeping = false;
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+	else if (socketThreadWakeFd != INVALID_SOCKET)
+	{
+		char byte = 0;
+		send(socketThreadWakeFd, &byte, 1, 0);
+	}
+}
+
+
 bool socketReadReady(Socket const *sock)
 {
 	return sock->ready;
@@ -371,6 +398,40 @@ static bool connectionIsOpen(Socket *sock)
 	return true;
 }
 
+/// Reads whatever has arrived on a socket read by the socket thread, and passes it on. Returns false if the socket is disconnected, and shouldn't be read any more. Called with socketThreadMutex locked.
+static bool socketThreadRead(Socket *sock, SocketThreadRead const &read)
+{
+	static uint8_t buffer[16384];
+
+	for (unsigned reads = 0; reads < SOCKET_THREAD_MAX_READS; ++reads)
+	{
+		size_t rawBytes = 0;
+		ssize_t size = readNoInt(sock, buffer, sizeof(buffer), &rawBytes);
+		if (size == SOCKET_ERROR && (getSockErr() == EAGAIN || getSockErr() == EWOULDBLOCK))
+		{
+			break;  // Read everything there was.
+		}
+		if (size == SOCKET_ERROR || (size == 0 && socketReadDisconnected(sock)))
+		{
+			if (size == 0)
+			{
+				debug(LOG_NET, "Connection closed from the other side, socket %p", sock);
+			}
+			else
+			{
+				debug(LOG_NET, "%s, socket %p is now invalid", strSockError(getSockErr()), sock);
+			}
+			read.function(read.context, nullptr, 0, 0, true);
+			return false;
+		}
+		if (size > 0 || rawBytes > 0)
+		{
+			read.function(read.context, buffer, size, rawBytes, false);
+		}
+	}
+	return true;
+}
+
 static int socketThreadFunction(void *)
 {
 	wzMutexLock(socketThreadMutex);
@@ -381,25 +442,66 @@ static int socketThreadFunction(void *)
 #elif defined(WZ_OS_WIN)
 		SOCKET maxfd = 0;
 #endif
-		fd_set fds;
-		FD_ZERO(&fds);
+		fd_set readFds;
+		fd_set writeFds;
+		FD_ZERO(&readFds);
+		FD_ZERO(&writeFds);
+		if (socketThreadWakeFd != INVALID_SOCKET)
+		{
+			maxfd = std::max(maxfd, socketThreadWakeFd);
+			FD_SET(socketThreadWakeFd, &readFds);
+		}
+		bool haveDecompressedData = false;
+		for (SocketThreadReadMap::iterator i = socketThreadReads.begin(); i != socketThreadReads.end(); ++i)
+		{
+			Socket *sock = i->first;
+			haveDecompressedData = haveDecompressedData || (sock->isCompressed && !sock->zInflateNeedInput);
+			SOCKET fd = sock->fd[SOCK_CONNECTION];
+			maxfd = std::max(maxfd, fd);
+			FD_SET(fd, &readFds);
+		}
 		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
 		{
 			if (!i->second.empty())
 			{
 				SOCKET fd = i->first->fd[SOCK_CONNECTION];
 				maxfd = std::max(maxfd, fd);
-				ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
-				FD_SET(fd, &fds);
+				ASSERT(!FD_ISSET(fd, &writeFds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
+				FD_SET(fd, &writeFds);
 			}
 		}
-		struct timeval tv = {0, 50 * 1000};
+		// Don't wait, if zlib already has data for us.
+		struct timeval tv = {0, haveDecompressedData ? 0 : 50 * 1000};
 
-		// Check if we can write to any sockets.
+		// Check if we can read from or write to any sockets.
 		wzMutexUnlock(socketThreadMutex);
-		int ret = select(maxfd + 1, nullptr, &fds, nullptr, &tv);
+		int ret = select(maxfd + 1, &readFds, &writeFds, nullptr, &tv);
 		wzMutexLock(socketThreadMutex);
 
+		if (ret > 0 && socketThreadWakeFd != INVALID_SOCKET && FD_ISSET(socketThreadWakeFd, &readFds))
+		{
+			char bytes[64];
+			while (recv(socketThreadWakeFd, bytes, sizeof(bytes), 0) > 0)
+			{}
+		}
+
+		// We can read from some sockets. (Ignore errors from select, as for writing.)
+		if (ret > 0 || haveDecompressedData)
+		{
+			for (SocketThreadReadMap::iterator i = socketThreadReads.begin(); i != socketThreadReads.end();)
+			{
+				SocketThreadReadMap::iterator r = i;
+				++i;
+
+				Socket *sock = r->first;
+				bool ready = (ret > 0 && FD_ISSET(sock->fd[SOCK_CONNECTION], &readFds)) || (sock->isCompressed && !sock->zInflateNeedInput);
+				if (ready && !socketThreadRead(sock, r->second))
+				{
+					socketThreadReads.erase(r);  // Socket disconnected, don't try reading from it again.
+				}
+			}
+		}
+
 		// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
 		if (ret > 0)
 		{
@@ -412,7 +514,7 @@ static int socketThreadFunction(void *)
 				std::vector<uint8_t> &writeQueue = w->second;
 				ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
 
-				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
+				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &writeFds))
 				{
 					continue;  // This socket is not ready for writing, or we don't have anything to write.
 				}
@@ -470,9 +572,10 @@ static int socketThreadFunction(void *)
 			}
 		}
 
-		if (socketThreadWrites.empty())
+		if (socketThreadWrites.empty() && socketThreadReads.empty())
 		{
 			// Nothing to do, expect to wait.
+			socketThreadSleeping = true;
 			wzMutexUnlock(socketThreadMutex);
 			wzSemaphoreWait(socketThreadSemaphore);
 			wzMutexLock(socketThreadMutex);
@@ -548,7 +651,8 @@ ssize_t readNoInt(Socket *sock, void *buf, size_t max_size, size_t *rawByteCount
 		if (err != nullptr)
 		{
 			debug(LOG_ERROR, "Couldn't decompress data from socket. zlib error %s", err);
-			return -1;  // Bad data!
+			setSockErr(ECONNRESET);  // Bad data! Treat it as a broken connection, there's no way to resynchronise the stream.
+			return SOCKET_ERROR;
 		}
 
 		if (sock->zInflate.avail_out != 0)
@@ -589,6 +693,12 @@ bool socketReadDisconnected(Socket *sock)
  * @return @c size when successful or @c SOCKET_ERROR if an error occurred.
  */
 ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCount)
+{
+	SocketSlice slice = {buf, size};
+	return writeAllSlices(sock, &slice, 1, rawByteCount);
+}
+
+ssize_t writeAllSlices(Socket *sock, SocketSlice const *slices, size_t numSlices, size_t *rawByteCount)
 {
 	size_t ignored;
 	size_t &rawBytes = rawByteCount != nullptr ? *rawByteCount : ignored;
@@ -606,41 +716,55 @@ ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCoun
 		return SOCKET_ERROR;
 	}
 
+	size_t size = 0;
+	for (size_t n = 0; n < numSlices; ++n)
+	{
+		size += slices[n].size;
+	}
+
 	if (size > 0)
 	{
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
+			if (socketThreadWrites.find(sock) == socketThreadWrites.end())
 			{
-				wzSemaphorePost(socketThreadSemaphore);
+				socketThreadWake();
 			}
 			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
+			writeQueue.reserve(writeQueue.size() + size);
+			for (size_t n = 0; n < numSlices; ++n)
+			{
+				char const *data = static_cast<char const *>(slices[n].data);
+				writeQueue.insert(writeQueue.end(), data, data + slices[n].size);
+			}
 			wzMutexUnlock(socketThreadMutex);
 			rawBytes = size;
 		}
 		else
 		{
-			sock->zDeflate.next_in = (Bytef *)buf;
-			sock->zDeflate.avail_in = size;
-			sock->zDeflateInSize += sock->zDeflate.avail_in;
-			do
+			for (size_t n = 0; n < numSlices; ++n)
 			{
-				size_t alreadyHave = sock->zDeflateOutBuf.size();
-				sock->zDeflateOutBuf.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
-				sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
-				sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
+				sock->zDeflate.next_in = (Bytef *)slices[n].data;
+				sock->zDeflate.avail_in = slices[n].size;
+				sock->zDeflateInSize += sock->zDeflate.avail_in;
+				do
+				{
+					size_t alreadyHave = sock->zDeflateOutBuf.size();
+					sock->zDeflateOutBuf.resize(alreadyHave + slices[n].size + 20);  // A bit more than size should be enough to always do everything in one go.
+					sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
+					sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
 
-				int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
-				ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+					int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
+					ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
 
-				// Remove unused part of buffer.
-				sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
-			}
-			while (sock->zDeflate.avail_out == 0);
+					// Remove unused part of buffer.
+					sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
+				}
+				while (sock->zDeflate.avail_out == 0);
 
-			ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+				ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+			}
 		}
 	}
 
@@ -682,9 +806,9 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	}
 
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
+	if (socketThreadWrites.find(sock) == socketThreadWrites.end())
 	{
-		wzSemaphorePost(socketThreadSemaphore);
+		socketThreadWake();
 	}
 	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
 	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
@@ -731,6 +855,16 @@ void socketBeginCompression(Socket *sock)
 	wzMutexUnlock(socketThreadMutex);
 }
 
+void socketReadInThread(Socket *sock, SocketReadFunction function, void *context)
+{
+	wzMutexLock(socketThreadMutex);
+	SocketThreadRead &read = socketThreadReads[sock];
+	read.function = function;
+	read.context = context;
+	socketThreadWake();
+	wzMutexUnlock(socketThreadMutex);
+}
+
 Socket::~Socket()
 {
 	if (isCompressed)
@@ -1019,6 +1153,7 @@ static void socketCloseNow(Socket *sock)
 void socketClose(Socket *sock)
 {
 	wzMutexLock(socketThreadMutex);
+	socketThreadReads.erase(sock);
 	//Instead of socketThreadWrites.erase(sock);, try sending the data before actually deleting.
 	if (socketThreadWrites.find(sock) != socketThreadWrites.end())
 	{
@@ -1100,6 +1235,26 @@ Socket *socketAccept(Socket *sock)
 	return nullptr;
 }
 
+Socket *socketFromDescriptor(SOCKET fd)
+{
+	Socket *conn = new Socket;
+	for (unsigned i = 0; i < ARRAY_SIZE(conn->fd); ++i)
+	{
+		conn->fd[i] = INVALID_SOCKET;
+	}
+	conn->fd[SOCK_CONNECTION] = fd;
+	conn->textAddress[0] = '\0';
+
+	if (!setSocketBlocking(fd, false))
+	{
+		debug(LOG_NET, "Couldn't set socket (%p) blocking status (false).  Closing.", conn);
+		socketClose(conn);
+		return nullptr;
+	}
+	socketBlockSIGPIPE(fd, true);
+	return conn;
+}
+
 Socket *socketOpen(const SocketAddress *addr, unsigned timeout)
 {
 	unsigned int i;
@@ -1438,6 +1593,39 @@ void deleteSocketAddress(SocketAddress *addr)
 	freeaddrinfo(addr);
 }
 
+/// Opens socketThreadWakeFd. If it fails, the socket thread still notices new work, but only after up to 50ms.
+static void socketThreadWakeOpen()
+{
+	SOCKET fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd == INVALID_SOCKET)
+	{
+		debug(LOG_WARNING, "Failed to create socket for waking the socket thread: %s", strSockError(getSockErr()));
+		return;
+	}
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	socklen_t addrLen = sizeof(addr);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR
+	    || getsockname(fd, (struct sockaddr *)&addr, &addrLen) == SOCKET_ERROR
+	    || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR
+	    || !setSocketBlocking(fd, false))
+	{
+		debug(LOG_WARNING, "Failed to set up socket for waking the socket thread: %s", strSockError(getSockErr()));
+#if defined(WZ_OS_WIN)
+		closesocket(fd);
+#else
+		close(fd);
+#endif
+		return;
+	}
+
+	socketThreadWakeFd = fd;
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // setup stuff
 void SOCKETinit()
@@ -1471,6 +1659,7 @@ void SOCKETinit()
 	if (socketThread == nullptr)
 	{
 		socketThreadQuit = false;
+		socketThreadWakeOpen();
 		socketThreadMutex = wzMutexCreate();
 		socketThreadSemaphore = wzSemaphoreCreate(0);
 		socketThread = wzThreadCreate(socketThreadFunction, nullptr);
@@ -1485,12 +1674,23 @@ void SOCKETshutdown()
 		wzMutexLock(socketThreadMutex);
 		socketThreadQuit = true;
 		socketThreadWrites.clear();
+		socketThreadReads.clear();
 		wzMutexUnlock(socketThreadMutex);
 		wzSemaphorePost(socketThreadSemaphore);  // Wake up the thread, so it can quit.
 		wzThreadJoin(socketThread);
 		wzMutexDestroy(socketThreadMutex);
 		wzSemaphoreDestroy(socketThreadSemaphore);
 		socketThread = nullptr;
+		socketThreadSleeping = false;
+		if (socketThreadWakeFd != INVALID_SOCKET)
+		{
+#if defined(WZ_OS_WIN)
+			closesocket(socketThreadWakeFd);
+#else
+			close(socketThreadWakeFd);
+#endif
+			socketThreadWakeFd = INVALID_SOCKET;
+		}
 	}
 
 #if defined(WZ_OS_WIN)
@@ -74,6 +74,16 @@ struct Socket;
 struct SocketSet;
 typedef struct addrinfo SocketAddress;
 
+/// Called on the socket thread, with data read from a Socket given to socketReadInThread(). size is the number of bytes after decompression, and rawSize the number of bytes actually received. Called with disconnected true if the connection was closed or broken, after which it isn't called again.
+typedef void (*SocketReadFunction)(void *context, uint8_t const *data, size_t size, size_t rawSize, bool disconnected);
+
+/// A piece of the data given to writeAllSlices().
+struct SocketSlice
+{
+	const void *data;
+	size_t size;
+};
+
 #ifndef WZ_OS_WIN
 static const int SOCKET_ERROR = -1;
 #endif
@@ -96,6 +106,7 @@ WZ_DECL_NONNULL(1) void deleteSocketAddress(SocketAddress *addr);       ///< Des
 Socket *socketOpen(const SocketAddress *addr, unsigned timeout);        ///< Opens a Socket, using the first address in addr.
 Socket *socketListen(unsigned int port);                                ///< Creates a listen-only Socket, which listens for incoming connections.
 WZ_DECL_NONNULL(1) Socket *socketAccept(Socket *sock);                  ///< Accepts an incoming Socket connection from a listening Socket.
+Socket *socketFromDescriptor(SOCKET fd);                                ///< Makes a Socket of a descriptor that is already connected, such as one end of a socketpair(). The Socket owns the descriptor.
 WZ_DECL_NONNULL(1) void socketClose(Socket *sock);                      ///< Destroys the Socket.
 Socket *socketOpenAny(const SocketAddress *addr, unsigned timeout);     ///< Opens a Socket, using the first address that works in addr.
 size_t socketArrayOpen(Socket **sockets, size_t maxSockets, const SocketAddress *addr, unsigned timeout);  ///< Opens up to maxSockets Sockets, of the types listed in addr.
@@ -109,12 +120,17 @@ WZ_DECL_NONNULL(1, 2)
 ssize_t readAll(Socket *sock, void *buf, size_t size, unsigned timeout);///< Reads exactly size bytes from the Socket, or blocks until the timeout expires.
 WZ_DECL_NONNULL(1, 2)
 ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCount = nullptr);  ///< Nonblocking write of size bytes to the Socket. All bytes will be written asynchronously, by a separate thread. Raw count of bytes (after compression) returned in rawByteCount, which will often be 0 until the socket is flushed.
+WZ_DECL_NONNULL(1, 2)
+ssize_t writeAllSlices(Socket *sock, SocketSlice const *slices, size_t numSlices, size_t *rawByteCount = nullptr);  ///< Same as writeAll, but writes the slices one after another, without first copying them into one buffer. Returns the total size.
 
 // Sockets, compressed.
 WZ_DECL_NONNULL(1) void socketBeginCompression(Socket *sock); ///< Makes future data sent compressed, and future data received expected to be compressed.
 WZ_DECL_NONNULL(1) bool socketReadDisconnected(Socket *sock);  ///< If readNoInt returned 0, returns true if this is the result of a disconnect, or false if the input compressed data just hasn't produced any output bytes.
 WZ_DECL_NONNULL(1) void socketFlush(Socket *sock, size_t *rawByteCount = nullptr); ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective. Raw count of bytes (after compression) returned in rawByteCount.
 
+// Sockets read by the socket thread.
+WZ_DECL_NONNULL(1, 2) void socketReadInThread(Socket *sock, SocketReadFunction function, void *context);  ///< Makes the socket thread read and decompress everything arriving on the Socket, and pass it to function, until the Socket is closed. Don't read the Socket or check it with checkSockets() afterwards.
+
 // Socket sets.
 WZ_DECL_ALLOCATION SocketSet *allocSocketSet();                         ///< Constructs a SocketSet.
 WZ_DECL_NONNULL(1) void deleteSocketSet(SocketSet *set);                ///< Destroys the SocketSet.
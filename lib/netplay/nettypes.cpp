@@ -39,8 +39,10 @@
 #include "nettypes.h"
 #include "netqueue.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "src/order.h"
 #include <cstring>
+#include <map>
 
 /// There is a game queue representing each player. The game queues are synchronised among all players, so that all players process the same game queue
 /// messages at the same game time. The game queues should be used, even in single-player. Players should write to their own queue, not to other player's
@@ -57,10 +59,18 @@ static NetQueuePair *tmpQueues[MAX_TMP_SOCKETS] = {nullptr, nullptr, nullptr, nu
 /// Sending a message to the broadcast queue is equivalent to sending the message to the net queues of all other players.
 static NetQueue *broadcastQueue = nullptr;
 
+/// The last values of the fields (de)serialised with NETdeltaUint32, for each game queue, indexed by message type << 8 | field. Messages are decoded in
+/// the same order as they were encoded, so the encoder and decoders always agree on the last values. Our own messages are decoded some time after being
+/// encoded, so the values encoded and decoded are kept separately.
+static std::map<uint16_t, uint32_t> deltaEncoded[MAX_PLAYERS];
+static std::map<uint16_t, uint32_t> deltaDecoded[MAX_PLAYERS];
+/// Whether NETdeltaUint32 sends differences or plain values, see NETsetDeltaEncoding().
+static bool deltaEncoding = true;
+
 // Only used between NETbegin{Encode,Decode} and NETend calls.
 static MessageWriter writer;  ///< Used when serialising a message.
 static MessageReader reader;  ///< Used when deserialising a message.
-static NetMessage message;    ///< A message which is being serialised or deserialised.
+static NetMessage message;    ///< A message which is being serialised.
 static NETQUEUE queueInfo;    ///< Indicates which queue is currently being (de)serialised.
 static PACKETDIR NetDir;      ///< Indicates whether a message is being serialised (PACKET_ENCODE) or deserialised (PACKET_DECODE), or not doing anything (PACKET_INVALID).
 
@@ -377,6 +387,16 @@ void NETinsertMessageFromNet(NETQUEUE queue, NetMessage const *message)
 	receiveQueue(queue)->pushMessage(*message);
 }
 
+void NETinsertMessageFromNet(NETQUEUE queue, NetMessage &&message)
+{
+	receiveQueue(queue)->pushMessage(std::move(message));
+}
+
+void NETtakeIncompleteRawData(NETQUEUE queue, NetMessageSplitter &splitter)
+{
+	receiveQueue(queue)->takeIncompleteRawData(splitter);
+}
+
 bool NETisMessageReady(NETQUEUE queue)
 {
 	return receiveQueue(queue)->haveMessage();
@@ -404,6 +424,8 @@ void NETinitQueue(NETQUEUE queue)
 	{
 		delete gameQueues[queue.index];
 		gameQueues[queue.index] = new NetQueue;
+		deltaEncoded[queue.index].clear();
+		deltaDecoded[queue.index].clear();
 		return;
 	}
 	else
@@ -448,6 +470,11 @@ void NETbeginEncode(NETQUEUE queue, uint8_t type)
 	queueInfo = queue;
 	message = type;
 	writer = MessageWriter(message);
+	if (type == GAME_PLAYER_LEFT && (queue.queueType == QUEUE_GAME || queue.queueType == QUEUE_GAME_FORCED) && queue.index < MAX_PLAYERS)
+	{
+		// Someone else may send the following messages in this game queue, and they won't know the last values.
+		deltaEncoded[queue.index].clear();
+	}
 }
 
 void NETbeginDecode(NETQUEUE queue, uint8_t type)
@@ -455,10 +482,16 @@ void NETbeginDecode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_DECODE);
 
 	queueInfo = queue;
-	message = receiveQueue(queueInfo)->getMessage();
-	reader = MessageReader(message);
+	// Read the message where it is in the queue, it stays there until NETpop().
+	NetMessage const &received = receiveQueue(queueInfo)->getMessage();
+	reader = MessageReader(received);
+
+	assert(type == received.type);
 
-	assert(type == message.type);
+	if (type == GAME_PLAYER_LEFT && queue.queueType == QUEUE_GAME)
+	{
+		deltaDecoded[queue.index].clear();  // See NETbeginEncode.
+	}
 }
 
 bool NETend()
@@ -466,6 +499,13 @@ bool NETend()
 	// If we are encoding just return true
 	if (NETgetPacketDir() == PACKET_ENCODE)
 	{
+		if ((queueInfo.queueType == QUEUE_GAME || queueInfo.queueType == QUEUE_GAME_FORCED) && NETisReplay())
+		{
+			// Only the recorded game messages may change the game, when replaying.
+			NETsetPacketDir(PACKET_INVALID);
+			return true;
+		}
+
 		// Push the message onto the list.
 		NetQueue *queue = sendQueue(queueInfo);
 		if (queue == nullptr) {
@@ -605,6 +645,51 @@ void NETint32_t(int32_t *ip)
 	queueAuto(*ip);
 }
 
+void NETdeltaUint32(uint32_t *ip, uint8_t field)
+{
+	bool isGame = (queueInfo.queueType == QUEUE_GAME || queueInfo.queueType == QUEUE_GAME_FORCED) && queueInfo.index < MAX_PLAYERS;
+	ASSERT(isGame, "Only game queues remember the last values.");
+	uint8_t type = NETgetPacketDir() == PACKET_ENCODE ? message.type : receiveQueue(queueInfo)->getMessage().type;
+	uint32_t ignored = 0;
+	uint32_t &last = isGame ? (NETgetPacketDir() == PACKET_ENCODE ? deltaEncoded : deltaDecoded)[queueInfo.index][type << 8 | field] : ignored;
+
+	if (!deltaEncoding)
+	{
+		queueAuto(*ip);
+		return;
+	}
+
+	int32_t delta = *ip - last;
+	queueAuto(delta);
+	if (NETgetPacketDir() == PACKET_DECODE)
+	{
+		*ip = last + delta;
+	}
+	last = *ip;
+}
+
+void NETdeltaInt32(int32_t *ip, uint8_t field)
+{
+	uint32_t v = *ip;
+	NETdeltaUint32(&v, field);
+	*ip = v;
+}
+
+void NETsetDeltaEncoding(bool enable)
+{
+	deltaEncoding = enable;
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		deltaEncoded[player].clear();
+		deltaDecoded[player].clear();
+	}
+}
+
+bool NETgetDeltaEncoding()
+{
+	return deltaEncoding;
+}
+
 void NETuint32_t(uint32_t *ip)
 {
 	queueAuto(*ip);
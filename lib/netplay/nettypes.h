@@ -65,6 +65,8 @@ NETQUEUE NETbroadcastQueue(unsigned excludePlayer = NET_NO_EXCLUDE);  ///< The q
 
 void NETinsertRawData(NETQUEUE queue, uint8_t *data, size_t dataLen);  ///< Dump raw data from sockets and raw data sent via host here.
 void NETinsertMessageFromNet(NETQUEUE queue, NetMessage const *message);     ///< Dump whole NetMessages into the queue.
+void NETinsertMessageFromNet(NETQUEUE queue, NetMessage &&message);          ///< Dump whole NetMessages into the queue, without copying them.
+void NETtakeIncompleteRawData(NETQUEUE queue, NetMessageSplitter &splitter);  ///< Moves raw data not yet forming a whole message out of the queue, for when the rest of the raw data will be split elsewhere.
 bool NETisMessageReady(NETQUEUE queue);       ///< Returns true if there is a complete message ready to deserialise in this queue.
 NetMessage const *NETgetMessage(NETQUEUE queue);///< Returns the current message in the queue which is ready to be deserialised. Do not delete the message.
 
@@ -84,6 +86,10 @@ void NETint16_t(int16_t *ip);
 void NETuint16_t(uint16_t *ip);
 void NETint32_t(int32_t *ip);         ///< Encodes small values (< 836 288) in at most 3 bytes, large values (≥ 22 888 448) in 5 bytes.
 void NETuint32_t(uint32_t *ip);       ///< Encodes small values (< 1 672 576) in at most 3 bytes, large values (≥ 45 776 896) in 5 bytes.
+void NETdeltaUint32(uint32_t *ip, uint8_t field);  ///< Encodes the difference from the value of the same field in the previous message of this type in this game queue. Only for game queues.
+void NETdeltaInt32(int32_t *ip, uint8_t field);    ///< Same as NETdeltaUint32.
+void NETsetDeltaEncoding(bool enable);             ///< Whether NETdeltaUint32 sends differences, or the plain values. All players must agree, so set from the game options before the game queues are used.
+bool NETgetDeltaEncoding();
 void NETint64_t(int64_t *ip);
 void NETuint64_t(uint64_t *ip);
 void NETbool(bool *bp);
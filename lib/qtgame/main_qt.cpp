@@ -45,6 +45,16 @@ void wzMain(int &argc, char **argv)
 {
 	debug(LOG_MAIN, "Qt initialization");
 
+	// The command line is not parsed yet, so check for --headless here, like the SDL backend does.
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			debug(LOG_ERROR, "Headless mode needs the SDL backend.");
+			exit(1);
+		}
+	}
+
 	appPtr = new QApplication(argc, argv);
 }
 
@@ -499,6 +499,10 @@ void wzToggleFullscreen()
 
 bool wzIsFullscreen()
 {
+	if (wz_headless)
+	{
+		return false;
+	}
 	assert(WZwindow != nullptr);
 	Uint32 flags = SDL_GetWindowFlags(WZwindow);
 	if ((flags & SDL_WINDOW_FULLSCREEN) || (flags & SDL_WINDOW_FULLSCREEN_DESKTOP))
@@ -514,6 +518,10 @@ bool wzIsFullscreen()
 
 bool wzIsMaximized()
 {
+	if (wz_headless)
+	{
+		return false;
+	}
 	assert(WZwindow != nullptr);
 	Uint32 flags = SDL_GetWindowFlags(WZwindow);
 	if (flags & SDL_WINDOW_MAXIMIZED)
@@ -1299,7 +1307,21 @@ static void inputHandleMouseMotionEvent(SDL_MouseMotionEvent *motionEvent)
 void wzMain(int &argc, char **argv)
 {
 	initKeycodes();
-	appPtr = new QApplication(argc, argv);
+
+	// The command line is not parsed yet, but QApplication needs a display, so check for --headless here.
+	bool headless = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		headless = headless || strcmp(argv[i], "--headless") == 0;
+	}
+	if (headless)
+	{
+		appPtr = new QCoreApplication(argc, argv);
+	}
+	else
+	{
+		appPtr = new QApplication(argc, argv);
+	}
 }
 
 #define MIN_WZ_GAMESCREEN_WIDTH 640
@@ -1591,8 +1613,11 @@ void wzGetWindowResolution(int *screen, unsigned int *width, unsigned int *heigh
 		*screen = screenIndex;
 	}
 
-	int currentWidth = 0, currentHeight = 0;
-	SDL_GetWindowSize(WZwindow, &currentWidth, &currentHeight);
+	int currentWidth = windowWidth, currentHeight = windowHeight;
+	if (!wz_headless)
+	{
+		SDL_GetWindowSize(WZwindow, &currentWidth, &currentHeight);
+	}
 	assert(currentWidth >= 0);
 	assert(currentHeight >= 0);
 	if (width != nullptr)
@@ -1616,6 +1641,22 @@ bool wzMainScreenSetup(int antialiasing, bool fullscreen, bool vsync, bool highD
 	int height = pie_GetVideoBufferHeight();
 	int bitDepth = pie_GetVideoBufferDepth();
 
+	if (wz_headless)
+	{
+		// No window or OpenGL context, but keep a game screen of the configured size for the interface code.
+		if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+		{
+			debug(LOG_ERROR, "Error: Could not initialise SDL (%s).", SDL_GetError());
+			return false;
+		}
+		setDisplayScale(100);
+		screenWidth = windowWidth = MAX(width, MIN_WZ_GAMESCREEN_WIDTH);
+		screenHeight = windowHeight = MAX(height, MIN_WZ_GAMESCREEN_HEIGHT);
+		pie_SetVideoBufferWidth(screenWidth);
+		pie_SetVideoBufferHeight(screenHeight);
+		return true;
+	}
+
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0)
 	{
 		debug(LOG_ERROR, "Error: Could not initialise SDL (%s).", SDL_GetError());
@@ -1917,6 +1958,18 @@ bool wzMainScreenSetup(int antialiasing, bool fullscreen, bool vsync, bool highD
 //
 void wzGetWindowToRendererScaleFactor(float *horizScaleFactor, float *vertScaleFactor)
 {
+	if (wz_headless)
+	{
+		if (horizScaleFactor != nullptr)
+		{
+			*horizScaleFactor = current_displayScaleFactor;
+		}
+		if (vertScaleFactor != nullptr)
+		{
+			*vertScaleFactor = current_displayScaleFactor;
+		}
+		return;
+	}
 	assert(WZwindow != nullptr);
 
 	// Obtain the window context's drawable size in pixels
@@ -2139,8 +2192,11 @@ void wzMainEventLoop(void)
 void wzShutdown()
 {
 	// order is important!
-	sdlFreeCursors();
-	SDL_DestroyWindow(WZwindow);
+	if (!wz_headless)
+	{
+		sdlFreeCursors();
+		SDL_DestroyWindow(WZwindow);
+	}
 	SDL_Quit();
 	appPtr->quit();
 	delete appPtr;
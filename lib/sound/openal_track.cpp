@@ -440,94 +440,75 @@ bool sound_QueueSamplePlaying(void)
 	return false;
 }
 
-/** Decodes an opened OggVorbis file into an OpenAL buffer
- *  \param psTrack pointer to object which will contain the final buffer
- *  \param PHYSFS_fileHandle file handle given by PhysicsFS to the opened file
- *  \return on success the psTrack pointer, otherwise it will be free'd and a NULL pointer is returned instead
- */
-static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHYSFS_fileHandle)
+soundDataBuffer *sound_DecodeTrackFromFile(const char *fileName)
 {
-	ALenum		format;
-	ALuint		buffer;
 	struct OggVorbisDecoderState *decoder;
 	soundDataBuffer	*soundBuffer;
+	PHYSFS_file *fileHandle;
 
-	if (!openal_initialized)
+	// Use PhysicsFS to open the file
+	fileHandle = PHYSFS_openRead(fileName);
+	debug(LOG_NEVER, "Reading...[directory: %s] %s", PHYSFS_getRealDir(fileName), fileName);
+	if (fileHandle == nullptr)
 	{
+		debug(LOG_ERROR, "sound_DecodeTrackFromFile: PHYSFS_openRead(\"%s\") failed with error: %s\n", fileName, PHYSFS_getLastError());
 		return nullptr;
 	}
 
-	decoder = sound_CreateOggVorbisDecoder(PHYSFS_fileHandle, true);
+	decoder = sound_CreateOggVorbisDecoder(fileHandle, true);
 	if (decoder == nullptr)
 	{
 		debug(LOG_WARNING, "Failed to open audio file for decoding");
-		free(psTrack);
+		PHYSFS_close(fileHandle);
 		return nullptr;
 	}
 
 	soundBuffer = sound_DecodeOggVorbis(decoder, 0);
 	sound_DestroyOggVorbisDecoder(decoder);
+	PHYSFS_close(fileHandle);
 
 	if (soundBuffer == nullptr)
 	{
-		free(psTrack);
 		return nullptr;
 	}
 
 	if (soundBuffer->size == 0)
 	{
-		debug(LOG_WARNING, "sound_DecodeOggVorbisTrack: OggVorbis track is entirely empty after decoding");
+		debug(LOG_WARNING, "sound_DecodeTrackFromFile: OggVorbis track is entirely empty after decoding");
 // NOTE: I'm not entirely sure if a track that's empty after decoding should be
 //       considered an error condition. Therefore I'll only error out on DEBUG
 //       builds. (Returning NULL here __will__ result in a program termination.)
 #ifdef DEBUG
 		free(soundBuffer);
-		free(psTrack);
 		return NULL;
 #endif
 	}
 
-	// Determine PCM data format
-	format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-	// Create an OpenAL buffer and fill it with the decoded data
-	alGenBuffers(1, &buffer);
-	sound_GetError();
-	alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-	sound_GetError();
-
-	free(soundBuffer);
-
-	// save buffer name in track
-	psTrack->iBufferName = buffer;
-
-	return psTrack;
+	return soundBuffer;
 }
 
 //*
 // =======================================================================================================================
 // =======================================================================================================================
 //
-TRACK *sound_LoadTrackFromFile(const char *fileName)
+TRACK *sound_CreateTrack(soundDataBuffer *soundBuffer)
 {
 	TRACK *pTrack;
-	PHYSFS_file *fileHandle;
 	size_t filename_size;
 	char *track_name;
+	ALenum		format;
+	ALuint		buffer;
 
-	// Use PhysicsFS to open the file
-	fileHandle = PHYSFS_openRead(fileName);
-	debug(LOG_NEVER, "Reading...[directory: %s] %s", PHYSFS_getRealDir(fileName), fileName);
-	if (fileHandle == nullptr)
+	if (!openal_initialized)
 	{
-		debug(LOG_ERROR, "sound_LoadTrackFromFile: PHYSFS_openRead(\"%s\") failed with error: %s\n", fileName, PHYSFS_getLastError());
+		free(soundBuffer);
 		return nullptr;
 	}
 
 	if (GetLastResourceFilename() == nullptr)
 	{
 		// This is a non fatal error.  We just can't find filename for some reason.
-		debug(LOG_WARNING, "sound_LoadTrackFromFile: missing resource filename?");
+		debug(LOG_WARNING, "sound_CreateTrack: missing resource filename?");
 		filename_size = 0;
 	}
 	else
@@ -560,13 +541,33 @@ TRACK *sound_LoadTrackFromFile(const char *fileName)
 	}
 	pTrack->fileName = track_name;
 
-	// Now use sound_ReadTrackFromBuffer to decode the file's contents
-	pTrack = sound_DecodeOggVorbisTrack(pTrack, fileHandle);
+	// Determine PCM data format
+	format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+
+	// Create an OpenAL buffer and fill it with the decoded data
+	alGenBuffers(1, &buffer);
+	sound_GetError();
+	alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
+	sound_GetError();
+
+	free(soundBuffer);
+
+	// save buffer name in track
+	pTrack->iBufferName = buffer;
 
-	PHYSFS_close(fileHandle);
 	return pTrack;
 }
 
+TRACK *sound_LoadTrackFromFile(const char *fileName)
+{
+	soundDataBuffer *soundBuffer = sound_DecodeTrackFromFile(fileName);
+	if (soundBuffer == nullptr)
+	{
+		return nullptr;
+	}
+	return sound_CreateTrack(soundBuffer);
+}
+
 void sound_FreeTrack(TRACK *psTrack)
 {
 	alDeleteBuffers(1, &psTrack->iBufferName);
@@ -43,6 +43,7 @@
 
 typedef bool (* AUDIO_CALLBACK)(void *psObj);
 struct AUDIO_STREAM;
+struct soundDataBuffer;
 
 /* structs */
 
@@ -85,6 +86,10 @@ bool	sound_Init();
 bool	sound_Shutdown();
 
 TRACK 	*sound_LoadTrackFromFile(const char *fileName);
+/// Decodes a track without touching OpenAL, so may be called on any thread. The result is freed with free().
+soundDataBuffer *sound_DecodeTrackFromFile(const char *fileName);
+/// Makes a track from a decoded one, named GetLastResourceFilename(), and frees soundBuffer. Main thread only.
+TRACK	*sound_CreateTrack(soundDataBuffer *soundBuffer);
 unsigned int sound_SetTrackVals(const char *fileName, bool loop, unsigned int volume, unsigned int audibleRadius);
 void	sound_ReleaseTrack(TRACK *psTrack);
 
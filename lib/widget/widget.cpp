@@ -903,6 +903,11 @@ void WIDGET::displayRecursive(int xOffset, int yOffset)
  */
 void widgDisplayScreen(W_SCREEN *psScreen)
 {
+	if (wz_headless)
+	{
+		return;
+	}
+
 	// To toggle debug bounding boxes: Press: Left Shift   --  --  --------------
 	//                                        Left Ctrl  ------------  --  --  ----
 	static const int debugSequence[] = { -1, 0, 1, 3, 1, 3, 1, 3, 2, 3, 2, 3, 2, 3, 1, 0, -1};
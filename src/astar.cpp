@@ -21,22 +21,33 @@
  *  A* based path finding
  *  See http://en.wikipedia.org/wiki/A*_search_algorithm for more information.
  *  How this works:
- *  * First time (in a given tick)  that some droid  wants to pathfind  to a particular
+ *  * First time that some droid wants to pathfind to a particular
  *    destination,  the A*  algorithm from source to  destination is used.  The desired
  *    destination,  and the nearest  reachable point  to the  destination is saved in a
  *    Context.
- *  * Second time (in a given tick)  that some droid wants to  pathfind to a particular
+ *  * Second time  that some droid wants to  pathfind to a particular
  *    destination,  the appropriate  Context is found,  and the A* algorithm is used to
  *    find a path from the nearest reachable point to the destination  (which was saved
  *    earlier), to the source.
- *  * Subsequent times  (in a given tick) that some droid wants to pathfind to a parti-
+ *  * Subsequent times  that some droid wants to pathfind to a parti-
  *    cular destination,  the path is looked up in appropriate Context.  If the path is
  *    not already known,  the A* weights are adjusted, and the previous A*  pathfinding
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
+ *  Contexts stay valid between ticks, until the blocking map they were made for changes.
+ *  Blocking maps are stored as bitmaps,  and are patched  where structures and features
+ *  changed, rather than being rebuilt each tick.
+ *  Long routes to destinations not in the cache are first planned over the cluster map,
+ *  see pathcluster.h, and A* then only explores tiles in the regions along that route.
+ *  If that fails, the whole map is explored as usual.
+ *  Optionally,  new searches use jump point search,  which skips over runs of open tiles
+ *  where the cost is uniform, and falls back to the usual expansion  near dangerous tiles
+ *  and the destination structure. Such contexts are not reused.
+ *  Up to 8 pathfinding maps from A* are cached per lane, in a LRU list. There are FPATH_LANES
+ *  lanes,  chosen by destination,  so that  several  threads can pathfind  at the same
+ *  time without the cached maps depending on which thread did what. The PathNode heap
+ *  contains the priority-heap-sorted nodes which are to be explored. The path back  is
  *  stored in the PathExploredTile 2D array of tiles.
  */
 
@@ -45,12 +56,14 @@
 
 #include "astar.h"
 #include "map.h"
+#include "pathcluster.h"
 #endif
 
 #include <list>
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <chrono>
 
 #include "lib/netplay/netplay.h"
 
@@ -97,7 +110,11 @@ struct PathNode
 
 	PathCoord p;                    // Map coords.
 	unsigned  dist, est;            // Distance so far and estimate to end.
+	uint8_t   jumpDir;              // Direction of the jump which reached this node, or FPATH_NO_JUMP.
 };
+
+/// Value of PathNode::jumpDir for nodes which weren't reached by a jump, so must try all directions.
+#define FPATH_NO_JUMP 8
 struct PathExploredTile
 {
 	PathExploredTile() : iteration(0xFFFF), dx(0), dy(0), dist(0), visited(false) {}
@@ -110,25 +127,116 @@ struct PathExploredTile
 
 struct PathBlockingType
 {
-	uint32_t gameTime;
-
 	PROPULSION_TYPE propulsion;
 	int owner;
 	FPATH_MOVETYPE moveType;
 };
+
+/// One bit per tile, packed into 64-bit words, with each row starting at a new word.
+struct PathBitmap
+{
+	void resize(int width, int height)
+	{
+		stride = (width + 63) / 64;
+		words.assign(stride * height, 0);
+	}
+	bool empty() const
+	{
+		return words.empty();
+	}
+	bool get(int x, int y) const
+	{
+		return (words[x / 64 + y * stride] >> (x % 64) & 1) != 0;
+	}
+	void set(int x, int y, bool value)
+	{
+		uint64_t &word = words[x / 64 + y * stride];
+		uint64_t bit = uint64_t(1) << (x % 64);
+		word = value ? word | bit : word & ~bit;
+	}
+	/// Returns the bits for tiles x - 1, x and x + 1 of row y, as bits 0, 1 and 2. All three tiles must be on the map.
+	unsigned get3(int x, int y) const
+	{
+		unsigned shift = (x - 1) % 64;
+		if (shift <= 61)
+		{
+			return words[(x - 1) / 64 + y * stride] >> shift & 7;  // All three bits are in the same word.
+		}
+		return get(x - 1, y) | get(x, y) << 1 | get(x + 1, y) << 2;
+	}
+	/** Scans along row from pos in direction dir (1 or -1), and returns the first position which has a forced neighbour
+	 *  in the row before or after, as in fpathJumpForcedSide(), or limit if that is reached first. Returns -1 if there is
+	 *  a blocking tile first, or at that position. The row must not be the first or last row.
+	 */
+	int scanJump(int row, int pos, int dir, int limit) const
+	{
+		uint64_t const *blocking = &words[row * stride];
+		uint64_t const *sides[2] = {blocking - stride, blocking + stride};
+		for (int p = pos + dir; true;)
+		{
+			int i = p / 64;
+			if (p == limit)
+			{
+				return (blocking[i] >> (p % 64) & 1) != 0 ? -1 : limit;
+			}
+			uint64_t events = blocking[i];
+			for (uint64_t const *side : sides)
+			{
+				// Bit p is set if side[p] is open and side[p - dir] is blocking.
+				uint64_t before = dir > 0 ? side[i] << 1 | (i > 0 ? side[i - 1] >> 63 : 0)
+				                          : side[i] >> 1 | (i + 1 < stride ? side[i + 1] << 63 : 0);
+				events |= ~side[i] & before;
+			}
+			uint64_t ahead = dir > 0 ? ~uint64_t(0) << (p % 64) : ~uint64_t(0) >> (63 - p % 64);
+			if ((events & ahead) == 0)
+			{
+				// Nothing in the rest of this word, so skip to the next word, unless the limit comes first.
+				int next = dir > 0 ? (i + 1) * 64 : i * 64 - 1;
+				p = (limit - next) * dir < 0 ? limit : next;
+				continue;
+			}
+			for (; p != limit && p / 64 == i; p += dir)
+			{
+				if ((blocking[i] >> (p % 64) & 1) != 0)
+				{
+					return -1;
+				}
+				if ((events >> (p % 64) & 1) != 0)
+				{
+					return p;
+				}
+			}
+		}
+	}
+	/// Doesn't depend on endianness, so can be compared between clients.
+	uint32_t checksum() const
+	{
+		uint32_t checksum = 0;
+		for (uint64_t word : words)
+		{
+			checksum = (checksum * 0x01000193) ^ uint32_t(word) ^ uint32_t(word >> 32);
+		}
+		return checksum;
+	}
+
+	std::vector<uint64_t> words;
+	int stride = 0;                 ///< Words per row.
+};
+
 /// Pathfinding blocking map
 struct PathBlockingMap
 {
 	bool operator ==(PathBlockingType const &z) const
 	{
-		return type.gameTime == z.gameTime &&
-		       fpathIsEquivalentBlocking(type.propulsion, type.owner, type.moveType,
+		return fpathIsEquivalentBlocking(type.propulsion, type.owner, type.moveType,
 		                                 z.propulsion,    z.owner,    z.moveType);
 	}
 
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	uint32_t version;               ///< Changed whenever the map is modified.
+	PathBitmap map;
+	PathBitmap mapT;                ///< Same as map, but transposed, for scanning columns.
+	PathBitmap dangerMap;	// using threatBits
 };
 
 struct PathNonblockingArea
@@ -157,7 +265,7 @@ struct PathNonblockingArea
 // Data structures used for pathfinding, can contain cached results.
 struct PathfindContext
 {
-	PathfindContext() : myGameTime(0), iteration(0), blockingMap(nullptr) {}
+	PathfindContext() : myVersion(0), iteration(0), blockingMap(nullptr), corridor(nullptr), jumpPointSearch(false), expanded(0) {}
 	bool isBlocked(int x, int y) const
 	{
 		if (dstIgnore.isNonblocking(x, y))
@@ -165,23 +273,32 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y)
+		       || (corridor != nullptr && !corridor->contains(x, y));
+	}
+	/// Same as isBlocked(), but only for tiles next to a tile where fpathJumpPlain() is true.
+	bool isBlockedNearPlain(int x, int y) const
+	{
+		return blockingMap->map.get(x, y) || (corridor != nullptr && !corridor->contains(x, y));
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
 	}
 	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
-		// Must check myGameTime == blockingMap_->type.gameTime, otherwise blockingMap could be a deleted pointer which coincidentally compares equal to the valid pointer blockingMap_.
-		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
+		// Must check myVersion == blockingMap_->version, since blocking maps which aren't in use elsewhere are modified in place.
+		// Jump point search skips tiles, so can't be continued towards other tiles.
+		return myVersion == blockingMap_->version && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_ && !jumpPointSearch;
 	}
-	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_)
+	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_, bool jumpPointSearch_)
 	{
 		blockingMap = blockingMap_;
 		tileS = tileS_;
 		dstIgnore = dstIgnore_;
-		myGameTime = blockingMap->type.gameTime;
+		corridor = nullptr;
+		jumpPointSearch = jumpPointSearch_;
+		myVersion = blockingMap->version;
 		nodes.clear();
 
 		// Make the iteration not match any value of iteration in map.
@@ -194,7 +311,7 @@ struct PathfindContext
 	}
 
 	PathCoord       tileS;                // Start tile for pathfinding. (May be either source or target tile.)
-	uint32_t        myGameTime;
+	uint32_t        myVersion;            // Version of blockingMap the context was made for.
 
 	PathCoord       nearestCoord;         // Nearest reachable tile to destination.
 
@@ -208,15 +325,52 @@ struct PathfindContext
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+	PathClusterCorridor const *corridor; ///< If set, tiles outside the corridor are considered blocking.
+	bool            jumpPointSearch;      ///< Skip over runs of open tiles where the cost is uniform.
+	unsigned        expanded;             ///< Number of nodes expanded, only used for benchmarking.
+};
+
+/// Pathfinding state, which must only be used by one thread at a time.
+struct PathfindLane
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	std::vector<Vector2i> path;           ///< Route being built, kept to save allocations.
+	PathClusterCorridor corridor;         ///< Regions to search when planning a long route.
+	PathfindContext corridorContext;      ///< Context for searching within the corridor, not reused for other routes.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/// Maximum number of contexts cached in each lane.
+#define FPATH_LANE_CONTEXTS 8
+
+/// Minimum distance in tiles, along either axis, for planning a route over the cluster map first.
+#define FPATH_CORRIDOR_MIN_DISTANCE (2 * PATH_CLUSTER_SIZE)
+
+static PathfindLane fpathLanes[FPATH_LANES];
 
-/// Lists of blocking maps from current tick.
-static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
-/// Game time for all blocking maps in fpathBlockingMaps.
-static uint32_t fpathCurrentGameTime;
+/// Setting for new path jobs, see fpathSetJumpPointSearch().
+static bool fpathJumpPointSearch = false;
+
+/// A blocking map kept between ticks, and the changes not yet applied to it.
+struct PathBlockingMapCache
+{
+	std::shared_ptr<PathBlockingMap> map;
+	std::vector<StructureBounds> dirtyAreas;  ///< Areas where blocking tiles may have changed.
+	bool dirtyAll;                  ///< Too many changes to track, so rebuild the whole map.
+	bool dirtyDanger;               ///< Threat bits of the owner may have changed.
+};
+
+/// Maximum number of changed areas remembered for each blocking map, before rebuilding the whole map instead.
+#define FPATH_MAX_DIRTY_AREAS 64
+
+/// Blocking maps, updated when next used by fpathSetBlockingMap().
+static std::vector<PathBlockingMapCache> fpathBlockingMaps;
+/// Last version number given to a blocking map.
+static uint32_t fpathBlockingMapVersion;
+/// State the blocking maps were made for. If any of this changes, all blocking maps are rebuilt.
+static MAPTILE *fpathBlockingMapTiles = nullptr;
+static int fpathBlockingMapWidth, fpathBlockingMapHeight;
+static int fpathBlockingScrollMinX, fpathBlockingScrollMinY, fpathBlockingScrollMaxX, fpathBlockingScrollMaxY;
+static uint32_t fpathBlockingGameTime;
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -232,10 +386,71 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
+/// Convert an offset into a direction, the inverse of aDirOffset.
+static inline unsigned fpathDirection(int dx, int dy)
+{
+	static const uint8_t dirs[9] = {3, 4, 5, 2, FPATH_NO_JUMP, 6, 1, 0, 7};
+	return dirs[(dy + 1) * 3 + dx + 1];
+}
+
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
+	for (auto &lane : fpathLanes)
+	{
+		lane.contexts.clear();
+		lane.corridorContext = PathfindContext();
+		lane.corridor = PathClusterCorridor();
+	}
 	fpathBlockingMaps.clear();
+	fpathBlockingMapTiles = nullptr;
+	fpathClustersReset();
+}
+
+void fpathBlockingTilesChanged(StructureBounds const &area)
+{
+	for (auto &cache : fpathBlockingMaps)
+	{
+		if (cache.dirtyAll)
+		{
+			continue;
+		}
+		if (cache.dirtyAreas.size() >= FPATH_MAX_DIRTY_AREAS)
+		{
+			cache.dirtyAll = true;
+			cache.dirtyAreas.clear();
+			continue;
+		}
+		cache.dirtyAreas.push_back(area);
+	}
+	fpathClustersChanged(area);
+}
+
+void fpathDangerChanged(int player)
+{
+	for (auto &cache : fpathBlockingMaps)
+	{
+		if (cache.map->type.owner == player)
+		{
+			cache.dirtyDanger = true;
+		}
+	}
+}
+
+void fpathSetJumpPointSearch(bool enable)
+{
+	fpathJumpPointSearch = enable;
+}
+
+bool fpathGetJumpPointSearch()
+{
+	return fpathJumpPointSearch;
+}
+
+unsigned fpathLane(int destX, int destY)
+{
+	// Jobs going to the same tile must share a lane, since that is when cached contexts can be reused.
+	unsigned x = map_coord(destX), y = map_coord(destY);
+	return ((x * 0x9E3779B1u ^ y * 0x85EBCA77u) >> 16) % FPATH_LANES;
 }
 
 /** Get the nearest entry in the open list
@@ -278,6 +493,7 @@ static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCo
 	PathNode node;
 	unsigned costFactor = context.isDangerous(pos.x, pos.y) ? 5 : 1;
 	node.p = pos;
+	node.jumpDir = FPATH_NO_JUMP;
 	node.dist = prevDist + fpathEstimate(prevPos, pos) * costFactor;
 	node.est = node.dist + fpathGoodEstimate(pos, dest);
 
@@ -352,6 +568,227 @@ static void fpathAStarReestimate(PathfindContext &context, PathCoord tileF)
 	std::make_heap(context.nodes.begin(), context.nodes.end());
 }
 
+/// Returns true if (x, y) or any of its neighbours is in the nonblocking area.
+static inline bool fpathNearNonblocking(PathNonblockingArea const &area, int x, int y)
+{
+	return area.x1 < area.x2 && area.y1 < area.y2
+	       && x + 1 >= area.x1 && x - 1 < area.x2 && y + 1 >= area.y1 && y - 1 < area.y2;
+}
+
+/// Returns a mask with bit dir set if the neighbour of (x, y) in direction aDirOffset[dir] is blocking.
+static inline unsigned fpathBlockedNeighbours(PathfindContext const &context, int x, int y)
+{
+	if (x >= 1 && y >= 1 && x < mapWidth - 1 && y < mapHeight - 1 && context.corridor == nullptr && !fpathNearNonblocking(context.dstIgnore, x, y))
+	{
+		// Fast case, read the 3×3 neighbourhood with a load per row, and shuffle it into direction order.
+		PathBitmap const &map = context.blockingMap->map;
+		unsigned above = map.get3(x, y - 1);
+		unsigned row   = map.get3(x, y);
+		unsigned below = map.get3(x, y + 1);
+		return (below >> 1 & 1) | (below & 1) << 1 | (row & 1) << 2 | (above & 1) << 3
+		       | (above >> 1 & 1) << 4 | (above >> 2 & 1) << 5 | (row >> 2 & 1) << 6 | (below >> 2 & 1) << 7;
+	}
+
+	unsigned blocked = 0;
+	for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+	{
+		blocked |= unsigned(context.isBlocked(x + aDirOffset[dir].x, y + aDirOffset[dir].y)) << dir;
+	}
+	return blocked;
+}
+
+/// Returns true if the tile and its neighbours are all the same cost and not in the nonblocking area, so the jump point search rules hold there.
+static inline bool fpathJumpPlain(PathfindContext const &context, int x, int y)
+{
+	if (x < 1 || y < 1 || x >= mapWidth - 1 || y >= mapHeight - 1 || fpathNearNonblocking(context.dstIgnore, x, y))
+	{
+		return false;
+	}
+	PathBitmap const &danger = context.blockingMap->dangerMap;
+	return danger.empty() || (danger.get3(x, y - 1) | danger.get3(x, y) | danger.get3(x, y + 1)) == 0;
+}
+
+/** Returns true if moving straight in direction (dx, dy) to (x, y), the tile on the given side (1 or -1) of (x, y) can
+ *  only be reached through (x, y), since the tile beside the previous tile is blocking and corners can't be cut.
+ */
+static inline bool fpathJumpForcedSide(PathfindContext const &context, int x, int y, int dx, int dy, int side)
+{
+	int sideX = dy * dy * side, sideY = dx * dx * side;
+	return !context.isBlockedNearPlain(x + sideX, y + sideY) && context.isBlockedNearPlain(x + sideX - dx, y + sideY - dy);
+}
+
+static inline bool fpathJumpForced(PathfindContext const &context, int x, int y, int dx, int dy)
+{
+	return fpathJumpForcedSide(context, x, y, dx, dy, 1) || fpathJumpForcedSide(context, x, y, dx, dy, -1);
+}
+
+/** Returns the number of steps moving straight from (x, y) in direction (dx, dy) to the next jump point, or 0 if
+ *  blocked first. (x, y) must be a tile where fpathJumpPlain() is true.
+ */
+static int fpathJumpStraight(PathfindContext const &context, PathCoord tileF, int x, int y, int dx, int dy)
+{
+	if (context.corridor != nullptr || !context.blockingMap->dangerMap.empty())
+	{
+		// Check each tile.
+		for (int steps = 1; true; ++steps)
+		{
+			x += dx;
+			y += dy;
+			if (context.isBlockedNearPlain(x, y))
+			{
+				return 0;
+			}
+			if ((x == tileF.x && y == tileF.y) || !fpathJumpPlain(context, x, y) || fpathJumpForced(context, x, y, dx, dy))
+			{
+				return steps;
+			}
+		}
+	}
+
+	// Only blocking tiles, the map edge, the target and the nonblocking area can stop the jump, so scan a word of tiles at a
+	// time, along a row of the map, or along a row of the transposed map when moving vertically.
+	bool vertical = dx == 0;
+	PathBitmap const &bitmap = vertical ? context.blockingMap->mapT : context.blockingMap->map;
+	int row = vertical ? x : y;
+	int pos = vertical ? y : x;
+	int dir = vertical ? dy : dx;
+	int limit = dir > 0 ? (vertical ? mapHeight : mapWidth) - 1 : 0;  // Tiles on the map edge aren't plain.
+	auto limitAt = [&](int p) {
+		if ((p - pos) * dir > 0 && (p - limit) * dir < 0)
+		{
+			limit = p;
+		}
+	};
+	if ((vertical ? tileF.x : tileF.y) == row)
+	{
+		limitAt(vertical ? tileF.y : tileF.x);
+	}
+	PathNonblockingArea const &ignore = context.dstIgnore;
+	if (ignore.x1 < ignore.x2 && ignore.y1 < ignore.y2)
+	{
+		int rowBegin = vertical ? ignore.x1 : ignore.y1, rowEnd = vertical ? ignore.x2 : ignore.y2;
+		int posBegin = vertical ? ignore.y1 : ignore.x1, posEnd = vertical ? ignore.y2 : ignore.x2;
+		if (row + 1 >= rowBegin && row - 1 < rowEnd)
+		{
+			limitAt(dir > 0 ? posBegin - 1 : posEnd);
+		}
+	}
+	int found = bitmap.scanJump(row, pos, dir, limit);
+	return found < 0 ? 0 : (found - pos) * dir;
+}
+
+/// Returns the number of steps from p in direction dir to the next jump point, or 0 if there isn't one.
+static int fpathJump(PathfindContext const &context, PathCoord tileF, PathCoord p, unsigned dir)
+{
+	int dx = aDirOffset[dir].x, dy = aDirOffset[dir].y;
+	if (dx == 0 || dy == 0)
+	{
+		return fpathJumpStraight(context, tileF, p.x, p.y, dx, dy);
+	}
+
+	int x = p.x, y = p.y;
+	for (int steps = 1; true; ++steps)
+	{
+		x += dx;
+		y += dy;
+		if (context.isBlockedNearPlain(x, y) || context.isBlockedNearPlain(x - dx, y) || context.isBlockedNearPlain(x, y - dy))
+		{
+			return 0;  // Blocked, or would have to cut a corner.
+		}
+		if ((x == tileF.x && y == tileF.y) || !fpathJumpPlain(context, x, y))
+		{
+			return steps;  // Reached the target, or somewhere the normal rules apply.
+		}
+		if (fpathJumpStraight(context, tileF, x, y, dx, 0) != 0 || fpathJumpStraight(context, tileF, x, y, 0, dy) != 0)
+		{
+			return steps;
+		}
+	}
+}
+
+/// Records the route along a jump of the given number of steps, and adds the jump point to the node heap.
+static void fpathJumpNode(PathfindContext &context, PathCoord tileF, PathNode const &from, unsigned dir, int steps)
+{
+	Vector2i delta = aDirOffset[dir];
+	unsigned stepCost = delta.x != 0 && delta.y != 0 ? 198 : 140;
+
+	PathNode node;
+	node.dist = from.dist;
+	node.jumpDir = dir;
+	for (int i = 1; i <= steps; ++i)
+	{
+		node.p = PathCoord(from.p.x + delta.x * i, from.p.y + delta.y * i);
+		node.dist += stepCost * (context.isDangerous(node.p.x, node.p.y) ? 5 : 1);  // Only the jump point itself can be dangerous.
+
+		PathExploredTile &expl = context.map[node.p.x + node.p.y * mapWidth];
+		if (expl.iteration == context.iteration && (expl.visited || expl.dist <= node.dist))
+		{
+			if (i == steps)
+			{
+				if (expl.visited)
+				{
+					return;  // Already visited the jump point. Do nothing.
+				}
+				// A different path to the jump point is shorter, and it may not have been added to the heap if it was passed by another jump.
+				// Add it anyway, with the shorter distance, and try all directions from there, since we don't know which way the shorter path came.
+				node.dist = expl.dist;
+				node.jumpDir = FPATH_NO_JUMP;
+			}
+			continue;  // Keep the shorter path through this tile, which still leads back to the start.
+		}
+
+		// Remember the way back, one tile at a time.
+		expl.iteration = context.iteration;
+		expl.dx = delta.x * 64;
+		expl.dy = delta.y * 64;
+		expl.dist = node.dist;
+		expl.visited = false;
+	}
+	node.est = node.dist + fpathGoodEstimate(node.p, tileF);
+
+	context.nodes.push_back(node);
+	std::push_heap(context.nodes.begin(), context.nodes.end());
+}
+
+/// Expands a node using jump point search, only trying directions which can't be reached more directly without going through the node.
+static void fpathJumpSuccessors(PathfindContext &context, PathCoord tileF, PathNode const &node)
+{
+	unsigned dirs = 0xFF;  // Bit mask of directions to try.
+	if (node.jumpDir != FPATH_NO_JUMP)
+	{
+		int dx = aDirOffset[node.jumpDir].x, dy = aDirOffset[node.jumpDir].y;
+		dirs = 1 << node.jumpDir;
+		if (dx != 0 && dy != 0)
+		{
+			dirs |= 1 << fpathDirection(dx, 0) | 1 << fpathDirection(0, dy);
+		}
+		else
+		{
+			for (int side = -1; side <= 1; side += 2)
+			{
+				if (fpathJumpForcedSide(context, node.p.x, node.p.y, dx, dy, side))
+				{
+					int sideX = dy * dy * side, sideY = dx * dx * side;
+					dirs |= 1 << fpathDirection(sideX, sideY) | 1 << fpathDirection(sideX + dx, sideY + dy);
+				}
+			}
+		}
+	}
+
+	for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+	{
+		if ((dirs >> dir & 1) == 0)
+		{
+			continue;
+		}
+		int steps = fpathJump(context, tileF, node.p, dir);
+		if (steps != 0)
+		{
+			fpathJumpNode(context, tileF, node, dir, steps);
+		}
+	}
+}
+
 /// Returns nearest explored tile to tileF.
 static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 {
@@ -383,6 +820,15 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			foundIt = true;  // Break out of loop, but not before inserting neighbour nodes, since the neighbours may be important if the context gets reused.
 		}
 
+		++context.expanded;
+		if (context.jumpPointSearch && fpathJumpPlain(context, node.p.x, node.p.y))
+		{
+			fpathJumpSuccessors(context, tileF, node);
+			continue;
+		}
+
+		unsigned blocked = fpathBlockedNeighbours(context, node.p.x, node.p.y);
+
 		// loop through possible moves in 8 directions to find a valid move
 		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
 		{
@@ -400,25 +846,15 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 			*/
 			if (dir % 2 != 0 && !context.dstIgnore.isNonblocking(node.p.x, node.p.y) && !context.dstIgnore.isNonblocking(x, y))
 			{
-				int x, y;
-
 				// We cannot cut corners
-				x = node.p.x + aDirOffset[(dir + 1) % 8].x;
-				y = node.p.y + aDirOffset[(dir + 1) % 8].y;
-				if (context.isBlocked(x, y))
-				{
-					continue;
-				}
-				x = node.p.x + aDirOffset[(dir + 7) % 8].x;
-				y = node.p.y + aDirOffset[(dir + 7) % 8].y;
-				if (context.isBlocked(x, y))
+				if ((blocked >> ((dir + 1) % 8) & 1) != 0 || (blocked >> ((dir + 7) % 8) & 1) != 0)
 				{
 					continue;
 				}
 			}
 
 			// See if the node is a blocking tile
-			if (context.isBlocked(x, y))
+			if ((blocked >> dir & 1) != 0)
 			{
 				// tile is blocked, skip it
 				continue;
@@ -432,18 +868,55 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	return nearestCoord;
 }
 
-static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore)
+static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore, bool jumpPointSearch = false)
 {
-	context.assign(blockingMap, tileS, dstIgnore);
+	context.assign(blockingMap, tileS, dstIgnore, jumpPointSearch);
 
 	// Add the start point to the open list
 	fpathNewNode(context, tileF, tileRealS, 0, tileRealS);
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
+/// Starts a new search from tileOrig, and returns the nearest tile to tileDest found.
+static PathCoord fpathAStarSearch(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileOrig, PathCoord tileDest, PathNonblockingArea dstIgnore, bool jumpPointSearch)
+{
+	fpathInitContext(context, blockingMap, tileOrig, tileOrig, tileDest, dstIgnore, jumpPointSearch);
+	PathCoord endCoord = fpathAStarExplore(context, tileDest);
+	if (jumpPointSearch && endCoord != tileDest)
+	{
+		// Jump point search skips tiles, so wouldn't find the nearest reachable tile. Search again, exploring every tile.
+		fpathInitContext(context, blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+		endCoord = fpathAStarExplore(context, tileDest);
+	}
+	return endCoord;
+}
+
+/// Tries finding the route by only exploring the regions along the route found on the cluster map. Returns true if successful.
+static bool fpathAStarCorridor(PathfindLane &lane, PATHJOB *psJob, PathCoord tileOrig, PathCoord tileDest, PathNonblockingArea dstIgnore)
+{
+	if (!psJob->clusterMap || std::max(abs(tileOrig.x - tileDest.x), abs(tileOrig.y - tileDest.y)) < FPATH_CORRIDOR_MIN_DISTANCE)
+	{
+		return false;  // Short routes are fast anyway.
+	}
+	if (!fpathClusterCorridor(*psJob->clusterMap, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), lane.corridor))
+	{
+		return false;
+	}
+
+	PathfindContext &context = lane.corridorContext;
+	fpathInitContext(context, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore, psJob->jumpPointSearch);
+	context.corridor = &lane.corridor;
+	context.nearestCoord = fpathAStarExplore(context, tileDest);
+	// May fail if the corridor goes somewhere this droid can't, such as through an enemy gate, since the cluster map ignores owners.
+	return context.nearestCoord == tileDest;
+}
+
+ASR_RETVAL fpathAStarRoute(unsigned lane, MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
+	ASSERT_OR_RETURN(ASR_FAILED, lane < FPATH_LANES, "Bad lane %u", lane);
+
 	ASR_RETVAL      retval = ASR_OK;
+	std::list<PathfindContext> &fpathContexts = fpathLanes[lane].contexts;
 
 	bool            mustReverse = true;
 
@@ -487,11 +960,17 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		break;  // Found the path! Don't search more contexts.
 	}
 
-	if (contextIterator == fpathContexts.end())
+	bool usingCorridor = false;
+	if (contextIterator == fpathContexts.end() && fpathAStarCorridor(fpathLanes[lane], psJob, tileOrig, tileDest, dstIgnore))
+	{
+		usingCorridor = true;
+		endCoord = tileDest;
+	}
+	else if (contextIterator == fpathContexts.end())
 	{
 		// We did not find an appropriate context. Make one.
 
-		if (fpathContexts.size() < 30)
+		if (fpathContexts.size() < FPATH_LANE_CONTEXTS)
 		{
 			fpathContexts.push_back(PathfindContext());
 		}
@@ -499,12 +978,11 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 		// Init a new context, overwriting the oldest one if we are caching too many.
 		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
-		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
-		endCoord = fpathAStarExplore(*contextIterator, tileDest);
+		endCoord = fpathAStarSearch(*contextIterator, psJob->blockingMap, tileOrig, tileDest, dstIgnore, psJob->jumpPointSearch);
 		contextIterator->nearestCoord = endCoord;
 	}
 
-	PathfindContext &context = *contextIterator;
+	PathfindContext &context = usingCorridor ? fpathLanes[lane].corridorContext : *contextIterator;
 
 	// return the nearest route if no actual route was found
 	if (context.nearestCoord != tileDest)
@@ -513,7 +991,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
+	std::vector<Vector2i> &path = fpathLanes[lane].path;
 	path.clear();
 
 	Vector2i newP;
@@ -564,7 +1042,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	ASSERT(psMove->asPath, "Out of memory");
 	if (!psMove->asPath)
 	{
-		fpathHardTableReset();
+		fpathContexts.clear();  // Only clear our own lane, other lanes may be in use by other threads.
 		return ASR_FAILED;
 	}
 
@@ -584,7 +1062,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		// Copy the list, in reverse.
 		std::copy(path.rbegin(), path.rend(), psMove->asPath);
 
-		if (!context.isBlocked(tileOrig.x, tileOrig.y))  // If blocked, searching from tileDest to tileOrig wouldn't find the tileOrig tile.
+		if (!usingCorridor && !context.isBlocked(tileOrig.x, tileOrig.y))  // If blocked, searching from tileDest to tileOrig wouldn't find the tileOrig tile.
 		{
 			// Next time, search starting from nearest reachable tile to the destination.
 			fpathInitContext(context, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore);
@@ -597,7 +1075,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Move context to beginning of last recently used list.
-	if (contextIterator != fpathContexts.begin())  // Not sure whether or not the splice is a safe noop, if equal.
+	if (!usingCorridor && contextIterator != fpathContexts.begin())  // Not sure whether or not the splice is a safe noop, if equal.
 	{
 		fpathContexts.splice(fpathContexts.begin(), fpathContexts, contextIterator);
 	}
@@ -607,62 +1085,179 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+/// Recalculates the blocking tiles in the given area, clipped to the map.
+static void fpathFillBlockingArea(PathBlockingMap &blockMap, int x1, int y1, int x2, int y2)
+{
+	PathBlockingType const &type = blockMap.type;
+	x1 = std::max(x1, 0);
+	y1 = std::max(y1, 0);
+	x2 = std::min(x2, mapWidth);
+	y2 = std::min(y2, mapHeight);
+	for (int y = y1; y < y2; ++y)
+		for (int x = x1; x < x2; ++x)
+		{
+			bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+			blockMap.map.set(x, y, blocking);
+			blockMap.mapT.set(y, x, blocking);
+		}
+}
+
+static bool fpathWantsDangerMap(PathBlockingType const &type)
+{
+	return !isHumanPlayer(type.owner) && type.moveType == FMT_MOVE;
+}
+
+static void fpathFillDangerMap(PathBlockingMap &blockMap)
+{
+	PathBlockingType const &type = blockMap.type;
+	if (!fpathWantsDangerMap(type))
+	{
+		blockMap.dangerMap = PathBitmap();
+		return;
+	}
+	blockMap.dangerMap.resize(mapWidth, mapHeight);
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			blockMap.dangerMap.set(x, y, auxTile(x, y, type.owner) & AUXBITS_THREAT);
+		}
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
-	if (fpathCurrentGameTime != gameTime)
+	if (fpathBlockingMapTiles != psMapTiles || fpathBlockingMapWidth != mapWidth || fpathBlockingMapHeight != mapHeight
+	    || fpathBlockingScrollMinX != scrollMinX || fpathBlockingScrollMinY != scrollMinY || fpathBlockingScrollMaxX != scrollMaxX || fpathBlockingScrollMaxY != scrollMaxY
+	    || gameTime < fpathBlockingGameTime)
 	{
-		// New tick, remove maps which are no longer needed.
-		fpathCurrentGameTime = gameTime;
+		// Different map or game, or the scroll limits changed, which affects blocking everywhere.
 		fpathBlockingMaps.clear();
+		fpathBlockingMapTiles = psMapTiles;
+		fpathBlockingMapWidth = mapWidth;
+		fpathBlockingMapHeight = mapHeight;
+		fpathBlockingScrollMinX = scrollMinX;
+		fpathBlockingScrollMinY = scrollMinY;
+		fpathBlockingScrollMaxX = scrollMaxX;
+		fpathBlockingScrollMaxY = scrollMaxY;
 	}
+	fpathBlockingGameTime = gameTime;
 
 	// Figure out which map we are looking for.
 	PathBlockingType type;
-	type.gameTime = gameTime;
 	type.propulsion = psJob->propulsion;
 	type.owner = psJob->owner;
 	type.moveType = psJob->moveType;
 
 	// Find the map.
-	auto i = std::find_if(fpathBlockingMaps.begin(), fpathBlockingMaps.end(), [&](std::shared_ptr<PathBlockingMap> const &ptr) {
-		return *ptr == type;
+	auto i = std::find_if(fpathBlockingMaps.begin(), fpathBlockingMaps.end(), [&](PathBlockingMapCache const &cache) {
+		return *cache.map == type;
 	});
 	if (i == fpathBlockingMaps.end())
 	{
-		// Didn't find the map, so i does not point to a map.
-		PathBlockingMap *blockMap = new PathBlockingMap();
-		fpathBlockingMaps.emplace_back(blockMap);
-
-		// blockMap now points to an empty map with no data. Fill the map.
-		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
+		// Didn't find the map, so make an empty one, to be filled below.
+		PathBlockingMapCache cache;
+		cache.map = std::make_shared<PathBlockingMap>();
+		cache.map->type = type;
+		cache.dirtyAll = true;
+		cache.dirtyDanger = true;
+		fpathBlockingMaps.push_back(cache);
+		i = fpathBlockingMaps.end() - 1;
+	}
+	PathBlockingMapCache &cache = *i;
+	if (cache.map->dangerMap.empty() == fpathWantsDangerMap(cache.map->type))
+	{
+		cache.dirtyDanger = true;  // Owner changed between human and AI.
+	}
+
+	if (cache.dirtyAll || cache.dirtyDanger || !cache.dirtyAreas.empty())
+	{
+		if (cache.map.use_count() > 1)
+		{
+			// Still used by path-finding threads or cached contexts, so modify a copy instead.
+			cache.map = std::make_shared<PathBlockingMap>(*cache.map);
+		}
+		PathBlockingMap &blockMap = *cache.map;
+		blockMap.version = ++fpathBlockingMapVersion;
+
+		if (cache.dirtyAll)
+		{
+			blockMap.map.resize(mapWidth, mapHeight);
+			blockMap.mapT.resize(mapHeight, mapWidth);
+			fpathFillBlockingArea(blockMap, 0, 0, mapWidth, mapHeight);
+		}
+		else
+		{
+			for (StructureBounds const &area : cache.dirtyAreas)
 			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
+				fpathFillBlockingArea(blockMap, area.map.x, area.map.y, area.map.x + area.size.x, area.map.y + area.size.y);
 			}
-		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
+		}
+		if (cache.dirtyDanger)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
-			for (int y = 0; y < mapHeight; ++y)
-				for (int x = 0; x < mapWidth; ++x)
-				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
-				}
+			fpathFillDangerMap(blockMap);
 		}
-		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
+		cache.dirtyAreas.clear();
+		cache.dirtyAll = false;
+		cache.dirtyDanger = false;
 
-		psJob->blockingMap = fpathBlockingMaps.back();
+		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, blockMap.map.checksum(), blockMap.dangerMap.checksum());
 	}
 	else
 	{
 		syncDebug("blockingMap(%d,%d,%d,%d) = cached", gameTime, psJob->propulsion, psJob->owner, psJob->moveType);
+	}
+
+	psJob->blockingMap = cache.map;
+	psJob->clusterMap = fpathGetClusterMap(psJob->propulsion);
+	psJob->jumpPointSearch = fpathJumpPointSearch;
+}
 
-		psJob->blockingMap = *i;
+PathBenchmarkResult fpathAStarBenchmark(PROPULSION_TYPE propulsion, unsigned routes)
+{
+	PathBenchmarkResult result;
+
+	// A private blocking map, since fpathSetBlockingMap() would update the cached maps and write to the sync debug log.
+	std::shared_ptr<PathBlockingMap> blockingMap = std::make_shared<PathBlockingMap>();
+	blockingMap->type.propulsion = propulsion;
+	blockingMap->type.owner = 0;
+	blockingMap->type.moveType = FMT_BLOCK;
+	blockingMap->version = 0;
+	blockingMap->map.resize(mapWidth, mapHeight);
+	blockingMap->mapT.resize(mapHeight, mapWidth);
+	fpathFillBlockingArea(*blockingMap, 0, 0, mapWidth, mapHeight);
+
+	PathfindContext contexts[2];
+	PathNonblockingArea dstIgnore;
+	uint32_t seed = 1;  // Not using gameRand, so that the game state isn't changed.
+	auto randomTile = [&]() {
+		for (int tries = 0; tries < 1000; ++tries)
+		{
+			seed = seed * 1103515245 + 12345;
+			PathCoord tile((seed >> 8) % mapWidth, (seed >> 20) % mapHeight);
+			if (!blockingMap->map.get(tile.x, tile.y))
+			{
+				return tile;
+			}
+		}
+		return PathCoord(mapWidth / 2, mapHeight / 2);
+	};
+
+	for (unsigned route = 0; route < routes; ++route)
+	{
+		PathCoord tileOrig = randomTile();
+		PathCoord tileDest = randomTile();
+		PathCoord endCoord[2];
+		for (int jump = 0; jump < 2; ++jump)
+		{
+			auto start = std::chrono::steady_clock::now();
+			contexts[jump].expanded = 0;
+			endCoord[jump] = fpathAStarSearch(contexts[jump], blockingMap, tileOrig, tileDest, dstIgnore, jump != 0);
+			result.expanded[jump] += contexts[jump].expanded;
+			result.microseconds[jump] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		++result.routes;
+		result.unreachable += endCoord[0] != tileDest;
+		result.mismatches += (endCoord[0] == tileDest) != (endCoord[1] == tileDest);
 	}
+
+	return result;
 }
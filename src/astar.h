@@ -34,16 +34,60 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
+/** Number of independent caches of pathfinding contexts.
+ *
+ *  Each job is assigned to a lane by its destination, and jobs in the same lane are processed in order, one at a time.
+ *  Since cached contexts can affect the resulting paths, this must not depend on the number of pathfinding threads.
+ *
+ *  @ingroup pathfinding
+ */
+#define FPATH_LANES 8
+
 /** Use the A* algorithm to find a path
+ *
+ *  Must not be called concurrently with the same lane.
  *
  *  @ingroup pathfinding
  */
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob);
+ASR_RETVAL fpathAStarRoute(unsigned lane, MOVE_CONTROL *psMove, PATHJOB *psJob);
+
+/// Returns the lane which must be used for finding paths to the given destination, in world coordinates.
+unsigned fpathLane(int destX, int destY);
 
 /// Call from main thread.
 /// Sets psJob->blockingMap for later use by pathfinding thread, generating the required map if not already generated.
 void fpathSetBlockingMap(PATHJOB *psJob);
 
+/** Enable or disable jump point search for routes found from now on.
+ *
+ *  Experimental. Jump point search skips over runs of open tiles, so can explore fewer nodes, but finds different (equally
+ *  short) routes, so all players in a network game must use the same setting. On the shipped multiplayer maps it only
+ *  saves time on large open ones, and is slower than plain A* on most, since each jump scans tiles without expanding them.
+ *  Disabled again by fpathInitialise() at the start of each game. Call from main thread.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathSetJumpPointSearch(bool enable);
+bool fpathGetJumpPointSearch();
+
+/// Results of fpathAStarBenchmark(). Index 0 is without jump point search, index 1 is with jump point search.
+struct PathBenchmarkResult
+{
+	unsigned routes = 0;                ///< Number of routes searched.
+	unsigned unreachable = 0;           ///< Number of routes which only reached a nearby tile.
+	unsigned mismatches = 0;            ///< Number of routes where the searches disagreed on whether the destination is reachable.
+	uint64_t expanded[2] = {0, 0};      ///< Number of nodes expanded.
+	uint64_t microseconds[2] = {0, 0};  ///< Time spent searching.
+};
+
+/** Find routes between pseudo-random pairs of tiles on the current map, with and without jump point search.
+ *
+ *  Call from main thread. Doesn't change the game state, the cached blocking maps or the sync debug log.
+ *
+ *  @ingroup pathfinding
+ */
+PathBenchmarkResult fpathAStarBenchmark(PROPULSION_TYPE propulsion, unsigned routes);
+
 /** Clean up the path finding node table.
  *
  *  @note Call this on shutdown to prevent memory from leaking, or if loading/saving, to prevent stale data from being reused.
@@ -86,6 +86,10 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"damage me", kf_DamageMe},
 	{"autogame on", kf_AutoGame},
 	{"autogame off", kf_AutoGame},
+	{"path benchmark", kf_PathBenchmark}, // compare pathfinding with and without jump point search on this map
+	{"path jps", kf_TogglePathJumpPointSearch}, // toggle jump point search for new paths
+	{"droid benchmark", kf_DroidHotBenchmark}, // compare walking the droid lists with going through the droid slots
+	{"pool info", kf_ObjectPoolInfo}, // show how many droids, structures, features and projectiles are allocated
 
 };
 
@@ -27,12 +27,14 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
 #include "lib/ivis_opengl/screen.h"
+#include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
 #include "lib/ivis_opengl/pieclip.h"
 
 #include "levels.h"
 #include "clparse.h"
 #include "display3d.h"
+#include "fpath.h"
 #include "frontend.h"
 #include "keybind.h"
 #include "loadsave.h"
@@ -82,6 +84,7 @@ typedef struct _poptContext
 static bool wz_autogame = false;
 static std::string wz_saveandquit;
 static std::string wz_test;
+static std::string wz_replay;
 
 static void poptPrintHelp(poptContext ctx, FILE *output, bool show_all)
 {
@@ -252,6 +255,9 @@ typedef enum
 	CLI_AUTOGAME,
 	CLI_SAVEANDQUIT,
 	CLI_SKIRMISH,
+	CLI_PATHTHREADS,
+	CLI_HEADLESS,
+	CLI_REPLAY,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable()
@@ -288,6 +294,9 @@ static const struct poptOption *getOptionsTable()
 		{ "autogame",   '\0', POPT_ARG_NONE,   nullptr, CLI_AUTOGAME,   N_("Run games automatically for testing"), nullptr, true },
 		{ "saveandquit", '\0', POPT_ARG_STRING, nullptr, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name"), true },
 		{ "skirmish",   '\0', POPT_ARG_STRING, nullptr, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test"), true },
+		{ "paththreads", '\0', POPT_ARG_STRING, nullptr, CLI_PATHTHREADS, N_("Number of path-finding threads (0 for automatic)"), N_("N"), false },
+		{ "headless",   '\0', POPT_ARG_NONE,   nullptr, CLI_HEADLESS,   N_("Run without a window, graphics or sound, as fast as possible"), nullptr, true },
+		{ "replay",     '\0', POPT_ARG_STRING, nullptr, CLI_REPLAY,     N_("Play back a recorded game"),         N_("replay file"), true },
 		// Terminating entry
 		{ nullptr,         '\0', 0,               nullptr, 0,              nullptr,                                    nullptr, true },
 	};
@@ -649,6 +658,33 @@ bool ParseCommandLine(int argc, const char **argv)
 			}
 			wz_test = token;
 			break;
+
+		case CLI_PATHTHREADS:
+			{
+				unsigned int count;
+
+				token = poptGetOptArg(poptCon);
+				if (token == nullptr || sscanf(token, "%u", &count) != 1)
+				{
+					qFatal("Invalid parameter specified (format is --paththreads=N, e.g. --paththreads=4)");
+				}
+				fpathSetThreadCount(count);
+				break;
+			}
+
+		case CLI_HEADLESS:
+			wz_headless = true;
+			gameTimeSetUnthrottled(true);
+			break;
+
+		case CLI_REPLAY:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("Bad replay file name");
+			}
+			wz_replay = token;
+			break;
 		};
 	}
 
@@ -669,3 +705,8 @@ const std::string &wz_skirmish_test()
 {
 	return wz_test;
 }
+
+const std::string &replay_file()
+{
+	return wz_replay;
+}
@@ -38,6 +38,7 @@
 #include "projectile.h"
 #include "transporter.h"
 #include "mission.h"
+#include "droidhot.h"
 #include <glm/gtx/transform.hpp>
 
 #define GetRadius(x) ((x)->sradius)
@@ -412,7 +413,7 @@ static bool displayCompObj(DROID *psDroid, bool bButton, const glm::mat4 &viewMa
 	else
 	{
 		pieFlag = pie_SHADOW;
-		brightness = pal_SetBrightness(psDroid->illumination);
+		brightness = pal_SetBrightness(droidHot.illumination[psDroid->hotSlot]);
 		// NOTE: Beware of transporters that are offscreen, on a mission!  We should *not* be checking tiles at this point in time!
 		if (!isTransporter(psDroid) && !missionIsOffworld())
 		{
@@ -41,6 +41,7 @@
 #include "multiint.h"
 #include "multiplay.h"
 #include "radar.h"
+#include "replay.h"
 #include "seqdisp.h"
 #include "texture.h"
 #include "warzoneconfig.h"
@@ -149,6 +150,7 @@ bool loadConfig()
 	game.base = ini.value("base", CAMP_BASE).toInt();
 	game.alliance = ini.value("alliance", NO_ALLIANCES).toInt();
 	game.scavengers = ini.value("scavengers", false).toBool();
+	game.deltaEncoding = ini.value("net_delta", true).toBool();
 	memset(&ingame.phrases, 0, sizeof(ingame.phrases));
 	for (int i = 1; i < 5; i++)
 	{
@@ -165,6 +167,9 @@ bool loadConfig()
 	{
 		setTextureSize(ini.value("textureSize").toInt());
 	}
+	setTextureCache(ini.value("textureCache", true).toBool());
+	replaySetRecording(ini.value("replayRecording", true).toBool());
+	replaySetMaxKept(std::max(ini.value("replayMaxKept", 20).toInt(), 0));
 	NetPlay.isUPNP = ini.value("UPnP", true).toBool();
 	if (ini.contains("antialiasing"))
 	{
@@ -261,6 +266,9 @@ bool saveConfig()
 	ini.setValue("vsync", war_GetVsync());
 	ini.setValue("displayScale", war_GetDisplayScale());
 	ini.setValue("textureSize", getTextureSize());
+	ini.setValue("textureCache", getTextureCache());
+	ini.setValue("replayRecording", replayGetRecording());
+	ini.setValue("replayMaxKept", replayGetMaxKept());
 	ini.setValue("antialiasing", war_getAntialiasing());
 	ini.setValue("UPnP", (SDWORD)NetPlay.isUPNP);
 	ini.setValue("rotateRadar", rotateRadar);
@@ -289,6 +297,7 @@ bool saveConfig()
 			ini.setValue("base", game.base);				// size of base
 			ini.setValue("alliance", game.alliance);		// allow alliances
 			ini.setValue("scavengers", game.scavengers);
+			ini.setValue("net_delta", game.deltaEncoding);
 		}
 		ini.setValue("playerName", (char *)sPlayer);		// player name
 	}
@@ -368,6 +377,7 @@ bool reloadMPConfig()
 	game.power = ini.value("powerLevel", LEV_MED).toInt();
 	game.base = ini.value("base", CAMP_BASE).toInt();
 	game.alliance = ini.value("alliance", NO_ALLIANCES).toInt();
+	game.deltaEncoding = ini.value("net_delta", true).toBool();
 
 	return true;
 }
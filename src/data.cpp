@@ -518,22 +518,42 @@ static void dataImageRelease(void *pData)
 }
 
 
-/* Load an audio file */
-static bool dataAudioLoad(const char *fileName, void **ppData)
+/* Decode an audio file, on any thread */
+static bool dataAudioDecode(const char *fileName, void **ppDecoded)
 {
 	if (audio_Disabled() == true)
 	{
-		*ppData = nullptr;
+		*ppDecoded = nullptr;
 		// No error occurred (sound is just disabled), so we return true
 		return true;
 	}
 
-	// Load the track from a file
-	*ppData = sound_LoadTrackFromFile(fileName);
+	*ppDecoded = sound_DecodeTrackFromFile(fileName);
+
+	return *ppDecoded != nullptr;
+}
+
+/* Load a decoded audio file */
+static bool dataAudioLoad(const char *fileName, void *pDecoded, void **ppData)
+{
+	if (pDecoded == nullptr)
+	{
+		*ppData = nullptr;
+		// Sound is disabled
+		return true;
+	}
+
+	// Make the track from the decoded file
+	*ppData = sound_CreateTrack((soundDataBuffer *)pDecoded);
 
 	return *ppData != nullptr;
 }
 
+static void dataAudioDecodedRelease(void *pDecoded)
+{
+	free(pDecoded);
+}
+
 /* Load an audio file */
 static bool dataAudioCfgLoad(const char *fileName, void **ppData)
 {
@@ -735,7 +755,6 @@ static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 {
 	{"SFEAT", bufferSFEATLoad, dataSFEATRelease},                  //feature stats file
 	{"STEMPL", bufferSTEMPLLoad, dataSTEMPLRelease},               //template and associated files
-	{"WAV", dataAudioLoad, (RES_FREE)sound_ReleaseTrack},
 	{"SWEAPON", bufferSWEAPONLoad, dataReleaseStats},
 	{"SBPIMD", bufferSBPIMDLoad, dataReleaseStats},
 	{"SBRAIN", bufferSBRAINLoad, dataReleaseStats},
@@ -765,6 +784,20 @@ static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 	{"RESCH", bufferRESCHLoad, dataRESCHRelease},                  //research stats files
 };
 
+struct RES_TYPE_MIN_DECODE
+{
+	const char *aType;                      ///< points to the string defining the type (e.g. WAV)
+	RES_FILEDECODE decode;                  ///< routine to decode the file, on any thread
+	RES_DECODEDLOAD decodedLoad;            ///< routine to load what was decoded
+	RES_FREE decodedRelease;                ///< routine to release what was decoded, if not loaded
+	RES_FREE release;                       ///< routine to release the data (NULL indicates none)
+};
+
+static const RES_TYPE_MIN_DECODE DecodeResourceTypes[] =
+{
+	{"WAV", dataAudioDecode, dataAudioLoad, dataAudioDecodedRelease, (RES_FREE)sound_ReleaseTrack},
+};
+
 /* Pass all the data loading functions to the framework library */
 bool dataInitLoadFuncs()
 {
@@ -803,5 +836,14 @@ bool dataInitLoadFuncs()
 		}
 	}
 
+	// iterate through decode and load functions
+	for (const RES_TYPE_MIN_DECODE &CurrentType : DecodeResourceTypes)
+	{
+		if (!resAddDecodeLoad(CurrentType.aType, CurrentType.decode, CurrentType.decodedLoad, CurrentType.decodedRelease, CurrentType.release))
+		{
+			return false; // error whilst adding a decode load
+		}
+	}
+
 	return true;
 }
@@ -78,8 +78,10 @@
 #include "multiplay.h"
 #include "advvis.h"
 #include "cmddroid.h"
+#include "game.h"
 #include "terrain.h"
 #include "warzoneconfig.h"
+#include "droidhot.h"
 
 /********************  Prototypes  ********************/
 
@@ -124,6 +126,7 @@ extern bool writeGameInfo(const char *pFileName); // Used to help debug issues w
 static WzText txtLevelName;
 static WzText txtDebugStatus;
 static WzText txtCurrentTime;
+static WzText txtSaveProgress;
 static WzText txtShowFPS;
 // show Samples text
 static WzText txtShowSamples_Que;
@@ -848,6 +851,15 @@ void draw3DScene()
 		txtCurrentTime.render(RET_X + 134, 422 + E_H, WZCOL_TEXT_MEDIUM);
 	}
 
+	unsigned savedFiles, saveFiles;
+	if (getWidgetsStatus() && saveGameProgress(&savedFiles, &saveFiles))
+	{
+		char saveInfo[255];
+		ssprintf(saveInfo, _("Saving game: %u of %u files written"), savedFiles, saveFiles);
+		txtSaveProgress.setText(saveInfo, font_small);
+		txtSaveProgress.render(RET_X + 134, 398 + E_H, WZCOL_TEXT_MEDIUM);
+	}
+
 	while (player.r.y > DEG(360))
 	{
 		player.r.y -= DEG(360);
@@ -1800,25 +1812,33 @@ static void displayProximityMsgs(const glm::mat4& viewMatrix)
 /// Draw the droids
 static void displayDynamicObjects(const glm::mat4 &viewMatrix)
 {
-	/* Need to go through all the droid lists */
-	for (unsigned player = 0; player <= MAX_PLAYERS; ++player)
+	droidHotUpdate();
+	for (size_t slot = 0; slot < droidHot.size(); ++slot)
 	{
-		BASE_OBJECT *list = player < MAX_PLAYERS ? apsDroidLists[player] : psDestroyedObj;
+		/* No point in adding it if you can't see it? */
+		if (!droidHot.listed[slot] || (droidHot.died[slot] != 0 && droidHot.died[slot] < graphicsTime)
+		    || !droidHot.visible[slot][selectedPlayer]
+		    || !quickClipXYToMaximumTilesFromCurrentPosition(droidHot.pos[slot].x, droidHot.pos[slot].y))
+		{
+			continue;
+		}
+		displayComponentObject(droidHot.droid[slot], viewMatrix);
+	}
 
-		for (; list != nullptr; list = list->psNext)
+	// Droids destroyed during the last few ticks are still drawn.
+	for (BASE_OBJECT *psObj = psDestroyedObj; psObj != nullptr; psObj = psObj->psNext)
+	{
+		if (psObj->type != OBJ_DROID || (psObj->died != 0 && psObj->died < graphicsTime)
+		    || !quickClipXYToMaximumTilesFromCurrentPosition(psObj->pos.x, psObj->pos.y))
 		{
-			if (list->type != OBJ_DROID || (list->died != 0 && list->died < graphicsTime)
-			    || !quickClipXYToMaximumTilesFromCurrentPosition(list->pos.x, list->pos.y))
-			{
-				continue;
-			}
-			DROID *psDroid = castDroid(list);
+			continue;
+		}
+		DROID *psDroid = castDroid(psObj);
 
-			/* No point in adding it if you can't see it? */
-			if (psDroid->visible[selectedPlayer])
-			{
-				displayComponentObject(psDroid, viewMatrix);
-			}
+		/* No point in adding it if you can't see it? */
+		if (psDroid->visible[selectedPlayer])
+		{
+			displayComponentObject(psDroid, viewMatrix);
 		}
 	}
 }
@@ -3772,33 +3792,35 @@ static void	drawDroidSensorLock(DROID *psDroid)
 /// Draw the construction lines for all construction droids
 static	void	doConstructionLines(const glm::mat4 &viewMatrix)
 {
-	for (unsigned i = 0; i < MAX_PLAYERS; i++)
+	droidHotUpdate();
+	for (size_t slot = 0; slot < droidHot.size(); ++slot)
 	{
-		for (DROID *psDroid = apsDroidLists[i]; psDroid; psDroid = psDroid->psNext)
+		if (!droidHot.listed[slot] || droidHot.visible[slot][selectedPlayer] != UBYTE_MAX
+		    || !clipXY(droidHot.pos[slot].x, droidHot.pos[slot].y))
+		{
+			continue;
+		}
+		DROID *psDroid = droidHot.droid[slot];
+		if (psDroid->sMove.Status != MOVESHUFFLE)
 		{
-			if (clipXY(psDroid->pos.x, psDroid->pos.y)
-			    && psDroid->visible[selectedPlayer] == UBYTE_MAX
-			    && psDroid->sMove.Status != MOVESHUFFLE)
+			if (psDroid->action == DACTION_BUILD)
 			{
-				if (psDroid->action == DACTION_BUILD)
+				if (psDroid->order.psObj)
 				{
-					if (psDroid->order.psObj)
+					if (psDroid->order.psObj->type == OBJ_STRUCTURE)
 					{
-						if (psDroid->order.psObj->type == OBJ_STRUCTURE)
-						{
-							addConstructionLine(psDroid, (STRUCTURE *)psDroid->order.psObj, viewMatrix);
-						}
+						addConstructionLine(psDroid, (STRUCTURE *)psDroid->order.psObj, viewMatrix);
 					}
 				}
-				else if ((psDroid->action == DACTION_DEMOLISH) ||
-				         (psDroid->action == DACTION_REPAIR) ||
-				         (psDroid->action == DACTION_RESTORE))
+			}
+			else if ((psDroid->action == DACTION_DEMOLISH) ||
+			         (psDroid->action == DACTION_REPAIR) ||
+			         (psDroid->action == DACTION_RESTORE))
+			{
+				if (psDroid->psActionTarget[0]
+				    && psDroid->psActionTarget[0]->type == OBJ_STRUCTURE)
 				{
-					if (psDroid->psActionTarget[0]
-					    && psDroid->psActionTarget[0]->type == OBJ_STRUCTURE)
-					{
-						addConstructionLine(psDroid, (STRUCTURE *)psDroid->psActionTarget[0], viewMatrix);
-					}
+					addConstructionLine(psDroid, (STRUCTURE *)psDroid->psActionTarget[0], viewMatrix);
 				}
 			}
 		}
@@ -74,6 +74,7 @@
 #include "scriptfuncs.h"			//for ThreatInRange()
 #include "template.h"
 #include "qtscript.h"
+#include "droidhot.h"
 
 #define DEFAULT_RECOIL_TIME	(GAME_TICKS_PER_SEC/4)
 #define	DROID_DAMAGE_SPREAD	(16 - rand()%32)
@@ -344,7 +345,7 @@ DROID::DROID(uint32_t id, unsigned player)
 	sDisplay.screenY = OFF_SCREEN;
 	sDisplay.screenR = 0;
 	sDisplay.imd = nullptr;
-	illumination = UBYTE_MAX;
+	hotSlot = droidHotAlloc(this);
 	resistance = ACTION_START_TIME;	// init the resistance to indicate no EW performed on this droid
 	lastFrustratedTime = 0;		// make sure we do not start the game frustrated
 }
@@ -357,6 +358,7 @@ DROID::~DROID()
 	// Make sure to get rid of some final references in the sound code to this object first
 	// In BASE_OBJECT::~BASE_OBJECT() is too late for this, since some callbacks require us to still be a DROID.
 	audio_RemoveObj(this);
+	droidHotFree(hotSlot);
 
 	DROID *psDroid = this;
 	DROID	*psCurr, *psNext;
@@ -84,6 +84,10 @@ struct DROID : public BASE_OBJECT
 	DROID(uint32_t id, unsigned player);
 	~DROID();
 
+	// Allocated from a pool, see objpool.h.
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
+
 	/// UTF-8 name of the droid. This is generated from the droid template
 	///  WARNING: This *can* be changed by the game player after creation & can be translated, do NOT rely on this being the same for everyone!
 	char            aName[MAX_STR_LENGTH];
@@ -137,7 +141,7 @@ struct DROID : public BASE_OBJECT
 	UDWORD          expectedDamageDirect;                 ///< Expected damage to be caused by all currently incoming direct projectiles. This info is shared between all players,
 	UDWORD          expectedDamageIndirect;                 ///< Expected damage to be caused by all currently incoming indirect projectiles. This info is shared between all players,
 	///< but shouldn't make a difference unless 3 mutual enemies happen to be fighting each other at the same time.
-	UBYTE           illumination;
+	unsigned        hotSlot;                        ///< Where droidhot keeps the copies of the fields read by passes over all droids.
 	/* Movement control data */
 	MOVE_CONTROL    sMove;
 	Spacetime       prevSpacetime;                  ///< Location of droid in previous tick.
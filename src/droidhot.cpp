@@ -0,0 +1,174 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Contiguous storage of the droid fields read by passes over all droids, see droidhot.h.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "objects.h"
+#include "droidhot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+DroidHotState droidHot;
+
+static std::vector<unsigned> droidHotFreeSlots;
+static bool droidHotDirty = true;
+static DROID *droidHotListHeads[MAX_PLAYERS];  ///< First droid of each of apsDroidLists at the last droidHotUpdate().
+
+unsigned droidHotAlloc(DROID *psDroid)
+{
+	unsigned slot;
+	if (droidHotFreeSlots.empty())
+	{
+		slot = droidHot.size();
+		droidHot.droid.push_back(nullptr);
+		droidHot.listed.push_back(0);
+		droidHot.listIndex.push_back(0);
+		droidHot.pos.emplace_back();
+		droidHot.rot.emplace_back();
+		droidHot.player.push_back(0);
+		droidHot.died.push_back(0);
+		droidHot.visible.emplace_back();
+		droidHot.illumination.push_back(0);
+	}
+	else
+	{
+		slot = droidHotFreeSlots.back();
+		droidHotFreeSlots.pop_back();
+	}
+	droidHot.droid[slot] = psDroid;
+	droidHot.listed[slot] = 0;  // Not filled in until the next droidHotUpdate().
+	droidHot.illumination[slot] = UBYTE_MAX;
+	droidHotDirty = true;
+	return slot;
+}
+
+void droidHotFree(unsigned slot)
+{
+	ASSERT_OR_RETURN(, slot < droidHot.size() && droidHot.droid[slot] != nullptr, "Bad droid slot %u", slot);
+	droidHot.droid[slot] = nullptr;
+	droidHot.listed[slot] = 0;
+	droidHotFreeSlots.push_back(slot);
+	droidHotDirty = true;
+}
+
+void droidHotChanged()
+{
+	droidHotDirty = true;
+}
+
+void droidHotUpdate()
+{
+	// Droids are prepended to the lists, and missions swap whole lists, so either changes the first droid.
+	if (!droidHotDirty && std::equal(std::begin(droidHotListHeads), std::end(droidHotListHeads), apsDroidLists))
+	{
+		return;
+	}
+	droidHotDirty = false;
+
+	std::fill(droidHot.listed.begin(), droidHot.listed.end(), 0);
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		droidHotListHeads[player] = apsDroidLists[player];
+		uint32_t index = 0;
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext, ++index)
+		{
+			unsigned slot = psDroid->hotSlot;
+			droidHot.listed[slot] = 1;
+			droidHot.listIndex[slot] = index;
+			droidHot.pos[slot] = psDroid->pos;
+			droidHot.rot[slot] = psDroid->rot;
+			droidHot.player[slot] = psDroid->player;
+			droidHot.died[slot] = psDroid->died;
+			std::copy(std::begin(psDroid->visible), std::end(psDroid->visible), droidHot.visible[slot].begin());
+		}
+	}
+}
+
+/// Sum of the fields read from a droid by gridReset() and processVisibility(), so the reads can't be left out.
+static uint32_t droidHotBenchmarkRead(DROID const *psDroid)
+{
+	uint32_t sum = psDroid->pos.x + psDroid->pos.y + psDroid->player + psDroid->died + psDroid->gridSlot;
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		sum += psDroid->seenThisTick[player] + psDroid->visible[player];
+	}
+	return sum;
+}
+
+DroidHotBenchmarkResult droidHotBenchmark(unsigned repeats)
+{
+	DroidHotBenchmarkResult result;
+	std::vector<uint8_t> flush(128 << 20);  // Bigger than the caches, to start each pass with the droids in memory.
+	uint32_t sum = 0;
+	auto evict = [&]() {
+		for (size_t i = 0; i < flush.size(); i += 64)
+		{
+			++flush[i];
+		}
+	};
+	auto time = [&](uint64_t &microseconds, std::function<void ()> const &pass) {
+		evict();
+		auto start = std::chrono::steady_clock::now();
+		pass();
+		microseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	for (unsigned repeat = 0; repeat < repeats; ++repeat)
+	{
+		time(result.listMicroseconds, [&]() {
+			for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+			{
+				for (DROID const *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+				{
+					sum += droidHotBenchmarkRead(psDroid);
+				}
+			}
+		});
+		time(result.copyMicroseconds, []() {
+			droidHotChanged();
+			droidHotUpdate();
+		});
+		time(result.slotMicroseconds, [&]() {
+			for (unsigned slot = 0; slot < droidHot.size(); ++slot)
+			{
+				if (droidHot.listed[slot])
+				{
+					sum += droidHotBenchmarkRead(droidHot.droid[slot]);
+				}
+			}
+		});
+		time(result.arrayMicroseconds, [&]() {
+			for (unsigned slot = 0; slot < droidHot.size(); ++slot)
+			{
+				if (droidHot.listed[slot])
+				{
+					sum += droidHot.pos[slot].x + droidHot.pos[slot].y + droidHot.player[slot] + droidHot.died[slot];
+				}
+			}
+		});
+	}
+	result.droids = std::count(droidHot.listed.begin(), droidHot.listed.end(), 1);
+	debug(LOG_NEVER, "Droid benchmark checksum %u", sum);
+	return result;
+}
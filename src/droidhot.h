@@ -0,0 +1,91 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Contiguous storage of the droid fields read by passes over all droids.
+ *
+ *  Each droid gets a slot when created, and keeps it until destroyed, whichever list it is in. The position, rotation,
+ *  player, died and visible fields are copies of the DROID fields, taken by droidHotUpdate(), so passes only needing
+ *  those fields can run over the arrays instead of following psNext into DROIDs scattered over the heap. Passes which
+ *  need other fields, or write to the droids, can still run over the slots in any order, and go straight to each
+ *  DROID, without waiting for the previous one to load to find the next. The illumination is only stored here.
+ *
+ *  gridReset() takes the copies at the start of each game tick, and processVisibility() then uses the slots, so the
+ *  game state passes walk the droid lists once a tick between them. Rendering takes the copies again after the tick.
+ *
+ *  Only used from the main thread.
+ */
+
+#ifndef __INCLUDED_SRC_DROIDHOT_H__
+#define __INCLUDED_SRC_DROIDHOT_H__
+
+#include "lib/framework/frame.h"
+#include "lib/framework/vector.h"
+
+#include <array>
+#include <vector>
+
+struct DROID;
+
+struct DroidHotState
+{
+	size_t size() const
+	{
+		return droid.size();
+	}
+
+	std::vector<DROID *> droid;         ///< Droid in each slot, or nullptr if the slot is free.
+	std::vector<uint8_t> listed;        ///< Whether the droid was in apsDroidLists at the last droidHotUpdate().
+	std::vector<uint32_t> listIndex;    ///< Position of the droid in its list of apsDroidLists, if listed.
+	std::vector<Position> pos;
+	std::vector<Rotation> rot;
+	std::vector<uint8_t> player;
+	std::vector<uint32_t> died;
+	std::vector<std::array<uint8_t, MAX_PLAYERS>> visible;
+	std::vector<uint8_t> illumination;  ///< How brightly the droid is lit, only stored here.
+};
+
+extern DroidHotState droidHot;
+
+/// Give a new droid a slot. Called from the DROID constructor.
+unsigned droidHotAlloc(DROID *psDroid);
+/// Free the slot of a droid being destroyed. Called from the DROID destructor.
+void droidHotFree(unsigned slot);
+
+/// The droids have changed, so the copies must be updated before being used again. Called after each game tick, and
+/// when a droid leaves apsDroidLists, since that isn't noticed unless it was first in its list.
+void droidHotChanged();
+/// Copy the fields of the droids in apsDroidLists into their slots, if anything changed since the last time, or any of
+/// the lists was replaced or had a droid added.
+void droidHotUpdate();
+
+/// Results of droidHotBenchmark().
+struct DroidHotBenchmarkResult
+{
+	unsigned droids = 0;            ///< Number of droids in apsDroidLists.
+	uint64_t listMicroseconds = 0;  ///< Reading the fields by following psNext through apsDroidLists.
+	uint64_t copyMicroseconds = 0;  ///< Taking the copies with droidHotUpdate().
+	uint64_t slotMicroseconds = 0;  ///< Reading the same fields from each DROID, going through the slots.
+	uint64_t arrayMicroseconds = 0; ///< Reading the copies of the fields from the arrays.
+};
+
+/// Time reading the fields read by gridReset() and processVisibility() from every droid, with the caches emptied
+/// before each pass, the way the rest of a game tick would. Doesn't change the game state. Call from main thread.
+DroidHotBenchmarkResult droidHotBenchmark(unsigned repeats);
+
+#endif // __INCLUDED_SRC_DROIDHOT_H__
@@ -0,0 +1,69 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Serialisation of the droid orders sent in GAME_DROIDINFO messages.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+
+#include "droidinfo.h"
+
+void NETQueuedDroidInfo(QueuedDroidInfo *info)
+{
+	NETuint8_t(&info->player);
+	NETenum(&info->subType);
+	switch (info->subType)
+	{
+	case ObjOrder:
+	case LocOrder:
+		NETenum(&info->order);
+		if (info->subType == ObjOrder)
+		{
+			NETdeltaUint32(&info->destId, DROIDINFO_DEST_ID);
+			NETenum(&info->destType);
+		}
+		else
+		{
+			NETdeltaInt32(&info->pos.x, DROIDINFO_POS_X);
+			NETdeltaInt32(&info->pos.y, DROIDINFO_POS_Y);
+		}
+		if (info->order == DORDER_BUILD || info->order == DORDER_LINEBUILD)
+		{
+			NETuint32_t(&info->structRef);
+			NETuint16_t(&info->direction);
+		}
+		if (info->order == DORDER_LINEBUILD)
+		{
+			NETdeltaInt32(&info->pos2.x, DROIDINFO_POS2_X);
+			NETdeltaInt32(&info->pos2.y, DROIDINFO_POS2_Y);
+		}
+		if (info->order == DORDER_BUILDMODULE)
+		{
+			NETauto(&info->index);
+		}
+		NETbool(&info->add);
+		break;
+	case SecondaryOrder:
+		NETenum(&info->secOrder);
+		NETenum(&info->secState);
+		break;
+	}
+}
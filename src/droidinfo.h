@@ -0,0 +1,171 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  The droid orders sent in GAME_DROIDINFO messages, see multibot.cpp.
+ */
+
+#ifndef __INCLUDED_SRC_DROIDINFO_H__
+#define __INCLUDED_SRC_DROIDINFO_H__
+
+#include "lib/framework/frame.h"
+#include "lib/framework/vector.h"
+
+#include "orderdef.h"
+
+enum SubType
+{
+	ObjOrder, LocOrder, SecondaryOrder
+};
+
+struct QueuedDroidInfo
+{
+	/// Sorts by order, then finally by droid id, to group multiple droids with the same order.
+	bool operator <(QueuedDroidInfo const &z) const
+	{
+		int orComp = orderCompare(z);
+		if (orComp != 0)
+		{
+			return orComp < 0;
+		}
+		return droidId < z.droidId;
+	}
+	/// Returns 0 if order is the same, non-zero otherwise.
+	int orderCompare(QueuedDroidInfo const &z) const
+	{
+		if (player != z.player)
+		{
+			return player < z.player ? -1 : 1;
+		}
+		if (subType != z.subType)
+		{
+			return subType < z.subType ? -1 : 1;
+		}
+		switch (subType)
+		{
+		case ObjOrder:
+		case LocOrder:
+			if (order != z.order)
+			{
+				return order < z.order ? -1 : 1;
+			}
+			if (subType == ObjOrder)
+			{
+				if (destId != z.destId)
+				{
+					return destId < z.destId ? -1 : 1;
+				}
+				if (destType != z.destType)
+				{
+					return destType < z.destType ? -1 : 1;
+				}
+			}
+			else
+			{
+				if (pos.x != z.pos.x)
+				{
+					return pos.x < z.pos.x ? -1 : 1;
+				}
+				if (pos.y != z.pos.y)
+				{
+					return pos.y < z.pos.y ? -1 : 1;
+				}
+			}
+			if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+			{
+				if (structRef != z.structRef)
+				{
+					return structRef < z.structRef ? -1 : 1;
+				}
+				if (direction != z.direction)
+				{
+					return direction < z.direction ? -1 : 1;
+				}
+			}
+			if (order == DORDER_LINEBUILD)
+			{
+				if (pos2.x != z.pos2.x)
+				{
+					return pos2.x < z.pos2.x ? -1 : 1;
+				}
+				if (pos2.y != z.pos2.y)
+				{
+					return pos2.y < z.pos2.y ? -1 : 1;
+				}
+			}
+			if (order == DORDER_BUILDMODULE)
+			{
+				if (index != z.index)
+				{
+					return index < z.index ? -1 : 1;
+				}
+			}
+			if (add != z.add)
+			{
+				return add < z.add ? -1 : 1;
+			}
+			break;
+		case SecondaryOrder:
+			if (secOrder != z.secOrder)
+			{
+				return secOrder < z.secOrder ? -1 : 1;
+			}
+			if (secState != z.secState)
+			{
+				return secState < z.secState ? -1 : 1;
+			}
+			break;
+		}
+		return 0;
+	}
+
+	uint8_t     player;
+	uint32_t    droidId;
+	SubType     subType;
+	// subType == ObjOrder || subType == LocOrder
+	DROID_ORDER order;
+	uint32_t    destId;     // if (subType == ObjOrder)
+	OBJECT_TYPE destType;   // if (subType == ObjOrder)
+	Vector2i    pos;        // if (subType == LocOrder)
+	uint32_t    y;          // if (subType == LocOrder)
+	uint32_t    structRef;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+	uint16_t    direction;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+	uint32_t    index;      // if (order == DORDER_BUILDMODULE)
+	Vector2i    pos2;       // if (order == DORDER_LINEBUILD)
+	bool        add;
+	// subType == SecondaryOrder
+	SECONDARY_ORDER secOrder;
+	SECONDARY_STATE secState;
+};
+
+/// Fields sent as the difference from the previous GAME_DROIDINFO, since orders in a row tend to be near the same place and for the same droids.
+enum DroidInfoDeltaField
+{
+	DROIDINFO_DEST_ID,
+	DROIDINFO_POS_X,
+	DROIDINFO_POS_Y,
+	DROIDINFO_POS2_X,
+	DROIDINFO_POS2_Y,
+	DROIDINFO_FIRST_DROID_ID,
+};
+
+/// Does not read/write info->droidId!
+void NETQueuedDroidInfo(QueuedDroidInfo *info);
+
+#endif // __INCLUDED_SRC_DROIDINFO_H__
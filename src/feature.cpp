@@ -48,6 +48,7 @@
 #include "multiplay.h"
 
 #include "mapgrid.h"
+#include "fpath.h"
 #include "display3d.h"
 #include "random.h"
 
@@ -295,6 +296,7 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 			}
 		}
 	}
+	fpathBlockingTilesChanged(b);
 	psFeature->pos.z = map_TileHeight(b.map.x, b.map.y);//jps 18july97
 
 	return psFeature;
@@ -375,6 +377,7 @@ bool removeFeature(FEATURE *psDel)
 			}
 		}
 	}
+	fpathBlockingTilesChanged(b);
 
 	if (psDel->psStats->subType == FEAT_GEN_ARTE || psDel->psStats->subType == FEAT_OIL_DRUM)
 	{
@@ -503,6 +506,7 @@ bool destroyFeature(FEATURE *psDel, unsigned impactTime)
 				}
 			}
 		}
+		fpathBlockingTilesChanged(b);
 	}
 
 	removeFeature(psDel);
@@ -25,6 +25,7 @@
  */
 
 #include <future>
+#include <thread>
 #include <unordered_map>
 
 #include "lib/framework/frame.h"
@@ -56,52 +57,104 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = nullptr;
+using packagedPathJob = wz::packaged_task<PATHRESULT()>;
+
+/// Jobs waiting to be processed in a lane. Jobs in the same lane are run in order, one at a time.
+struct PathLane
+{
+	std::list<packagedPathJob> jobs;
+	bool busy = false;              ///< A thread is processing a job from this lane.
+};
+
+static std::vector<WZ_THREAD *> fpathThreads;
+static int              fpathThreadsWanted = 0;  ///< Number of threads to start, 0 means choose automatically.
 static WZ_MUTEX         *fpathMutex = nullptr;
 static WZ_SEMAPHORE     *fpathSemaphore = nullptr;
-using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+static int              fpathIdleThreads = 0;    ///< Threads waiting on fpathSemaphore, which have not yet been woken up.
+static PathLane         pathLanes[FPATH_LANES];
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = nullptr;
+static PATHRESULT fpathExecute(unsigned lane, PATHJOB psJob);
 
-static PATHRESULT fpathExecute(PATHJOB psJob);
 
+/// Returns the lane of a job which can be started now, or FPATH_LANES if there is none. Call with fpathMutex locked.
+static unsigned fpathFindReadyLane(unsigned start)
+{
+	for (unsigned i = 0; i < FPATH_LANES; ++i)
+	{
+		unsigned lane = (start + i) % FPATH_LANES;
+		if (!pathLanes[lane].busy && !pathLanes[lane].jobs.empty())
+		{
+			return lane;
+		}
+	}
+	return FPATH_LANES;
+}
 
-/** This runs in a separate thread */
-static int fpathThreadFunc(void *)
+/** This runs in separate threads */
+static int fpathThreadFunc(void *data)
 {
+	unsigned nextLane = (uintptr_t)data % FPATH_LANES;  // Start searching in different lanes, so threads don't all fight over the first lane.
+
 	wzMutexLock(fpathMutex);
 
 	while (!fpathQuit)
 	{
-		if (pathJobs.empty())
+		unsigned lane = fpathFindReadyLane(nextLane);
+		if (lane == FPATH_LANES)
 		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			++fpathIdleThreads;
 			wzMutexUnlock(fpathMutex);
 			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
 			continue;
 		}
 
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		// Take the first job in the lane, and keep the lane to ourselves until done, since the results depend on the order.
+		packagedPathJob job = std::move(pathLanes[lane].jobs.front());
+		pathLanes[lane].jobs.pop_front();
+		pathLanes[lane].busy = true;
 
 		wzMutexUnlock(fpathMutex);
 		job();
 		wzMutexLock(fpathMutex);
 
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
+		pathLanes[lane].busy = false;
+		nextLane = (lane + 1) % FPATH_LANES;
 	}
 	wzMutexUnlock(fpathMutex);
 	return 0;
 }
 
+/// Wakes up a sleeping thread, if there is one. Call with fpathMutex locked.
+static void fpathWakeThread()
+{
+	if (fpathIdleThreads > 0)
+	{
+		--fpathIdleThreads;
+		wzSemaphorePost(fpathSemaphore);
+	}
+}
+
+void fpathSetThreadCount(int count)
+{
+	fpathThreadsWanted = std::max(count, 0);
+}
+
+static int fpathChooseThreadCount()
+{
+	if (fpathThreadsWanted > 0)
+	{
+		return std::min(fpathThreadsWanted, FPATH_LANES);  // Any more threads would have nothing to do.
+	}
+	int count = 1;
+#if !defined(WZ_CC_MINGW)
+	// Leave a core for the main thread.
+	count = std::max<int>(std::thread::hardware_concurrency() - 1, 1);
+#endif
+	return std::min(count, FPATH_LANES);
+}
+
 
 // initialise the findpath module
 bool fpathInitialise()
@@ -109,13 +162,22 @@ bool fpathInitialise()
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	// Set by a cheat, and changes the routes found, so mustn't carry over from an earlier game into a network game.
+	fpathSetJumpPointSearch(false);
+
+	if (fpathThreads.empty())
 	{
 		fpathMutex = wzMutexCreate();
 		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, nullptr);
-		wzThreadStart(fpathThread);
+		fpathIdleThreads = 0;
+		int count = fpathChooseThreadCount();
+		for (int i = 0; i < count; ++i)
+		{
+			WZ_THREAD *thread = wzThreadCreate(fpathThreadFunc, (void *)(uintptr_t)i);
+			fpathThreads.push_back(thread);
+			wzThreadStart(thread);
+		}
+		debug(LOG_INFO, "Started %d path-finding threads", count);
 	}
 
 	return true;
@@ -124,20 +186,30 @@ bool fpathInitialise()
 
 void fpathShutdown()
 {
-	// Signal the path finding thread to quit
-	fpathQuit = true;
-	wzSemaphorePost(fpathSemaphore);  // Wake up thread.
-
-	if (fpathThread)
+	if (!fpathThreads.empty())
 	{
-		wzThreadJoin(fpathThread);
-		fpathThread = nullptr;
+		// Signal the path finding threads to quit
+		wzMutexLock(fpathMutex);
+		fpathQuit = true;
+		for (size_t i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzSemaphorePost(fpathSemaphore);  // Wake up threads.
+		}
+		wzMutexUnlock(fpathMutex);
+
+		for (WZ_THREAD *thread : fpathThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		fpathThreads.clear();
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = nullptr;
 		wzSemaphoreDestroy(fpathSemaphore);
 		fpathSemaphore = nullptr;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = nullptr;
+	}
+	for (auto &lane : pathLanes)
+	{
+		lane.jobs.clear();
 	}
 	fpathHardTableReset();
 }
@@ -392,21 +464,21 @@ queuePathfinding:
 	// job or result for each droid in the system at any time.
 	fpathRemoveDroidData(id);
 
-	packagedPathJob task([job]() { return fpathExecute(job); });
+	unsigned lane = fpathLane(tX, tY);
+	packagedPathJob task([lane, job]() { return fpathExecute(lane, job); });
 	pathResults[id] = task.get_future();
 
-	// Add to end of list
+	// Add to end of lane
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
-	wzMutexUnlock(fpathMutex);
-
-	if (isFirstJob)
+	size_t queueLength = pathLanes[lane].jobs.size();
+	pathLanes[lane].jobs.push_back(std::move(task));
+	if (!pathLanes[lane].busy)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		fpathWakeThread();
 	}
+	wzMutexUnlock(fpathMutex);
 
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	objTrace(id, "Queued up a path-finding request to (%d, %d) in lane %u, %d items earlier in lane", tX, tY, lane, (int)queueLength);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -456,8 +528,8 @@ FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD tX, SDWORD tY, FPATH_MOVETYP
 	                  psDroid->droidType, moveType, psDroid->player, acceptNearest, dstStructure);
 }
 
-// Run only from path thread
-PATHRESULT fpathExecute(PATHJOB job)
+// Run only from path threads
+PATHRESULT fpathExecute(unsigned lane, PATHJOB job)
 {
 	PATHRESULT result;
 	result.droidID = job.droidID;
@@ -465,7 +537,7 @@ PATHRESULT fpathExecute(PATHJOB job)
 	result.retval = FPR_FAILED;
 	result.originalDest = Vector2i(job.destX, job.destY);
 
-	ASR_RETVAL retval = fpathAStarRoute(&result.sMove, &job);
+	ASR_RETVAL retval = fpathAStarRoute(lane, &result.sMove, &job);
 
 	ASSERT(retval != ASR_OK || result.sMove.asPath, "Ok result but no path in result");
 	ASSERT(retval == ASR_FAILED || result.sMove.numPoints > 0, "Ok result but no length of path in result");
@@ -511,7 +583,10 @@ static int fpathJobQueueLength()
 	int count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	for (auto const &lane : pathLanes)
+	{
+		count += lane.jobs.size() + lane.busy;  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	}
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -545,10 +620,10 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength;
 
 	/* Check initial state */
-	assert(fpathThread != nullptr);
+	assert(!fpathThreads.empty());
 	assert(fpathMutex != nullptr);
 	assert(fpathSemaphore != nullptr);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -616,7 +691,7 @@ void fpathTest(int x, int y, int x2, int y2)
 	{
 		fpathRemoveDroidData(i);
 	}
-	//assert(pathJobs.empty()); // can now be marked .deleted as well
+	//assert(fpathJobQueueLength() == 0); // can now be marked .deleted as well
 	assert(pathResults.empty());
 	(void)r;  // Squelch unused-but-set warning.
 }
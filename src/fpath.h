@@ -43,6 +43,7 @@ enum FPATH_MOVETYPE
 };
 
 struct PathBlockingMap;
+struct PathClusterMap;
 
 struct PATHJOB
 {
@@ -55,6 +56,8 @@ struct PATHJOB
 	FPATH_MOVETYPE	moveType;
 	int		owner;		///< Player owner
 	std::shared_ptr<PathBlockingMap> blockingMap;   ///< Map of blocking tiles.
+	std::shared_ptr<PathClusterMap const> clusterMap;  ///< Map of connected regions, for planning long routes. May be null.
+	bool            jumpPointSearch;        ///< Whether to use jump point search for new routes, see fpathSetJumpPointSearch().
 	bool		acceptNearest;
 	bool            deleted;        ///< Droid was deleted, so throw away result when complete. Must still process this PATHJOB, since processing order can affect resulting paths (but can't affect the path length).
 };
@@ -66,6 +69,11 @@ enum FPATH_RETVAL
 	FPR_WAIT,       ///< route is being calculated by the path-finding thread
 };
 
+/** Set the number of path-finding threads to start in fpathInitialise(), 0 to choose automatically.
+ *  Does not affect the resulting paths.
+ */
+void fpathSetThreadCount(int count);
+
 /** Initialise the path-finding module.
  */
 bool fpathInitialise();
@@ -84,6 +92,16 @@ FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD targetX, SDWORD targetY, FPA
 bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
                                PROPULSION_TYPE propulsion2, int player2, FPATH_MOVETYPE moveType2);
 
+/** Notify the path-finding module that the blocking tiles in the given area may have changed.
+ *
+ *  Call from main thread, whenever structures or features are added, removed, opened or closed. The cached
+ *  blocking maps are patched when next used.
+ */
+void fpathBlockingTilesChanged(StructureBounds const &area);
+
+/// Notify the path-finding module that the threat bits of the given player have changed. Call from main thread.
+void fpathDangerChanged(int player);
+
 /** Function pointer to the currently in-use blocking tile check function.
  *
  *  This function will check if the map tile at the given location should be considered to block droids
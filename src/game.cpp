@@ -29,6 +29,7 @@
 #include "lib/framework/math_ext.h"
 #include "lib/framework/wzconfig.h"
 #include "lib/framework/file.h"
+#include "lib/framework/filewriter.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/opengl.h"
@@ -1661,6 +1662,8 @@ so can be called in levLoadData when starting a game from a load save game*/
 // -----------------------------------------------------------------------------------------
 bool loadGameInit(const char *fileName)
 {
+	saveGameFlush();  // Don't load a save which is still being written.
+
 	if (!gameLoad(fileName))
 	{
 		debug(LOG_ERROR, "Corrupted / unsupported savegame file %s, Unable to load!", fileName);
@@ -1837,6 +1840,8 @@ bool loadGame(const char *pGameToLoad, bool keepObjects, bool freeMem, bool User
 	UWORD           missionScrollMinX = 0, missionScrollMinY = 0,
 	                missionScrollMaxX = 0, missionScrollMaxY = 0;
 
+	saveGameFlush();  // Don't load a save which is still being written.
+
 	/* Stop the game clock */
 	gameTimeStop();
 
@@ -2638,7 +2643,70 @@ error:
 }
 // -----------------------------------------------------------------------------------------
 
-bool saveGame(const char *aFileName, GAME_TYPE saveType)
+static bool savingGame = false;               ///< Whether the files of the last save are still being written.
+static char savingGameName[PATH_MAX] = {'\0'};
+static uint32_t savingGameStartTime = 0;
+static bool savingGameAnnounce = false;       ///< Whether to tell the player when the last save has been written.
+
+/// Reports how writing the last save went, once all its files are written.
+static void saveGameFinished(bool ok)
+{
+	savingGame = false;
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Failed to write %s", savingGameName);
+		addConsoleMessage(_("Could not save game!"), LEFT_JUSTIFY, NOTIFY_MESSAGE);
+		deleteSaveGame(savingGameName);
+		return;
+	}
+	debug(LOG_SAVE, "Finished writing %s, %u ms after starting to save it", savingGameName, wzGetTicks() - savingGameStartTime);
+	if (savingGameAnnounce)
+	{
+		char msg[256] = {'\0'};
+		sstrcpy(msg, _("GAME SAVED: "));
+		sstrcat(msg, savingGameName);
+		addConsoleMessage(msg, LEFT_JUSTIFY, NOTIFY_MESSAGE);
+	}
+}
+
+void saveGameUpdate()
+{
+	if (!savingGame)
+	{
+		return;
+	}
+	FileWriterProgress progress = fileWriterProgress();
+	if (progress.done < progress.total)
+	{
+		return;
+	}
+	saveGameFinished(fileWriterWait());
+}
+
+bool saveGameProgress(unsigned *done, unsigned *total)
+{
+	if (!savingGame)
+	{
+		return false;
+	}
+	FileWriterProgress progress = fileWriterProgress();
+	*done = progress.done;
+	*total = progress.total;
+	return true;
+}
+
+void saveGameFlush()
+{
+	if (!savingGame)
+	{
+		return;
+	}
+	FileWriterProgress progress = fileWriterProgress();
+	debug(LOG_SAVE, "Waiting for %u of %u files of %s to be written", progress.total - progress.done, progress.total, savingGameName);
+	saveGameFinished(fileWriterWait());
+}
+
+bool saveGame(const char *aFileName, GAME_TYPE saveType, bool announce)
 {
 	UDWORD			fileExtension;
 	DROID			*psDroid, *psNext;
@@ -2647,6 +2715,7 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType)
 	triggerEvent(TRIGGER_GAME_SAVING);
 
 	ASSERT_OR_RETURN(false, aFileName && strlen(aFileName) > 4, "Bad savegame filename");
+	saveGameFlush();  // Don't write two saves at once, they might be the same one.
 	sstrcpy(CurrentFileName, aFileName);
 	debug(LOG_WZ, "saveGame: %s", CurrentFileName);
 
@@ -2654,6 +2723,11 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType)
 	gameTimeStop();
 	sanityUpdate();
 
+	// Everything written through WzConfig or fileWriterSave() from here on is only snapshotted, and written to disk
+	// in the background, while the game carries on. See saveGameUpdate().
+	savingGameStartTime = wzGetTicks();
+	fileWriterBeginBatch();
+
 	/* Write the data to the file */
 	if (!writeGameFile(CurrentFileName, saveType))
 	{
@@ -2925,12 +2999,22 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType)
 	// strip the last filename
 	CurrentFileName[fileExtension - 1] = '\0';
 
+	fileWriterEndBatch();
+	sstrcpy(savingGameName, aFileName);
+	savingGame = true;
+	savingGameAnnounce = announce;
+	debug(LOG_SAVE, "Took %u ms to snapshot %s", wzGetTicks() - savingGameStartTime, aFileName);
+
 	/* Start the game clock */
 	triggerEvent(TRIGGER_GAME_SAVED);
 	gameTimeStart();
 	return true;
 
 error:
+	// Finish writing what was queued, so that the caller can delete the broken save.
+	fileWriterEndBatch();
+	fileWriterWait();
+
 	/* Start the game clock */
 	gameTimeStart();
 
@@ -2949,7 +3033,7 @@ static bool writeMapFile(const char *fileName)
 	if (status)
 	{
 		/* Write the data to the file */
-		status = saveFile(fileName, pFileData, fileSize);
+		status = fileWriterSave(fileName, pFileData, fileSize);
 	}
 
 	if (pFileData != nullptr)
@@ -4233,7 +4317,7 @@ bool loadSaveDroidInit(char *pFileData, UDWORD filesize)
 			{
 				Vector2i startpos = getPlayerStartPosition(psDroid->player);
 
-				psDroid->id = pDroidInit->id > 0 ? pDroidInit->id : 0xFEDBCA98;	// hack to remove droid id zero
+				objmemChangeId(psDroid, pDroidInit->id > 0 ? pDroidInit->id : 0xFEDBCA98);	// hack to remove droid id zero
 				psDroid->rot.direction = DEG(pDroidInit->direction);
 				addDroid(psDroid, apsDroidLists);
 				if (psDroid->droidType == DROID_CONSTRUCT && startpos.x == 0 && startpos.y == 0)
@@ -4598,7 +4682,7 @@ static bool loadSaveDroid(const char *pFileName, DROID **ppsCurrentDroidLists)
 		// Copy the values across
 		if (id > 0)
 		{
-			psDroid->id = id; // force correct ID, unless ID is set to eg -1, in which case we should keep new ID (useful for starting units in campaign)
+			objmemChangeId(psDroid, id); // force correct ID, unless ID is set to eg -1, in which case we should keep new ID (useful for starting units in campaign)
 		}
 		ASSERT(id != 0, "Droid ID should never be zero here");
 		psDroid->body = healthValue(ini, psDroid->originalBody);
@@ -5000,7 +5084,7 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 		}
 		// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 		// the scripts -so in ALL CASES overwrite the ID!
-		psStructure->id = psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98; // hack to remove struct id zero
+		objmemChangeId(psStructure, psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98); // hack to remove struct id zero
 		psStructure->periodicalDamage = psSaveStructure->periodicalDamage;
 		periodicalDamageTime = psSaveStructure->periodicalDamageStart;
 		psStructure->periodicalDamageStart = periodicalDamageTime;
@@ -5122,7 +5206,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		}
 		if (id > 0)
 		{
-			psStructure->id = id;	// force correct ID
+			objmemChangeId(psStructure, id);	// force correct ID
 		}
 
 		// common BASE_OBJECT info
@@ -5326,8 +5410,11 @@ bool writeGameInfo(const char *pFileName)
 	ini.setValue("openGL_GLEW_version", opengl.GLEWversion);
 	ini.setValue("openGL_GLSL_version", opengl.GLSLversion);
 	// NOTE: deprecated for GL 3+. Needed this to check what extensions some chipsets support for the openGL hacks
-	std::string extensions = (const char *) glGetString(GL_EXTENSIONS);
-	ini.setValue("GL_EXTENSIONS", extensions.data());
+	if (!wz_headless)
+	{
+		std::string extensions = (const char *) glGetString(GL_EXTENSIONS);
+		ini.setValue("GL_EXTENSIONS", extensions.data());
+	}
 	ini.endGroup();
 	return true;
 }
@@ -5662,7 +5749,7 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 			scriptSetDerrickPos(pFeature->pos.x, pFeature->pos.y);
 		}
 		//restore values
-		pFeature->id = psSaveFeature->id;
+		objmemChangeId(pFeature, psSaveFeature->id);
 		pFeature->rot.direction = DEG(psSaveFeature->direction);
 		pFeature->periodicalDamage = psSaveFeature->periodicalDamage;
 		if (psHeader->version >= VERSION_14)
@@ -5731,11 +5818,11 @@ bool loadSaveFeature2(const char *pFileName)
 		int id = ini.value("id", -1).toInt();
 		if (id > 0)
 		{
-			pFeature->id = id;
+			objmemChangeId(pFeature, id);
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			objmemChangeId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot = ini.vector3i("rotation");
 
@@ -5960,8 +6047,9 @@ static bool writeTerrainTypeMapFile(char *pFileName)
 	endian_udword(&psHeader->version);
 	endian_udword(&psHeader->quantity);
 
-	if (!saveFile(pFileName, pFileData, fileSize))
+	if (!fileWriterSave(pFileName, pFileData, fileSize))
 	{
+		free(pFileData);
 		return false;
 	}
 	free(pFileData);
@@ -120,7 +120,18 @@ bool loadScriptState(char *pFileName);
 /// Load the terrain types
 bool loadTerrainTypeMap(const char *pFileData, UDWORD filesize);
 
-bool saveGame(const char *aFileName, GAME_TYPE saveType);
+/// Saves the game. Only the snapshot is taken here, most of the files are written in the background afterwards.
+/// If announce, "GAME SAVED" is shown on the console once they have been written.
+bool saveGame(const char *aFileName, GAME_TYPE saveType, bool announce = false);
+
+/// Called each game loop. Reports when the last save has been written, or that it couldn't be.
+void saveGameUpdate();
+
+/// Returns true while the files of the last save are still being written, and how many have been written so far.
+bool saveGameProgress(unsigned *done, unsigned *total);
+
+/// Waits for the last save to be written.
+void saveGameFlush();
 
 // Get the campaign number for loadGameInit game
 UDWORD getCampaign(const char *fileName);
@@ -1128,14 +1128,8 @@ INT_RETVAL intRunWidgets()
 		}
 		else
 		{
-			if (saveGame(sRequestResult, GTYPE_SAVE_START))
+			if (saveGame(sRequestResult, GTYPE_SAVE_START, true))
 			{
-				char msg[256] = {'\0'};
-
-				sstrcpy(msg, _("GAME SAVED: "));
-				sstrcat(msg, saveGameName);
-				addConsoleMessage(msg, LEFT_JUSTIFY, NOTIFY_MESSAGE);
-
 				if (widgGetFromID(psWScreen, IDMISSIONRES_SAVE))
 				{
 					widgDelete(psWScreen, IDMISSIONRES_SAVE);
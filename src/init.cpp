@@ -29,6 +29,8 @@
 
 #include "lib/framework/frameresource.h"
 #include "lib/framework/file.h"
+#include "lib/framework/filewriter.h"
+#include "lib/framework/wzworkers.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/piemode.h"
@@ -93,6 +95,7 @@
 #include "ingameop.h"
 #include "qtscript.h"
 #include "template.h"
+#include "tickprofile.h"
 
 static void initMiscVars();
 
@@ -696,11 +699,11 @@ bool systemInitialise(float horizScaleFactor, float vertScaleFactor)
 		return false;
 	}
 
-	if (!audio_Init(droidAudioTrackStopped, war_getSoundEnabled()))
+	if (!audio_Init(droidAudioTrackStopped, war_getSoundEnabled() && !wz_headless))
 	{
 		debug(LOG_SOUND, "Continuing without audio");
 	}
-	if (war_getSoundEnabled() && war_GetMusicEnabled())
+	if (war_getSoundEnabled() && war_GetMusicEnabled() && !wz_headless)
 	{
 		cdAudio_Open(UserMusicPath);
 	}
@@ -768,6 +771,8 @@ void systemShutdown()
 	widgShutDown();
 	fpathShutdown();
 	mapShutdown();
+	fileWriterShutdown();  // Finish writing any save still being written.
+	wzWorkersShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
 	frameShutDown();	// close screen / SDL / resources / cursors / trig
@@ -1022,6 +1027,13 @@ bool stageOneShutDown()
 
 	scrShutDown();
 	gridShutDown();
+	visShutdown();
+
+	if (tickProfileEnabled())
+	{
+		tickProfileWriteTrace("tickprofile.json");
+		tickProfileEnable(false);
+	}
 
 	debug(LOG_TEXTURE, "== stageOneShutDown ==");
 	modelShutdown();
@@ -1108,6 +1120,7 @@ bool stageTwoInitialise()
 	// Don't ask why this doesn't go in stage three. In fact, don't even ask me what stage one/two/three is supposed to mean, it seems about as descriptive as stage doStuff, stage doMoreStuff and stage doEvenMoreStuff...
 	debug(LOG_MAIN, "Init game queues, I am %d.", selectedPlayer);
 	sendQueuedDroidInfo();  // Discard any pending orders which could later get flushed into the game queue.
+	NETsetDeltaEncoding(game.deltaEncoding);
 	for (i = 0; i < MAX_PLAYERS; ++i)
 	{
 		NETinitQueue(NETgameQueue(i));
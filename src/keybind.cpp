@@ -82,6 +82,9 @@
 #include "template.h"
 #include "qtscript.h"
 #include "multigifts.h"
+#include "astar.h"
+#include "objpool.h"
+#include "droidhot.h"
 
 /*
 	KeyBind.c
@@ -124,6 +127,43 @@ static void noMPCheatMsg()
 }
 
 // --------------------------------------------------------------------------
+void kf_PathBenchmark()
+{
+	PathBenchmarkResult result = fpathAStarBenchmark(PROPULSION_TYPE_WHEELED, 1000);
+	console("Path benchmark: %u routes, %u unreachable, %u mismatches", result.routes, result.unreachable, result.mismatches);
+	console("A*: %u nodes, %u ms. Jump point search: %u nodes, %u ms", (unsigned)result.expanded[0], (unsigned)(result.microseconds[0] / 1000),
+	        (unsigned)result.expanded[1], (unsigned)(result.microseconds[1] / 1000));
+}
+
+void kf_DroidHotBenchmark()
+{
+	DroidHotBenchmarkResult result = droidHotBenchmark(10);
+	console("Droid benchmark: %u droids, 10 passes each", result.droids);
+	console("Lists: %u us. Copying: %u us. Slots: %u us. Copies: %u us", (unsigned)result.listMicroseconds, (unsigned)result.copyMicroseconds,
+	        (unsigned)result.slotMicroseconds, (unsigned)result.arrayMicroseconds);
+}
+
+void kf_ObjectPoolInfo()
+{
+	for (ObjectPoolStats const &stats : objectPoolStats())
+	{
+		console("%s: %u live, %u free, %u slabs of %u byte slots, %llu allocated in total", stats.name, (unsigned)stats.live, (unsigned)stats.free,
+		        (unsigned)stats.slabs, (unsigned)stats.slotSize, (unsigned long long)stats.allocations);
+	}
+}
+
+void kf_TogglePathJumpPointSearch()
+{
+	// Changes the paths found, so everyone would have to agree.
+	if (runningMultiplayer())
+	{
+		noMPCheatMsg();
+		return;
+	}
+	fpathSetJumpPointSearch(!fpathGetJumpPointSearch());
+	CONPRINTF(ConsoleString, (ConsoleString, "Jump point search %s", fpathGetJumpPointSearch() ? "enabled" : "disabled"));
+}
+
 void kf_AutoGame()
 {
 #ifndef DEBUG
@@ -649,6 +689,10 @@ void	kf_FrameRate()
 		                          NETgetStatistic(NetStatisticUncompressedBytes, false),
 		                          NETgetStatistic(NetStatisticPackets, true),
 		                          NETgetStatistic(NetStatisticPackets, false)));
+		CONPRINTF(ConsoleString, (ConsoleString, "NETWORK:  Received message wait (us): median %u  99%% %u  max %u",
+		                          NETgetStatistic(NetStatisticLatencyMedian, false),
+		                          NETgetStatistic(NetStatisticLatency99th, false),
+		                          NETgetStatistic(NetStatisticLatencyMax, false)));
 	}
 	gameStats = !gameStats;
 	CONPRINTF(ConsoleString, (ConsoleString, "Built at %s on %s", __TIME__, __DATE__));
@@ -267,6 +267,10 @@ void kf_BuildNextPage();
 void kf_BuildPrevPage();
 void kf_DamageMe();
 void kf_AutoGame();
+void kf_PathBenchmark();
+void kf_DroidHotBenchmark();
+void kf_ObjectPoolInfo();
+void kf_TogglePathJumpPointSearch();
 
 void kf_PerformanceSample();
 
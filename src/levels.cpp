@@ -54,6 +54,7 @@
 #include "multiint.h"
 #include "qtscript.h"
 #include "wrappers.h"
+#include "tickprofile.h"
 
 extern int lev_get_lineno();
 extern char *lev_get_text();
@@ -1046,6 +1047,8 @@ bool levLoadData(char const *name, Sha256 const *hash, char *pSaveName, GAME_TYP
 	if (autogame_enabled())
 	{
 		gameTimeSetMod(Rational(500));
+		tickProfileEnable(true);  // Written to tickprofile.json when the game ends.
+		resProfileWriteTrace("startupprofile.json");  // Everything loaded up to the start of the game.
 		if (hostlaunch != 2) // tests will specify the AI manually
 		{
 			jsAutogameSpecific("multiplay/skirmish/semperfi.js", selectedPlayer);
@@ -38,6 +38,7 @@
 #include "lighting.h"
 #include "display3d.h"
 #include "terrain.h"
+#include "droidhot.h"
 
 // These values determine the fog when fully zoomed in
 // Determine these when fully zoomed in
@@ -305,17 +306,18 @@ void UpdateFogDistance(float distance)
 #define MIN_DROID_LIGHT_LEVEL	96
 #define	DROID_SEEK_LIGHT_SPEED	2
 
-void calcDroidIllumination(DROID *psDroid)
+// Move the illumination towards the light level of the tiles around pos.
+static void calcIllumination(Vector2i pos, uint8_t &illumination)
 {
 	int lightVal, presVal, retVal;
 	float adjust;
-	const int tileX = map_coord(psDroid->pos.x);
-	const int tileY = map_coord(psDroid->pos.y);
+	const int tileX = map_coord(pos.x);
+	const int tileY = map_coord(pos.y);
 
 	/* Are we at the edge, or even on the map */
 	if (!tileOnMap(tileX, tileY))
 	{
-		psDroid->illumination = UBYTE_MAX;
+		illumination = UBYTE_MAX;
 		return;
 	}
 	else if (tileX <= 1 || tileX >= mapWidth - 2 || tileY <= 1 || tileY >= mapHeight - 2)
@@ -339,7 +341,7 @@ void calcDroidIllumination(DROID *psDroid)
 	{
 		lightVal = 255;
 	}
-	presVal = psDroid->illumination;
+	presVal = illumination;
 	adjust = (float)lightVal - (float)presVal;
 	adjust *= graphicsTimeAdjustedIncrement(DROID_SEEK_LIGHT_SPEED);
 	retVal = presVal + adjust;
@@ -347,7 +349,24 @@ void calcDroidIllumination(DROID *psDroid)
 	{
 		retVal = 255;
 	}
-	psDroid->illumination = retVal;
+	illumination = retVal;
+}
+
+void calcDroidIllumination(DROID *psDroid)
+{
+	calcIllumination(psDroid->pos.xy, droidHot.illumination[psDroid->hotSlot]);
+}
+
+void calcAllDroidsIllumination()
+{
+	droidHotUpdate();
+	for (size_t slot = 0; slot < droidHot.size(); ++slot)
+	{
+		if (droidHot.listed[slot])
+		{
+			calcIllumination(droidHot.pos[slot].xy, droidHot.illumination[slot]);
+		}
+	}
 }
 
 void doBuildingLights()
@@ -39,5 +39,7 @@ void lightValueForTile(UDWORD tileX, UDWORD tileY);
 void doBuildingLights();
 void UpdateFogDistance(float distance);
 void calcDroidIllumination(DROID *psDroid);
+/// Update the illumination of all droids in apsDroidLists, without touching the droids.
+void calcAllDroidsIllumination();
 
 #endif // __INCLUDED_SRC_LIGHTNING_H__
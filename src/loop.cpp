@@ -85,6 +85,9 @@
 #include "random.h"
 #include "qtscript.h"
 #include "version.h"
+#include "tickprofile.h"
+#include "droidhot.h"
+#include "replay.h"
 
 #include "warzoneconfig.h"
 
@@ -133,8 +136,68 @@ LOOP_MISSION_STATE		loopMissionState = LMS_NORMAL;
 // this is set by scrStartMission to say what type of new level is to be started
 LEVEL_TYPE nextMissionType = LDS_NONE;
 
+/// Deal with the mission state, returns GAMECODE_CONTINUE unless the level should change.
+static GAMECODE missionStateUpdate()
+{
+	switch (loopMissionState)
+	{
+	case LMS_CLEAROBJECTS:
+		missionDestroyObjects();
+		setScriptPause(true);
+		loopMissionState = LMS_SETUPMISSION;
+		break;
+
+	case LMS_NORMAL:
+		// default
+		break;
+	case LMS_SETUPMISSION:
+		setScriptPause(false);
+		if (!setUpMission(nextMissionType))
+		{
+			return GAMECODE_QUITGAME;
+		}
+		break;
+	case LMS_SAVECONTINUE:
+		// just wait for this to be changed when the new mission starts
+		break;
+	case LMS_NEWLEVEL:
+		//nextMissionType = MISSION_NONE;
+		nextMissionType = LDS_NONE;
+		return GAMECODE_NEWLEVEL;
+		break;
+	case LMS_LOADGAME:
+		return GAMECODE_LOADGAME;
+		break;
+	default:
+		ASSERT(false, "unknown loopMissionState");
+		break;
+	}
+
+	return GAMECODE_CONTINUE;
+}
+
+/// Replaces renderLoop() when running headless. Does everything needed to keep the game running, but draws nothing and takes no input.
+static GAMECODE headlessLoop()
+{
+	if (!paused && !gameUpdatePaused() && bMultiPlayer)
+	{
+		multiPlayerLoop();
+	}
+	if (!paused && !consolePaused())
+	{
+		updateConsoleMessages();
+	}
+
+	return missionStateUpdate();
+}
+
 static GAMECODE renderLoop()
 {
+	if (wz_headless)
+	{
+		return headlessLoop();
+	}
+
 	if (bMultiPlayer && !NetPlay.isHostAlive && NetPlay.bComms && !NetPlay.isHost)
 	{
 		intAddInGamePopup();
@@ -183,14 +246,7 @@ static GAMECODE renderLoop()
 				multiPlayerLoop();
 			}
 
-			for (unsigned i = 0; i < MAX_PLAYERS; i++)
-			{
-				for (DROID *psCurr = apsDroidLists[i]; psCurr; psCurr = psCurr->psNext)
-				{
-					// Don't copy the next pointer - if droids somehow get destroyed in the graphics rendering loop, who cares if we crash.
-					calcDroidIllumination(psCurr);
-				}
-			}
+			calcAllDroidsIllumination();
 		}
 
 		if (!consolePaused())
@@ -246,13 +302,7 @@ static GAMECODE renderLoop()
 
 				if (saveInMissionRes())
 				{
-					if (saveGame(sRequestResult, GTYPE_SAVE_START))
-					{
-						sstrcpy(msgbuffer, _("GAME SAVED: "));
-						sstrcat(msgbuffer, sRequestResult);
-						addConsoleMessage(msgbuffer, LEFT_JUSTIFY, NOTIFY_MESSAGE);
-					}
-					else
+					if (!saveGame(sRequestResult, GTYPE_SAVE_START, true))
 					{
 						ASSERT(false, "Mission Results: saveGame Failed");
 						sstrcpy(msgbuffer, _("Could not save game!"));
@@ -262,13 +312,7 @@ static GAMECODE renderLoop()
 				}
 				else if (bMultiPlayer || saveMidMission())
 				{
-					if (saveGame(sRequestResult, GTYPE_SAVE_MIDMISSION))//mid mission from [esc] menu
-					{
-						sstrcpy(msgbuffer, _("GAME SAVED: "));
-						sstrcat(msgbuffer, sRequestResult);
-						addConsoleMessage(msgbuffer, LEFT_JUSTIFY, NOTIFY_MESSAGE);
-					}
-					else
+					if (!saveGame(sRequestResult, GTYPE_SAVE_MIDMISSION, true))//mid mission from [esc] menu
 					{
 						ASSERT(!"saveGame(sRequestResult, GTYPE_SAVE_MIDMISSION) failed", "Mid Mission: saveGame Failed");
 						sstrcpy(msgbuffer, _("Could not save game!"));
@@ -351,39 +395,10 @@ static GAMECODE renderLoop()
 		}
 	}
 
-	// deal with the mission state
-	switch (loopMissionState)
+	GAMECODE missionReturn = missionStateUpdate();
+	if (missionReturn != GAMECODE_CONTINUE)
 	{
-	case LMS_CLEAROBJECTS:
-		missionDestroyObjects();
-		setScriptPause(true);
-		loopMissionState = LMS_SETUPMISSION;
-		break;
-
-	case LMS_NORMAL:
-		// default
-		break;
-	case LMS_SETUPMISSION:
-		setScriptPause(false);
-		if (!setUpMission(nextMissionType))
-		{
-			return GAMECODE_QUITGAME;
-		}
-		break;
-	case LMS_SAVECONTINUE:
-		// just wait for this to be changed when the new mission starts
-		break;
-	case LMS_NEWLEVEL:
-		//nextMissionType = MISSION_NONE;
-		nextMissionType = LDS_NONE;
-		return GAMECODE_NEWLEVEL;
-		break;
-	case LMS_LOADGAME:
-		return GAMECODE_LOADGAME;
-		break;
-	default:
-		ASSERT(false, "unknown loopMissionState");
-		break;
+		return missionReturn;
 	}
 
 	int clearMode = 0;
@@ -542,6 +557,8 @@ void countUpdate(bool synch)
 
 static void gameStateUpdate()
 {
+	TickProfileScope tickScope(TICK_PHASE_TICK);
+
 	syncDebug("map = \"%s\", pseudorandom 32-bit integer = 0x%08X, allocated = %d %d %d %d %d %d %d %d %d %d, position = %d %d %d %d %d %d %d %d %d %d", game.map, gameRandU32(),
 	          NetPlay.players[0].allocated, NetPlay.players[1].allocated, NetPlay.players[2].allocated, NetPlay.players[3].allocated, NetPlay.players[4].allocated, NetPlay.players[5].allocated, NetPlay.players[6].allocated, NetPlay.players[7].allocated, NetPlay.players[8].allocated, NetPlay.players[9].allocated,
 	          NetPlay.players[0].position, NetPlay.players[1].position, NetPlay.players[2].position, NetPlay.players[3].position, NetPlay.players[4].position, NetPlay.players[5].position, NetPlay.players[6].position, NetPlay.players[7].position, NetPlay.players[8].position, NetPlay.players[9].position
@@ -556,14 +573,20 @@ static void gameStateUpdate()
 	syncDebug("My client version = %s", version_getVersionString());
 	syncDebugSetCrc(crc);
 
-	// Actually send pending droid orders.
-	sendQueuedDroidInfo();
+	{
+		TickProfileScope scope(TICK_PHASE_NETWORK);
 
-	sendPlayerGameTime();
-	NETflush();  // Make sure the game time tick message is really sent over the network.
+		// Actually send pending droid orders.
+		sendQueuedDroidInfo();
+
+		sendPlayerGameTime();
+		NETflush();  // Make sure the game time tick message is really sent over the network.
+	}
 
 	if (!paused && !scriptPaused())
 	{
+		TickProfileScope scope(TICK_PHASE_SCRIPTS);
+
 		/* Update the event system */
 		if (!bInTutorial)
 		{
@@ -576,88 +599,163 @@ static void gameStateUpdate()
 		updateScripts();
 	}
 
-	// Update abandoned structures
-	handleAbandonedStructures();
+	{
+		TickProfileScope scope(TICK_PHASE_ABANDONED);
+
+		// Update abandoned structures
+		handleAbandonedStructures();
+	}
+
+	{
+		TickProfileScope scope(TICK_PHASE_GRID);
+
+		// Update the visibility change stuff
+		visUpdateLevel();
 
-	// Update the visibility change stuff
-	visUpdateLevel();
+		// Put all droids/structures/features into the grid.
+		gridReset();
+	}
 
-	// Put all droids/structures/features into the grid.
-	gridReset();
+	{
+		TickProfileScope scope(TICK_PHASE_VISIBILITY);
 
-	// Check which objects are visible.
-	processVisibility();
+		// Check which objects are visible.
+		processVisibility();
+	}
 
-	// Update the map.
-	mapUpdate();
+	{
+		TickProfileScope scope(TICK_PHASE_MAP);
 
-	//update the findpath system
-	fpathUpdate();
+		// Update the map.
+		mapUpdate();
+	}
 
-	// update the command droids
-	cmdDroidUpdate();
+	{
+		TickProfileScope scope(TICK_PHASE_PATHFINDING);
+
+		//update the findpath system
+		fpathUpdate();
+	}
 
-	fireWaitingCallbacks(); //Now is the good time to fire waiting callbacks (since interpreter is off now)
+	{
+		TickProfileScope scope(TICK_PHASE_COMMANDERS);
+
+		// update the command droids
+		cmdDroidUpdate();
+	}
+
+	{
+		TickProfileScope scope(TICK_PHASE_CALLBACKS);
+
+		fireWaitingCallbacks(); //Now is the good time to fire waiting callbacks (since interpreter is off now)
+	}
 
 	for (unsigned i = 0; i < MAX_PLAYERS; i++)
 	{
-		//update the current power available for a player
-		updatePlayerPower(i);
+		{
+			TickProfileScope scope(TICK_PHASE_POWER, i);
+
+			//update the current power available for a player
+			updatePlayerPower(i);
+		}
 
 		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
+			TickProfileScope scope(TICK_PHASE_DROIDS, i);
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+				++scope.count;
+			}
 		}
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
+			TickProfileScope scope(TICK_PHASE_MISSION_DROIDS, i);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+				++scope.count;
+			}
 		}
 
 		// FIXME: These for-loops are code duplicationo
 		STRUCTURE *psNBuilding;
-		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, false);
+			TickProfileScope scope(TICK_PHASE_STRUCTURES, i);
+			for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, false);
+				++scope.count;
+			}
 		}
-		for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, true); // update for mission
+			TickProfileScope scope(TICK_PHASE_MISSION_STRUCTURES, i);
+			for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, true); // update for mission
+				++scope.count;
+			}
 		}
 	}
 
-	missionTimerUpdate();
+	{
+		TickProfileScope scope(TICK_PHASE_MISSION_TIMER);
+
+		missionTimerUpdate();
+	}
+
+	{
+		TickProfileScope scope(TICK_PHASE_PROJECTILES);
 
-	proj_UpdateAll();
+		proj_UpdateAll();
+	}
+
+	{
+		TickProfileScope scope(TICK_PHASE_FEATURES);
+
+		FEATURE *psNFeat;
+		for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
+		{
+			psNFeat = psCFeat->psNext;
+			featureUpdate(psCFeat);
+			++scope.count;
+		}
+	}
 
-	FEATURE *psNFeat;
-	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
 	{
-		psNFeat = psCFeat->psNext;
-		featureUpdate(psCFeat);
+		TickProfileScope scope(TICK_PHASE_UI);
+
+		// Clean up dead droid pointers in UI.
+		hciUpdate();
 	}
 
-	// Clean up dead droid pointers in UI.
-	hciUpdate();
+	{
+		TickProfileScope scope(TICK_PHASE_OBJMEM);
 
-	// Free dead droid memory.
-	objmemUpdate();
+		// Free dead droid memory.
+		objmemUpdate();
+	}
+
+	droidHotChanged();
 
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
 
-	// Must be at the beginning or end of each tick, since countUpdate is also called randomly (unsynchronised) between ticks.
-	countUpdate(true);
+	{
+		TickProfileScope scope(TICK_PHASE_COUNTS);
+
+		// Must be at the beginning or end of each tick, since countUpdate is also called randomly (unsynchronised) between ticks.
+		countUpdate(true);
+	}
 
 	static int i = 0;
 	if (i++ % 10 == 0) // trigger every second
@@ -683,6 +781,8 @@ GAMECODE gameLoop()
 		// Receive NET_BLAH messages.
 		// Receive GAME_BLAH messages, and if it's time, process exactly as many GAME_BLAH messages as required to be able to tick the gameTime.
 		recvMessage();
+		replayCheckEnded();
+		saveGameUpdate();
 
 		// Update gameTime and graphicsTime, and corresponding deltas. Note that gameTime and graphicsTime pause, if we aren't getting our GAME_GAME_TIME messages.
 		gameTimeUpdate(renderBudget > 0 || previousUpdateWasRender);
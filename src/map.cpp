@@ -1971,6 +1971,7 @@ void mapInit()
 			threatUpdate(player);
 			dangerFloodFill(player);
 			auxMapRestore(player, AUX_DANGERMAP, AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT);
+			fpathDangerChanged(player);
 		}
 		lastDangerPlayer = 0;
 		dangerSemaphore = wzSemaphoreCreate(0);
@@ -2008,6 +2009,7 @@ void mapUpdate()
 		wzSemaphoreWait(dangerDoneSemaphore);
 
 		auxMapRestore(lastDangerPlayer, AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT | AUXBITS_DANGER);
+		fpathDangerChanged(lastDangerPlayer);
 		lastDangerPlayer = (lastDangerPlayer + 1) % game.maxPlayers;
 		auxMapStore(lastDangerPlayer, AUX_DANGERMAP);
 		threatUpdate(lastDangerPlayer);
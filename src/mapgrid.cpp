@@ -21,20 +21,54 @@
  * mapgrid.cpp
  *
  * Functions for storing objects in a quad-tree like object over the map.
- * The objects are stored in the quad-tree.
+ *
+ * Structures and features hardly ever change, so are stored in a quad-tree which is only rebuilt when they do.
+ * Droids move all the time, so are stored in a coarse grid of cells, and only moved to another cell when they
+ * enter it. Query results are in the same order as if all objects were sorted into a single quad-tree.
  *
  */
+#include <algorithm>
+
 #include "lib/framework/types.h"
+#include "lib/framework/math_ext.h"
 #include "objects.h"
 #include "map.h"
 
 #include "mapgrid.h"
 #include "pointtree.h"
+#include "droidhot.h"
+
+
+#define GRID_CELL_SHIFT (TILE_SHIFT + 2)  ///< Droid cells are 4x4 tiles.
+
+/// A structure or feature in gridPointTree.
+struct GridStatic
+{
+	BASE_OBJECT *psObj;
+	uint64_t key;           ///< PointTree::key() of the position.
+	uint32_t rank;          ///< Player's list and position in the list, to sort objects in the same place.
+};
 
+/// A droid in the droid grid, as of the last gridReset().
+struct GridDroid
+{
+	BASE_OBJECT *psObj;     ///< nullptr if the slot is unused.
+	int32_t x, y;           ///< Position of the droid.
+	uint64_t key;           ///< PointTree::key() of the position.
+	uint32_t rank;          ///< Player's list and position in the list, to sort droids in the same place.
+	unsigned cell;          ///< Index in gridCells.
+	unsigned stamp;         ///< Value of gridStamp when last seen in the droid lists.
+};
 
-static PointTree *gridPointTree = nullptr;  // A quad-tree-like object.
+static PointTree *gridPointTree = nullptr;  // A quad-tree-like object, containing structures and features.
+static std::vector<GridStatic> gridStatic;    // The objects in gridPointTree, in the order they were inserted. Indexed by BASE_OBJECT::gridSlot.
 static PointTree::Filter *gridFiltersUnseen;
-static PointTree::Filter *gridFiltersDroidsByPlayer;
+static unsigned *gridFiltersUnseenStamp;       // Value of gridStamp when the filter was last reset. Filters are reset when first used in a tick.
+static std::vector<GridDroid> gridDroids;      // Indexed by BASE_OBJECT::gridSlot.
+static std::vector<unsigned> gridFreeDroids;   // Unused slots in gridDroids.
+static std::vector<std::vector<unsigned>> gridCells;  // Slots of the droids in each cell.
+static int gridCellsX = 0, gridCellsY = 0;
+static unsigned gridStamp = 0;                 // Incremented each gridReset().
 
 // initialise the grid system
 bool gridInitialise()
@@ -42,27 +76,125 @@ bool gridInitialise()
 	ASSERT(gridPointTree == nullptr, "gridInitialise already called, without calling gridShutDown.");
 	gridPointTree = new PointTree;
 	gridFiltersUnseen = new PointTree::Filter[MAX_PLAYERS];
-	gridFiltersDroidsByPlayer = new PointTree::Filter[MAX_PLAYERS];
+	gridFiltersUnseenStamp = new unsigned[MAX_PLAYERS]();
 
 	return true;  // Yay, nothing failed!
 }
 
+// Objects in the same place are sorted by the list they are in, and their position in the list.
+static uint32_t gridRank(unsigned player, unsigned type, uint32_t index)
+{
+	return (player * 3 + type) << 24 | index;
+}
+
+static unsigned gridCellIndex(int32_t x, int32_t y)
+{
+	int cellX = clip(x >> GRID_CELL_SHIFT, 0, gridCellsX - 1);
+	int cellY = clip(y >> GRID_CELL_SHIFT, 0, gridCellsY - 1);
+	return cellX + cellY * gridCellsX;
+}
+
+static void gridRemoveDroid(unsigned slot)
+{
+	std::vector<unsigned> &cell = gridCells[gridDroids[slot].cell];
+	auto i = std::find(cell.begin(), cell.end(), slot);
+	*i = cell.back();
+	cell.pop_back();
+	gridDroids[slot].psObj = nullptr;
+	gridFreeDroids.push_back(slot);
+}
+
+// Move the droid to its current cell, adding it if it's not in the grid.
+static void gridUpdateDroid(BASE_OBJECT *psObj, Position pos, uint32_t rank)
+{
+	unsigned cell = gridCellIndex(pos.x, pos.y);
+	unsigned slot = psObj->gridSlot;
+	if (slot >= gridDroids.size() || gridDroids[slot].psObj != psObj)
+	{
+		// New droid.
+		if (gridFreeDroids.empty())
+		{
+			slot = gridDroids.size();
+			gridDroids.emplace_back();
+		}
+		else
+		{
+			slot = gridFreeDroids.back();
+			gridFreeDroids.pop_back();
+		}
+		psObj->gridSlot = slot;
+		gridDroids[slot].psObj = psObj;
+		gridDroids[slot].cell = cell;
+		gridCells[cell].push_back(slot);
+	}
+	else if (gridDroids[slot].cell != cell)
+	{
+		// Entered a new cell.
+		std::vector<unsigned> &oldCell = gridCells[gridDroids[slot].cell];
+		*std::find(oldCell.begin(), oldCell.end(), slot) = oldCell.back();
+		oldCell.pop_back();
+		gridDroids[slot].cell = cell;
+		gridCells[cell].push_back(slot);
+	}
+	GridDroid &droid = gridDroids[slot];
+	droid.x = pos.x;
+	droid.y = pos.y;
+	droid.key = PointTree::key(pos.x, pos.y);
+	droid.rank = rank;
+	droid.stamp = gridStamp;
+}
+
 // reset the grid system
 void gridReset()
 {
-	gridPointTree->clear();
+	++gridStamp;
+
+	int cellsX = (world_coord(mapWidth) >> GRID_CELL_SHIFT) + 1;
+	int cellsY = (world_coord(mapHeight) >> GRID_CELL_SHIFT) + 1;
+	if (cellsX != gridCellsX || cellsY != gridCellsY)
+	{
+		// New map, start again.
+		gridDroids.clear();
+		gridFreeDroids.clear();
+		gridCells.clear();
+		gridCells.resize(cellsX * cellsY);
+		gridCellsX = cellsX;
+		gridCellsY = cellsY;
+	}
+
+	// Put all existing droids into the grid. Going through the slots instead of the lists doesn't wait for each droid
+	// to load before finding the next, and the order doesn't matter, since the rank says where each was in its list.
+	droidHotChanged();
+	droidHotUpdate();
+	unsigned numDroids = 0;
+	for (unsigned slot = 0; slot < droidHot.size(); ++slot)
+	{
+		if (droidHot.listed[slot] && !droidHot.died[slot])
+		{
+			DROID *psDroid = droidHot.droid[slot];
+			gridUpdateDroid(psDroid, droidHot.pos[slot], gridRank(droidHot.player[slot], 0, droidHot.listIndex[slot]));
+			++numDroids;
+			for (unsigned char &viewer : psDroid->seenThisTick)
+			{
+				viewer = 0;
+			}
+		}
+	}
 
-	// Put all existing objects into the point tree.
+	// Check whether any structures or features have changed.
+	size_t numStatic = 0;
+	bool staticChanged = false;
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
-		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
-		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
+		BASE_OBJECT *start[2] = {(BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+		for (BASE_OBJECT *list : start)
 		{
-			for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
+			for (BASE_OBJECT *psObj = list; psObj != nullptr; psObj = psObj->psNext)
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
+					staticChanged = staticChanged || numStatic >= gridStatic.size() || gridStatic[numStatic].psObj != psObj || gridStatic[numStatic].key != PointTree::key(psObj->pos.x, psObj->pos.y);
+					++numStatic;
 					for (unsigned char &viewer : psObj->seenThisTick)
 					{
 						viewer = 0;
@@ -71,13 +203,45 @@ void gridReset()
 			}
 		}
 	}
+	staticChanged = staticChanged || numStatic != gridStatic.size();
 
-	gridPointTree->sort();
+	if (numDroids != gridDroids.size() - gridFreeDroids.size())
+	{
+		// Some droids have died or left the lists, remove them without looking at them, since they may have been freed.
+		for (unsigned slot = 0; slot < gridDroids.size(); ++slot)
+		{
+			if (gridDroids[slot].psObj != nullptr && gridDroids[slot].stamp != gridStamp)
+			{
+				gridRemoveDroid(slot);
+			}
+		}
+	}
 
-	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	if (staticChanged)
 	{
-		gridFiltersUnseen[player].reset(*gridPointTree);
-		gridFiltersDroidsByPlayer[player].reset(*gridPointTree);
+		gridStatic.clear();
+		for (unsigned player = 0; player < MAX_PLAYERS; player++)
+		{
+			BASE_OBJECT *start[3] = {nullptr, (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+			for (unsigned type = 1; type != sizeof(start) / sizeof(*start); ++type)
+			{
+				uint32_t index = 0;
+				for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext, ++index)
+				{
+					if (!psObj->died)
+					{
+						psObj->gridSlot = gridStatic.size();
+						gridStatic.push_back({psObj, PointTree::key(psObj->pos.x, psObj->pos.y), gridRank(player, type, index)});
+					}
+				}
+			}
+		}
+		gridPointTree->clear();
+		for (GridStatic const &object : gridStatic)
+		{
+			gridPointTree->insert(object.psObj, object.psObj->pos.x, object.psObj->pos.y);
+		}
+		gridPointTree->sort();
 	}
 }
 
@@ -88,8 +252,14 @@ void gridShutDown()
 	gridPointTree = nullptr;
 	delete[] gridFiltersUnseen;
 	gridFiltersUnseen = nullptr;
-	delete[] gridFiltersDroidsByPlayer;
-	gridFiltersDroidsByPlayer = nullptr;
+	delete[] gridFiltersUnseenStamp;
+	gridFiltersUnseenStamp = nullptr;
+	gridStatic.clear();
+	gridDroids.clear();
+	gridFreeDroids.clear();
+	gridCells.clear();
+	gridCellsX = 0;
+	gridCellsY = 0;
 }
 
 static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
@@ -97,81 +267,142 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 	return (uint32_t)(x * x + y * y) <= radius * radius;
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
-template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+// Whether a comes before b in the query results. Only valid for objects in the grid.
+static bool gridLess(BASE_OBJECT const *a, BASE_OBJECT const *b)
 {
-	if (filter == nullptr)
+	uint64_t keyA = a->type == OBJ_DROID ? gridDroids[a->gridSlot].key : gridStatic[a->gridSlot].key;
+	uint64_t keyB = b->type == OBJ_DROID ? gridDroids[b->gridSlot].key : gridStatic[b->gridSlot].key;
+	if (keyA != keyB)
 	{
-		gridPointTree->query(x, y, radius);
+		return keyA < keyB;
 	}
-	else
+	uint32_t rankA = a->type == OBJ_DROID ? gridDroids[a->gridSlot].rank : gridStatic[a->gridSlot].rank;
+	uint32_t rankB = b->type == OBJ_DROID ? gridDroids[b->gridSlot].rank : gridStatic[b->gridSlot].rank;
+	return rankA < rankB;
+}
+
+// Add the droids in the rectangle which pass accept() to gridList, and merge them with the structures and features already there.
+template<class Accept>
+static void gridQueryDroids(GridList &gridList, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, Accept const &accept)
+{
+	size_t numStatic = gridList.size();
+	if (gridCells.empty())
 	{
-		gridPointTree->query(*filter, x, y, radius);
+		return;
 	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
+	int cellMinX = clip(minX >> GRID_CELL_SHIFT, 0, gridCellsX - 1);
+	int cellMinY = clip(minY >> GRID_CELL_SHIFT, 0, gridCellsY - 1);
+	int cellMaxX = clip(maxX >> GRID_CELL_SHIFT, 0, gridCellsX - 1);
+	int cellMaxY = clip(maxY >> GRID_CELL_SHIFT, 0, gridCellsY - 1);
+	for (int cellY = cellMinY; cellY <= cellMaxY; ++cellY)
 	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
-		if (!condition.test(obj))  // Check if we should skip this object.
+		for (int cellX = cellMinX; cellX <= cellMaxX; ++cellX)
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
-		}
-		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
-		{
-			*w = *i;
-			++w;
+			for (unsigned slot : gridCells[cellX + cellY * gridCellsX])
+			{
+				GridDroid const &droid = gridDroids[slot];
+				if (droid.x >= minX && droid.x <= maxX && droid.y >= minY && droid.y <= maxY && accept(droid.psObj))
+				{
+					gridList.push_back(droid.psObj);
+				}
+			}
 		}
 	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
-	/*
-	// In case you are curious.
-	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
-	*/
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+	size_t numDroids = gridList.size() - numStatic;
+	std::sort(gridList.begin() + numStatic, gridList.end(), gridLess);
+	if (numStatic == 0 || numDroids == 0)
+	{
+		return;
+	}
+
+	// Move the droids out of the way, and merge from the back, to avoid needing another list.
+	gridList.resize(numStatic + 2 * numDroids);
+	std::copy(gridList.begin() + numStatic, gridList.begin() + numStatic + numDroids, gridList.begin() + numStatic + numDroids);
+	size_t s = numStatic, d = numStatic + 2 * numDroids, w = numStatic + numDroids;
+	while (d > numStatic + numDroids)
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		if (s > 0 && gridLess(gridList[d - 1], gridList[s - 1]))
+		{
+			gridList[--w] = gridList[--s];
+		}
+		else
+		{
+			gridList[--w] = gridList[--d];
+		}
 	}
-	return gridList;
+	gridList.resize(numStatic + numDroids);
 }
 
+// Find the objects within radius that pass the condition.
+// Structures and features failing the condition are removed from the filter, so they aren't considered again until the next gridReset().
 template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
+static void gridQueryFiltered(GridList &gridList, int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
 {
-	gridPointTree->query(x, y, x2, y2);
-
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+	gridList.clear();
+	auto accept = [&](BASE_OBJECT *obj) {
+		// Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
+		return condition.test(obj) && isInRadius(obj->pos.x - x, obj->pos.y - y, radius);
+	};
+	if (condition.testStatic)
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		if (filter == nullptr)
+		{
+			gridPointTree->visit(x, y, radius, [&](void *pointData) {
+				BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(pointData);
+				if (accept(obj))
+				{
+					gridList.push_back(obj);
+				}
+			});
+		}
+		else
+		{
+			gridPointTree->visit(*filter, x, y, radius, [&](void *pointData, unsigned index) {
+				BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(pointData);
+				if (!condition.test(obj))  // Check if we should skip this object.
+				{
+					filter->erase(index);  // Stop the object from appearing in future searches.
+				}
+				else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))
+				{
+					gridList.push_back(obj);
+				}
+			});
+		}
 	}
-	return gridList;
+	gridQueryDroids(gridList, x - radius, y - radius, x + radius, y + radius, accept);
+	/*
+	// In case you are curious.
+	debug(LOG_WARNING, "gridQueryFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridList.size());
+	*/
 }
 
 struct ConditionTrue
 {
+	static const bool testStatic = true;  ///< Whether structures and features can pass the condition.
 	bool test(BASE_OBJECT *) const
 	{
 		return true;
 	}
 };
 
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+void gridQuery(GridList &gridList, int32_t x, int32_t y, uint32_t radius)
 {
-	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
+	gridQueryFiltered(gridList, x, y, radius, nullptr, ConditionTrue());
 }
 
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+void gridQueryArea(GridList &gridList, int32_t x, int32_t y, int32_t x2, int32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	gridList.clear();
+	gridPointTree->visitArea(x, y, x2, y2, [&gridList](void *pointData) {
+		gridList.push_back(static_cast<BASE_OBJECT *>(pointData));
+	});
+	gridQueryDroids(gridList, x, y, x2, y2, [](BASE_OBJECT *) { return true; });
 }
 
 struct ConditionDroidsByPlayer
 {
+	static const bool testStatic = false;
 	ConditionDroidsByPlayer(int32_t player_) : player(player_) {}
 	bool test(BASE_OBJECT *obj) const
 	{
@@ -180,13 +411,14 @@ struct ConditionDroidsByPlayer
 	int player;
 };
 
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+void gridQueryDroidsByPlayer(GridList &gridList, int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
+	gridQueryFiltered(gridList, x, y, radius, nullptr, ConditionDroidsByPlayer(player));
 }
 
 struct ConditionUnseen
 {
+	static const bool testStatic = true;
 	ConditionUnseen(int32_t player_) : player(player_) {}
 	bool test(BASE_OBJECT *obj) const
 	{
@@ -195,15 +427,12 @@ struct ConditionUnseen
 	int player;
 };
 
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player)
+void gridQueryUnseen(GridList &gridList, int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
-}
-
-BASE_OBJECT **gridIterateDup()
-{
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	if (gridFiltersUnseenStamp[player] != gridStamp)
+	{
+		gridFiltersUnseen[player].reset(*gridPointTree);
+		gridFiltersUnseenStamp[player] = gridStamp;
+	}
+	gridQueryFiltered(gridList, x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
 }
@@ -37,17 +37,22 @@ void gridShutDown();
 // Resets seenThisTick[] to false.
 void gridReset();
 
-/// Find all objects within radius.
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
+// The query functions below write the objects found to gridList, replacing its contents. Since the caller owns gridList,
+// they may be called from several threads at once, but not at the same time as gridReset.
 
 /// Find all objects within radius.
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
+void gridQuery(GridList &gridList, int32_t x, int32_t y, uint32_t radius);
+
+/// Find all objects within the rectangle from (x, y) to (x2, y2).
+void gridQueryArea(GridList &gridList, int32_t x, int32_t y, int32_t x2, int32_t y2);
 
 /// Find all objects within radius where object->type == OBJ_DROID && object->player == player.
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player);
+/// Not thread safe for the same player, since it updates a per-player filter.
+void gridQueryDroidsByPlayer(GridList &gridList, int32_t x, int32_t y, uint32_t radius, int player);
 
 // Used for visibility.
 /// Find all objects within radius where object->seenThisTick[player] != 255.
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
+/// Not thread safe for the same player, since it updates a per-player filter.
+void gridQueryUnseen(GridList &gridList, int32_t x, int32_t y, uint32_t radius, int player);
 
 #endif // __INCLUDED_SRC_MAPGRID_H__
@@ -2428,12 +2428,7 @@ void intRunMissionResult()
 
 				if (!bRequestLoad)
 				{
-					char msg[256] = {'\0'};
-
-					saveGame(sRequestResult, GTYPE_SAVE_START);
-					sstrcpy(msg, _("GAME SAVED :"));
-					sstrcat(msg, sRequestResult);
-					addConsoleMessage(msg, LEFT_JUSTIFY, NOTIFY_MESSAGE);
+					saveGame(sRequestResult, GTYPE_SAVE_START, true);
 				}
 			}
 		}
@@ -44,136 +44,12 @@
 #include "mapgrid.h"
 #include "multirecv.h"
 #include "transporter.h"
+#include "droidinfo.h"
 
 #include <vector>
 #include <algorithm>
 
 
-enum SubType
-{
-	ObjOrder, LocOrder, SecondaryOrder
-};
-
-struct QueuedDroidInfo
-{
-	/// Sorts by order, then finally by droid id, to group multiple droids with the same order.
-	bool operator <(QueuedDroidInfo const &z) const
-	{
-		int orComp = orderCompare(z);
-		if (orComp != 0)
-		{
-			return orComp < 0;
-		}
-		return droidId < z.droidId;
-	}
-	/// Returns 0 if order is the same, non-zero otherwise.
-	int orderCompare(QueuedDroidInfo const &z) const
-	{
-		if (player != z.player)
-		{
-			return player < z.player ? -1 : 1;
-		}
-		if (subType != z.subType)
-		{
-			return subType < z.subType ? -1 : 1;
-		}
-		switch (subType)
-		{
-		case ObjOrder:
-		case LocOrder:
-			if (order != z.order)
-			{
-				return order < z.order ? -1 : 1;
-			}
-			if (subType == ObjOrder)
-			{
-				if (destId != z.destId)
-				{
-					return destId < z.destId ? -1 : 1;
-				}
-				if (destType != z.destType)
-				{
-					return destType < z.destType ? -1 : 1;
-				}
-			}
-			else
-			{
-				if (pos.x != z.pos.x)
-				{
-					return pos.x < z.pos.x ? -1 : 1;
-				}
-				if (pos.y != z.pos.y)
-				{
-					return pos.y < z.pos.y ? -1 : 1;
-				}
-			}
-			if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-			{
-				if (structRef != z.structRef)
-				{
-					return structRef < z.structRef ? -1 : 1;
-				}
-				if (direction != z.direction)
-				{
-					return direction < z.direction ? -1 : 1;
-				}
-			}
-			if (order == DORDER_LINEBUILD)
-			{
-				if (pos2.x != z.pos2.x)
-				{
-					return pos2.x < z.pos2.x ? -1 : 1;
-				}
-				if (pos2.y != z.pos2.y)
-				{
-					return pos2.y < z.pos2.y ? -1 : 1;
-				}
-			}
-			if (order == DORDER_BUILDMODULE)
-			{
-				if (index != z.index)
-				{
-					return index < z.index ? -1 : 1;
-				}
-			}
-			if (add != z.add)
-			{
-				return add < z.add ? -1 : 1;
-			}
-			break;
-		case SecondaryOrder:
-			if (secOrder != z.secOrder)
-			{
-				return secOrder < z.secOrder ? -1 : 1;
-			}
-			if (secState != z.secState)
-			{
-				return secState < z.secState ? -1 : 1;
-			}
-			break;
-		}
-		return 0;
-	}
-
-	uint8_t     player;
-	uint32_t    droidId;
-	SubType     subType;
-	// subType == ObjOrder || subType == LocOrder
-	DROID_ORDER order;
-	uint32_t    destId;     // if (subType == ObjOrder)
-	OBJECT_TYPE destType;   // if (subType == ObjOrder)
-	Vector2i    pos;        // if (subType == LocOrder)
-	uint32_t    y;          // if (subType == LocOrder)
-	uint32_t    structRef;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-	uint16_t    direction;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-	uint32_t    index;      // if (order == DORDER_BUILDMODULE)
-	Vector2i    pos2;       // if (order == DORDER_LINEBUILD)
-	bool        add;
-	// subType == SecondaryOrder
-	SECONDARY_ORDER secOrder;
-	SECONDARY_STATE secState;
-};
-
 static std::vector<QueuedDroidInfo> queuedOrders;
 
 
@@ -461,47 +337,6 @@ bool recvDroid(NETQUEUE queue)
 }
 
 
-/// Does not read/write info->droidId!
-static void NETQueuedDroidInfo(QueuedDroidInfo *info)
-{
-	NETuint8_t(&info->player);
-	NETenum(&info->subType);
-	switch (info->subType)
-	{
-	case ObjOrder:
-	case LocOrder:
-		NETenum(&info->order);
-		if (info->subType == ObjOrder)
-		{
-			NETuint32_t(&info->destId);
-			NETenum(&info->destType);
-		}
-		else
-		{
-			NETauto(&info->pos);
-		}
-		if (info->order == DORDER_BUILD || info->order == DORDER_LINEBUILD)
-		{
-			NETuint32_t(&info->structRef);
-			NETuint16_t(&info->direction);
-		}
-		if (info->order == DORDER_LINEBUILD)
-		{
-			NETauto(&info->pos2);
-		}
-		if (info->order == DORDER_BUILDMODULE)
-		{
-			NETauto(&info->index);
-		}
-		NETbool(&info->add);
-		break;
-	case SecondaryOrder:
-		NETenum(&info->secOrder);
-		NETenum(&info->secState);
-		break;
-	}
-}
-
 // Actually send the droid info.
 void sendQueuedDroidInfo()
 {
@@ -527,8 +362,16 @@ void sendQueuedDroidInfo()
 			uint32_t droidId = (eqBegin + n)->droidId;
 
 			// Encode deltas between droid IDs, since the deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
-			uint32_t deltaDroidId = droidId - prevDroidId;
-			NETuint32_t(&deltaDroidId);
+			// The first droid ID is relative to the first droid ID of the previous GAME_DROIDINFO.
+			if (n == 0)
+			{
+				NETdeltaUint32(&droidId, DROIDINFO_FIRST_DROID_ID);
+			}
+			else
+			{
+				uint32_t deltaDroidId = droidId - prevDroidId;
+				NETuint32_t(&deltaDroidId);
+			}
 
 			prevDroidId = droidId;
 		}
@@ -649,9 +492,16 @@ bool recvDroidInfo(NETQUEUE queue)
 		for (unsigned n = 0; n < num; ++n)
 		{
 			// Get the next droid ID which is being given this order.
-			uint32_t deltaDroidId = 0;
-			NETuint32_t(&deltaDroidId);
-			info.droidId += deltaDroidId;
+			if (n == 0)
+			{
+				NETdeltaUint32(&info.droidId, DROIDINFO_FIRST_DROID_ID);
+			}
+			else
+			{
+				uint32_t deltaDroidId = 0;
+				NETuint32_t(&deltaDroidId);
+				info.droidId += deltaDroidId;
+			}
 
 			DROID *psDroid = IdToDroid(info.droidId, info.player);
 			if (!psDroid)
@@ -81,6 +81,7 @@
 #include "modding.h"
 #include "qtscript.h"
 #include "random.h"
+#include "replay.h"
 
 #include "multiplay.h"
 #include "multiint.h"
@@ -2720,6 +2721,7 @@ static void SendFireUp()
 	NETend();
 	printSearchPath();
 	gameSRand(randomSeed);  // Set the seed for the synchronised random number generator. The clients will use the same seed.
+	replaySaveStart(randomSeed);
 }
 
 // host kicks a player from a game.
@@ -3657,6 +3659,7 @@ void frontendMultiMessages()
 				ingame.TimeEveryoneIsInGame = 0;			// reset time
 				resetDataHash();
 				decideWRF();
+				replaySaveStart(randomSeed);
 
 				bMultiPlayer = true;
 				bMultiMessages = true;
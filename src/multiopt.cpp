@@ -40,6 +40,7 @@
 #include "lib/widget/widget.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "hci.h"
 #include "configuration.h"			// lobby cfg.
 #include "clparse.h"
@@ -94,6 +95,7 @@ void sendOptions()
 	NETuint8_t(&game.alliance);
 	NETbool(&game.scavengers);
 	NETbool(&game.isMapMod);
+	NETbool(&game.deltaEncoding);
 
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
@@ -160,6 +162,7 @@ void recvOptions(NETQUEUE queue)
 	NETuint8_t(&game.alliance);
 	NETbool(&game.scavengers);
 	NETbool(&game.isMapMod);
+	NETbool(&game.deltaEncoding);
 
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
@@ -490,11 +493,16 @@ bool multiGameShutdown()
 	debug(LOG_NET, "%s is shutting down.", getPlayerName(selectedPlayer));
 
 	sendLeavingMsg();							// say goodbye
-	updateMultiStatsGames();					// update games played.
+	if (!NETisReplay())
+	{
+		updateMultiStatsGames();					// update games played.
 
-	st = getMultiStats(selectedPlayer);	// save stats
+		st = getMultiStats(selectedPlayer);	// save stats
 
-	saveMultiStats(getPlayerName(selectedPlayer), getPlayerName(selectedPlayer), &st);
+		saveMultiStats(getPlayerName(selectedPlayer), getPlayerName(selectedPlayer), &st);
+	}
+	NETreplaySaveStop();
+	NETreplayLoadStop();
 
 	// if we terminate the socket too quickly, then, it is possible not to get the leave message
 	time = wzGetTicks();
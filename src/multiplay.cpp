@@ -63,6 +63,7 @@
 #include "scriptfuncs.h"
 #include "template.h"
 #include "lib/netplay/netplay.h"								// the netplay library.
+#include "lib/netplay/netreplay.h"
 #include "modding.h"
 #include "multiplay.h"								// warzone net stuff.
 #include "multijoin.h"								// player management stuff.
@@ -532,6 +533,10 @@ int whosResponsible(int player)
 //returns true if selected player is responsible for 'player'
 bool myResponsibility(int player)
 {
+	if (NETisReplay())
+	{
+		return false;  // Everything any player did comes from the replay.
+	}
 	return (whosResponsible(player) == selectedPlayer || whosResponsible(player) == realSelectedPlayer);
 }
 
@@ -57,6 +57,7 @@ struct MULTIPLAYERGAME
 	uint8_t		skDiff[MAX_PLAYERS];		// skirmish game difficulty settings. 0x0=OFF 0xff=HUMAN
 	bool		mapHasScavengers;
 	bool		isMapMod;					// if a map has mods
+	bool		deltaEncoding;				///< Whether game messages are delta-encoded, see NETsetDeltaEncoding(). Chosen by the host.
 };
 
 struct MULTISTRUCTLIMITS
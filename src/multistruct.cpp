@@ -53,6 +53,7 @@
 #include "qtscript.h"
 #include "keymap.h"
 #include "combat.h"
+#include "objmem.h"
 
 // ////////////////////////////////////////////////////////////////////////////
 // structures
@@ -128,7 +129,7 @@ bool recvBuildFinished(NETQUEUE queue)
 		if (asStructureStats[typeindex].type == psStruct->pStructureType->type)
 		{
 			// Correct type, correct location, just rename the id's to sync it.. (urgh)
-			psStruct->id = structId;
+			objmemChangeId(psStruct, structId);
 			psStruct->status = SS_BUILT;
 			buildingComplete(psStruct);
 			debug(LOG_SYNC, "Created modified building %u for player %u", psStruct->id, player);
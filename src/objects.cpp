@@ -27,6 +27,7 @@
 
 #include "lib/framework/frame.h"
 #include "objects.h"
+#include "objpool.h"
 
 
 /* Initialise the object system */
@@ -45,6 +46,7 @@ bool objInitialise()
 bool objShutdown()
 {
 	objmemShutdown();
+	objectPoolsTrim();
 
 	return true;
 }
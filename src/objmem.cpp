@@ -45,6 +45,10 @@
 #include "combat.h"
 #include "visibility.h"
 #include "qtscript.h"
+#include "droidhot.h"
+
+#include <algorithm>
+#include <unordered_map>
 
 // the initial value for the object ID
 #define OBJ_ID_INIT 20000
@@ -69,6 +73,22 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj = nullptr;
 
+/* Objects in the droid, structure and feature lists, by id, so that getBaseObjFromId doesn't need to search
+ * every list. Droids in transporters are only added when first looked up. An object moved to another player's
+ * list is still indexed, which is why getBaseObjFromData still checks the type and player. */
+static std::unordered_map<uint32_t, BASE_OBJECT *> objIdIndex;
+
+/* The structures in apsStructLists[player], by type, in list order. The index is updated by addStructure, killStruct
+ * and removeStructureFromList. Anything else changing the list, such as the mission list swaps, changes the head of
+ * the list, so the index is rebuilt when the head is not the one it was built for. */
+struct STRUCT_TYPE_INDEX
+{
+	bool valid = false;
+	STRUCTURE *head = nullptr;                                 ///< apsStructLists[player] when last updated.
+	std::vector<STRUCTURE *> structs[NUM_DIFF_BUILDINGS];
+};
+static STRUCT_TYPE_INDEX structTypeIndex[MAX_PLAYERS];
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck();
@@ -82,12 +102,141 @@ bool objmemInitialise()
 	unsynchObjID = OBJ_ID_INIT / 2; // /2 so that object IDs start around OBJ_ID_INIT*8, in case that's important when loading maps.
 	synchObjID   = OBJ_ID_INIT * 4; // *4 so that object IDs start around OBJ_ID_INIT*8, in case that's important when loading maps.
 
+	objIdIndex.clear();
+	structTypeIndexReset();
+
 	return true;
 }
 
 /* Release the object heaps */
 void objmemShutdown()
 {
+	objIdIndex.clear();
+	structTypeIndexReset();
+}
+
+void objmemIndexAdd(BASE_OBJECT *psObj)
+{
+	objIdIndex[psObj->id] = psObj;
+}
+
+void objmemIndexRemove(BASE_OBJECT *psObj)
+{
+	auto i = objIdIndex.find(psObj->id);
+	if (i != objIdIndex.end() && i->second == psObj)
+	{
+		objIdIndex.erase(i);
+	}
+}
+
+void objmemChangeId(BASE_OBJECT *psObj, uint32_t id)
+{
+	auto i = objIdIndex.find(psObj->id);
+	bool indexed = i != objIdIndex.end() && i->second == psObj;
+	if (indexed)
+	{
+		objIdIndex.erase(i);
+	}
+	psObj->id = id;
+	if (indexed)
+	{
+		objIdIndex[id] = psObj;
+	}
+}
+
+/// Looks up the id in the index, forgetting the entry if it is for an object with another id now.
+static BASE_OBJECT *objmemIndexFind(uint32_t id)
+{
+	auto i = objIdIndex.find(id);
+	if (i == objIdIndex.end())
+	{
+		return nullptr;
+	}
+	if (i->second->id != id)
+	{
+		objIdIndex.erase(i);
+		return nullptr;
+	}
+	return i->second;
+}
+
+void structTypeIndexReset()
+{
+	for (STRUCT_TYPE_INDEX &index : structTypeIndex)
+	{
+		index.valid = false;
+		index.head = nullptr;
+		for (std::vector<STRUCTURE *> &structs : index.structs)
+		{
+			structs.clear();
+		}
+	}
+}
+
+std::vector<STRUCTURE *> const &structuresOfType(unsigned player, STRUCTURE_TYPE type)
+{
+	static const std::vector<STRUCTURE *> none;
+	ASSERT_OR_RETURN(none, player < MAX_PLAYERS && type < NUM_DIFF_BUILDINGS, "Bad player %u or type %d", player, (int)type);
+
+	STRUCT_TYPE_INDEX &index = structTypeIndex[player];
+	if (!index.valid || index.head != apsStructLists[player])
+	{
+		for (std::vector<STRUCTURE *> &structs : index.structs)
+		{
+			structs.clear();
+		}
+		for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != nullptr; psStruct = psStruct->psNext)
+		{
+			index.structs[psStruct->pStructureType->type].push_back(psStruct);
+		}
+		index.valid = true;
+		index.head = apsStructLists[player];
+	}
+	return index.structs[type];
+}
+
+/// Called after psStruct was prepended to apsStructLists.
+static void structTypeIndexAdd(STRUCTURE *psStruct)
+{
+	STRUCT_TYPE_INDEX &index = structTypeIndex[psStruct->player];
+	if (index.valid && index.head == psStruct->psNext)
+	{
+		std::vector<STRUCTURE *> &structs = index.structs[psStruct->pStructureType->type];
+		structs.insert(structs.begin(), psStruct);
+		index.head = psStruct;
+	}
+	else
+	{
+		index.valid = false;
+	}
+}
+
+/// Called before psStruct is removed from pList.
+static void structTypeIndexRemove(STRUCTURE *psStruct, STRUCTURE *pList[MAX_PLAYERS])
+{
+	STRUCT_TYPE_INDEX &index = structTypeIndex[psStruct->player];
+	if (!index.valid || index.head != apsStructLists[psStruct->player])
+	{
+		index.valid = false;
+		return;
+	}
+	if (pList != apsStructLists)
+	{
+		index.valid = false;  // Could be the same list, if in the middle of swapping lists.
+		return;
+	}
+	std::vector<STRUCTURE *> &structs = index.structs[psStruct->pStructureType->type];
+	auto i = std::find(structs.begin(), structs.end(), psStruct);
+	if (i == structs.end())
+	{
+		index.valid = false;
+		return;
+	}
+	structs.erase(i);
+	if (index.head == psStruct)
+	{
+		index.head = psStruct->psNext;
+	}
 }
 
 // Check that psVictim is not referred to by any other object in the game. We can dump out some extra data in debug builds that help track down sources of dangling pointer errors.
@@ -282,6 +431,8 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
+	objmemIndexRemove(object);
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[object->player] == object)
 	{
@@ -417,6 +568,7 @@ void addDroid(DROID *psDroidToAdd, DROID *pList[MAX_PLAYERS])
 	DROID_GROUP	*psGroup;
 
 	addObjectToList(pList, psDroidToAdd, psDroidToAdd->player);
+	objmemIndexAdd(psDroidToAdd);
 
 	/* Whenever a droid gets added to a list other than the current list
 	 * its died flag is set to NOT_CURRENT_LIST so that anything targetting
@@ -467,6 +619,7 @@ void killDroid(DROID *psDel)
 	}
 
 	destroyObject(apsDroidLists, psDel);
+	droidHotChanged();
 }
 
 /* Remove all droids */
@@ -481,6 +634,8 @@ void removeDroid(DROID *psDroidToRemove, DROID *pList[MAX_PLAYERS])
 	ASSERT_OR_RETURN(, psDroidToRemove->type == OBJ_DROID, "Pointer is not a unit");
 	ASSERT_OR_RETURN(, psDroidToRemove->player < MAX_PLAYERS, "Invalid player for unit");
 	removeObjectFromList(pList, psDroidToRemove, psDroidToRemove->player);
+	objmemIndexRemove(psDroidToRemove);
+	droidHotChanged();
 
 	/* Whenever a droid is removed from the current list its died
 	 * flag is set to NOT_CURRENT_LIST so that anything targetting
@@ -520,6 +675,8 @@ void freeAllLimboDroids()
 void addStructure(STRUCTURE *psStructToAdd)
 {
 	addObjectToList(apsStructLists, psStructToAdd, psStructToAdd->player);
+	objmemIndexAdd(psStructToAdd);
+	structTypeIndexAdd(psStructToAdd);
 	if (psStructToAdd->pStructureType->pSensor
 	    && psStructToAdd->pStructureType->pSensor->location == LOC_TURRET)
 	{
@@ -588,6 +745,7 @@ void killStruct(STRUCTURE *psBuilding)
 		}
 	}
 
+	structTypeIndexRemove(psBuilding, apsStructLists);
 	destroyObject(apsStructLists, psBuilding);
 }
 
@@ -595,6 +753,7 @@ void killStruct(STRUCTURE *psBuilding)
 void freeAllStructs()
 {
 	releaseAllObjectsInList(apsStructLists);
+	structTypeIndexReset();
 }
 
 /*Remove a single Structure from a list*/
@@ -604,7 +763,9 @@ void removeStructureFromList(STRUCTURE *psStructToRemove, STRUCTURE *pList[MAX_P
 	       "removeStructureFromList: pointer is not a structure");
 	ASSERT(psStructToRemove->player < MAX_PLAYERS,
 	       "removeStructureFromList: invalid player for structure");
+	structTypeIndexRemove(psStructToRemove, pList);
 	removeObjectFromList(pList, psStructToRemove, psStructToRemove->player);
+	objmemIndexRemove(psStructToRemove);
 	if (psStructToRemove->pStructureType->pSensor
 	    && psStructToRemove->pStructureType->pSensor->location == LOC_TURRET)
 	{
@@ -622,6 +783,7 @@ void removeStructureFromList(STRUCTURE *psStructToRemove, STRUCTURE *pList[MAX_P
 void addFeature(FEATURE *psFeatureToAdd)
 {
 	addObjectToList(apsFeatureLists, psFeatureToAdd, 0);
+	objmemIndexAdd(psFeatureToAdd);
 	if (psFeatureToAdd->psStats->subType == FEAT_OIL_RESOURCE)
 	{
 		addObjectToFuncList(apsOilList, psFeatureToAdd, 0);
@@ -768,8 +930,8 @@ void checkFactoryFlags()
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+// Find a base object from it's id, by searching all the lists
+static BASE_OBJECT *findObjFromDataSlow(unsigned id, unsigned player, OBJECT_TYPE type)
 {
 	BASE_OBJECT		*psObj;
 	DROID			*psTrans;
@@ -825,13 +987,11 @@ BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
 			psObj = psObj->psNext;
 		}
 	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
-
 	return nullptr;
 }
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromId(UDWORD id)
+// Find a base object from it's id, by searching all the lists
+static BASE_OBJECT *findObjFromIdSlow(UDWORD id)
 {
 	unsigned int i;
 	UDWORD			player;
@@ -912,11 +1072,56 @@ BASE_OBJECT *getBaseObjFromId(UDWORD id)
 			}
 		}
 	}
-	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
-
 	return nullptr;
 }
 
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	BASE_OBJECT *psObj = objmemIndexFind(id);
+	if (psObj == nullptr || psObj->type != type || (type != OBJ_FEATURE && psObj->player != player))
+	{
+		// Not in the index, such as droids loaded straight into a transporter, or moved to another player's list.
+		psObj = findObjFromDataSlow(id, player, type);
+		if (psObj != nullptr)
+		{
+			objmemIndexAdd(psObj);
+		}
+	}
+#ifdef DEBUG
+	else
+	{
+		ASSERT(psObj == findObjFromDataSlow(id, player, type), "Object index out of date for id %u", id);
+	}
+#endif
+	ASSERT(psObj != nullptr, "failed to find id %d for player %d", id, player);
+
+	return psObj;
+}
+
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromId(UDWORD id)
+{
+	BASE_OBJECT *psObj = objmemIndexFind(id);
+	if (psObj == nullptr)
+	{
+		psObj = findObjFromIdSlow(id);
+		if (psObj != nullptr)
+		{
+			objmemIndexAdd(psObj);
+		}
+	}
+#ifdef DEBUG
+	else
+	{
+		ASSERT(psObj == findObjFromIdSlow(id), "Object index out of date for id %u", id);
+	}
+#endif
+	ASSERT(psObj != nullptr, "getBaseObjFromId() failed for id %d", id);
+
+	return psObj;
+}
+
 UDWORD getRepairIdFromFlag(FLAG_POSITION *psFlag)
 {
 	unsigned int i;
@@ -26,6 +26,8 @@
 
 #include "objectdef.h"
 
+#include <vector>
+
 /* The lists of objects allocated */
 extern DROID			*apsDroidLists[MAX_PLAYERS];
 extern STRUCTURE		*apsStructLists[MAX_PLAYERS];
@@ -101,6 +103,20 @@ void removeFlagPosition(FLAG_POSITION *psDel);
 void freeAllFlagPositions();
 void freeAllAssemblyPoints();
 
+/// Add the object to the id index used by getBaseObjFromId. Done by addDroid, addStructure and addFeature.
+void objmemIndexAdd(BASE_OBJECT *psObj);
+/// Remove the object from the id index, if there.
+void objmemIndexRemove(BASE_OBJECT *psObj);
+/// Change the id of an object, keeping the id index up to date. Every change of the id of an object must use this.
+void objmemChangeId(BASE_OBJECT *psObj, uint32_t id);
+
+/// The structures of the given type in apsStructLists[player], in list order. Must not be used while adding or removing
+/// structures of that player. Kept up to date by addStructure, killStruct and removeStructureFromList, and rebuilt when
+/// the list is replaced, such as by the mission list swaps.
+std::vector<STRUCTURE *> const &structuresOfType(unsigned player, STRUCTURE_TYPE type);
+/// Forget the structure type index, for when the structure lists are freed.
+void structTypeIndexReset();
+
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 BASE_OBJECT *getBaseObjFromId(UDWORD id);
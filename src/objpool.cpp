@@ -0,0 +1,170 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Memory pools for droids, structures, features and projectiles, see objpool.h.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "droiddef.h"
+#include "structuredef.h"
+#include "featuredef.h"
+#include "projectiledef.h"
+#include "objpool.h"
+
+#include <cstddef>
+#include <new>
+
+#define OBJECT_POOL_SLAB_SLOTS 256      ///< Number of objects allocated at once.
+
+ObjectPool::ObjectPool(const char *name_, size_t objectSize)
+	: name(name_)
+	, slotSize((objectSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t))
+{}
+
+ObjectPool::~ObjectPool()
+{
+	// Objects still alive at exit are not destroyed, so keep their memory.
+	trim();
+}
+
+void *ObjectPool::alloc(size_t size)
+{
+	if (size > slotSize)
+	{
+		return ::operator new(size);  // Derived type, not pooled.
+	}
+	if (freeList == nullptr)
+	{
+		char *slab = static_cast<char *>(::operator new(slotSize * OBJECT_POOL_SLAB_SLOTS));
+		slabs.push_back(slab);
+		for (int i = OBJECT_POOL_SLAB_SLOTS - 1; i >= 0; --i)
+		{
+			FreeSlot *slot = reinterpret_cast<FreeSlot *>(slab + i * slotSize);
+			slot->next = freeList;
+			freeList = slot;
+		}
+		numFree += OBJECT_POOL_SLAB_SLOTS;
+	}
+	FreeSlot *slot = freeList;
+	freeList = slot->next;
+	--numFree;
+	++numLive;
+	++numAllocations;
+	return slot;
+}
+
+void ObjectPool::free(void *ptr, size_t size)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	if (size > slotSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+#ifdef DEBUG
+	memset(ptr, 0xCD, slotSize);  // Make use after free more obvious.
+#endif
+	FreeSlot *slot = static_cast<FreeSlot *>(ptr);
+	slot->next = freeList;
+	freeList = slot;
+	++numFree;
+	--numLive;
+}
+
+void ObjectPool::trim()
+{
+	if (numLive != 0)
+	{
+		return;
+	}
+	for (char *slab : slabs)
+	{
+		::operator delete(slab);
+	}
+	slabs.clear();
+	freeList = nullptr;
+	numFree = 0;
+}
+
+ObjectPoolStats ObjectPool::stats() const
+{
+	return {name, slotSize, numLive, numFree, slabs.size(), numAllocations};
+}
+
+static ObjectPool droidPool("Droids", sizeof(DROID));
+static ObjectPool structurePool("Structures", sizeof(STRUCTURE));
+static ObjectPool featurePool("Features", sizeof(FEATURE));
+static ObjectPool projectilePool("Projectiles", sizeof(PROJECTILE));
+
+void *DROID::operator new(size_t size)
+{
+	return droidPool.alloc(size);
+}
+
+void DROID::operator delete(void *ptr, size_t size)
+{
+	droidPool.free(ptr, size);
+}
+
+void *STRUCTURE::operator new(size_t size)
+{
+	return structurePool.alloc(size);
+}
+
+void STRUCTURE::operator delete(void *ptr, size_t size)
+{
+	structurePool.free(ptr, size);
+}
+
+void *FEATURE::operator new(size_t size)
+{
+	return featurePool.alloc(size);
+}
+
+void FEATURE::operator delete(void *ptr, size_t size)
+{
+	featurePool.free(ptr, size);
+}
+
+void *PROJECTILE::operator new(size_t size)
+{
+	return projectilePool.alloc(size);
+}
+
+void PROJECTILE::operator delete(void *ptr, size_t size)
+{
+	projectilePool.free(ptr, size);
+}
+
+std::vector<ObjectPoolStats> objectPoolStats()
+{
+	return {droidPool.stats(), structurePool.stats(), featurePool.stats(), projectilePool.stats()};
+}
+
+void objectPoolsTrim()
+{
+	droidPool.trim();
+	structurePool.trim();
+	featurePool.trim();
+	projectilePool.trim();
+}
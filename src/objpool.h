@@ -0,0 +1,87 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Memory pools for droids, structures, features and projectiles.
+ *
+ *  DROID, STRUCTURE, FEATURE and PROJECTILE allocate themselves from a pool of their own type, by overloading operator
+ *  new and delete, so creating and deleting them needs no changes. Each pool allocates slabs of slots, and keeps freed
+ *  slots in a free list for the next object of the type, instead of giving the memory back. Only used from the main
+ *  thread.
+ */
+
+#ifndef __INCLUDED_SRC_OBJPOOL_H__
+#define __INCLUDED_SRC_OBJPOOL_H__
+
+#include "lib/framework/types.h"
+
+#include <vector>
+
+struct ObjectPoolStats
+{
+	const char *name;
+	size_t slotSize;                    ///< Bytes per slot.
+	size_t live;                        ///< Slots in use.
+	size_t free;                        ///< Slots allocated, but not in use.
+	size_t slabs;
+	uint64_t allocations;               ///< Objects allocated since the start.
+};
+
+/** Allocates objects of one size from slabs, and keeps freed slots for reuse
+ *
+ *  Objects of the wrong size are passed on to the global operator new and delete.
+ */
+class ObjectPool
+{
+public:
+	ObjectPool(const char *name, size_t objectSize);
+	~ObjectPool();
+
+	ObjectPool(ObjectPool const &) = delete;
+	ObjectPool &operator =(ObjectPool const &) = delete;
+
+	void *alloc(size_t size);
+	void free(void *ptr, size_t size);
+
+	/// Gives the slabs back, if no objects are left in them.
+	void trim();
+
+	ObjectPoolStats stats() const;
+
+private:
+	struct FreeSlot
+	{
+		FreeSlot *next;
+	};
+
+	const char *name;
+	size_t slotSize;
+	std::vector<char *> slabs;
+	FreeSlot *freeList = nullptr;
+	size_t numLive = 0;
+	size_t numFree = 0;
+	uint64_t numAllocations = 0;
+};
+
+/// The statistics of each pool, for the "pool info" cheat.
+std::vector<ObjectPoolStats> objectPoolStats();
+
+/// Gives back the memory of pools which no longer have any objects, such as after a game.
+void objectPoolsTrim();
+
+#endif // __INCLUDED_SRC_OBJPOOL_H__
@@ -185,7 +185,9 @@ DROID *checkForRepairRange(DROID *psDroid)
 	unsigned bestDistanceSq = radius * radius;
 	DROID *best = nullptr;
 
-	for (BASE_OBJECT *object : gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius))
+	static GridList gridList;  // static to avoid allocations.
+	gridQuery(gridList, psDroid->pos.x, psDroid->pos.y, radius);
+	for (BASE_OBJECT *object : gridList)
 	{
 		unsigned distanceSq = droidSqDist(psDroid, object);  // droidSqDist returns -1 if unreachable, (unsigned)-1 is a big number.
 		if (object == orderStateObj(psDroid, DORDER_GUARD))
@@ -226,7 +228,9 @@ static std::pair<STRUCTURE *, DROID_ACTION> checkForDamagedStruct(DROID *psDroid
 	unsigned bestDistanceSq = radius * radius;
 	std::pair<STRUCTURE *, DROID_ACTION> best = {nullptr, DACTION_NONE};
 
-	for (BASE_OBJECT *object : gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius))
+	static GridList gridList;  // static to avoid allocations.
+	gridQuery(gridList, psDroid->pos.x, psDroid->pos.y, radius);
+	for (BASE_OBJECT *object : gridList)
 	{
 		unsigned distanceSq = droidSqDist(psDroid, object);  // droidSqDist returns -1 if unreachable, (unsigned)-1 is a big number.
 
@@ -1273,7 +1277,7 @@ static void orderPlayFireSupportAudio(BASE_OBJECT *psObj)
 void orderDroidBase(DROID *psDroid, DROID_ORDER_DATA *psOrder)
 {
 	UDWORD		iFactoryDistSq;
-	STRUCTURE	*psStruct, *psRepairFac, *psFactory;
+	STRUCTURE	*psRepairFac, *psFactory;
 	const PROPULSION_STATS *psPropStats = asPropulsionStats + psDroid->asBits[COMP_PROPULSION];
 	const Vector3i rPos(psOrder->pos, 0);
 
@@ -1564,21 +1568,17 @@ void orderDroidBase(DROID *psDroid, DROID_ORDER_DATA *psOrder)
 			}
 		}
 
-		for (psStruct = apsStructLists[psDroid->player]; psStruct; psStruct = psStruct->psNext)
+		if (!structuresOfType(psDroid->player, REF_HQ).empty())
 		{
-			if (psStruct->pStructureType->type == REF_HQ)
-			{
-				Vector2i pos = psStruct->pos.xy;
+			Vector2i pos = structuresOfType(psDroid->player, REF_HQ).front()->pos.xy;
 
-				psDroid->order = *psOrder;
-				// Find a place to land for vtols. And Transporters in a multiPlay game.
-				if (isVtolDroid(psDroid) || (game.type == SKIRMISH && isTransporter(psDroid)))
-				{
-					actionVTOLLandingPos(psDroid, &pos);
-				}
-				actionDroid(psDroid, DACTION_MOVE, pos.x, pos.y);
-				break;
+			psDroid->order = *psOrder;
+			// Find a place to land for vtols. And Transporters in a multiPlay game.
+			if (isVtolDroid(psDroid) || (game.type == SKIRMISH && isTransporter(psDroid)))
+			{
+				actionVTOLLandingPos(psDroid, &pos);
 			}
+			actionDroid(psDroid, DACTION_MOVE, pos.x, pos.y);
 		}
 		// no HQ go to the landing zone
 		if (psDroid->order.type != DORDER_RTB)
@@ -1609,28 +1609,20 @@ void orderDroidBase(DROID *psDroid, DROID_ORDER_DATA *psOrder)
 		}
 		if (psOrder->psObj == nullptr)
 		{
-			int iRepairFacDistSq = 0;
+			auto reachable = [psDroid](STRUCTURE *psStruct) { return droidSqDist(psDroid, psStruct) > 0; };
 
-			psRepairFac = nullptr;
-			for (psStruct = apsStructLists[psDroid->player]; psStruct; psStruct = psStruct->psNext)
+			/* Choose the nearest reachable built repair facility, or else the nearest one still being built */
+			psRepairFac = findNearestStructureOfType(psDroid->player, REF_REPAIR_FACILITY, psDroid->pos.xy, true, reachable);
+			if (psRepairFac == nullptr)
 			{
-				if ((psStruct->pStructureType->type == REF_REPAIR_FACILITY) ||
-				    ((psStruct->pStructureType->type == REF_HQ) && (psRepairFac == nullptr)))
+				psRepairFac = findNearestStructureOfType(psDroid->player, REF_REPAIR_FACILITY, psDroid->pos.xy, false, reachable);
+			}
+			// No repair facility, so go to the HQ instead.
+			for (STRUCTURE *psStruct : structuresOfType(psDroid->player, REF_HQ))
+			{
+				if (psRepairFac == nullptr && droidSqDist(psDroid, psStruct) > 0)
 				{
-					int iStructDistSq = droidSqDist(psDroid, psStruct);
-
-					if (iStructDistSq <= 0)
-					{
-						continue;	// cannot reach position
-					}
-
-					/* Choose current structure if first repair facility found or nearer than previously chosen facility, or is built */
-					if (psRepairFac == nullptr || psRepairFac->pStructureType->type == REF_HQ || iRepairFacDistSq > iStructDistSq
-					    || (psRepairFac->status != SS_BUILT && psStruct->status == SS_BUILT))
-					{
-						psRepairFac = psStruct;
-						iRepairFacDistSq = iStructDistSq;
-					}
+					psRepairFac = psStruct;
 				}
 			}
 		}
@@ -1717,21 +1709,22 @@ void orderDroidBase(DROID *psDroid, DROID_ORDER_DATA *psOrder)
 	case DORDER_RECYCLE:
 		psFactory = nullptr;
 		iFactoryDistSq = 0;
-		for (psStruct = apsStructLists[psDroid->player]; psStruct; psStruct = psStruct->psNext)
+		// Look for nearest factory or repair facility
+		for (STRUCTURE_TYPE type : {REF_FACTORY, REF_CYBORG_FACTORY, REF_VTOL_FACTORY, REF_REPAIR_FACILITY})
 		{
-			// Look for nearest factory or repair facility
-			if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
-			    || psStruct->pStructureType->type == REF_VTOL_FACTORY || psStruct->pStructureType->type == REF_REPAIR_FACILITY)
+			auto reachable = [psDroid](STRUCTURE *psStruct) { return droidSqDist(psDroid, psStruct) > 0; };
+			STRUCTURE *psStruct = findNearestStructureOfType(psDroid->player, type, psDroid->pos.xy, true, reachable);
+			if (psStruct == nullptr)
 			{
-				/* get droid->facility distance squared */
-				int iStructDistSq = droidSqDist(psDroid, psStruct);
+				continue;
+			}
 
-				/* Choose current structure if first facility found or nearer than previously chosen facility */
-				if (psStruct->status == SS_BUILT && iStructDistSq > 0 && (psFactory == nullptr || iFactoryDistSq > iStructDistSq))
-				{
-					psFactory = psStruct;
-					iFactoryDistSq = iStructDistSq;
-				}
+			/* Choose current structure if first facility found or nearer than previously chosen facility */
+			int iStructDistSq = objPosDiffSq(psDroid->pos, psStruct->pos);
+			if (psFactory == nullptr || iFactoryDistSq > iStructDistSq)
+			{
+				psFactory = psStruct;
+				iFactoryDistSq = iStructDistSq;
 			}
 		}
 
@@ -2874,30 +2867,16 @@ static STRUCTURE *FindAFactory(UDWORD player, UDWORD factoryType)
 {
 	ASSERT_OR_RETURN(nullptr, player < MAX_PLAYERS, "Invalid player number");
 
-	for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != nullptr; psStruct = psStruct->psNext)
-	{
-		if (psStruct->pStructureType->type == factoryType)
-		{
-			return psStruct;
-		}
-	}
-
-	return nullptr;
+	std::vector<STRUCTURE *> const &factories = structuresOfType(player, (STRUCTURE_TYPE)factoryType);
+	return !factories.empty() ? factories.front() : nullptr;
 }
 
 
 /** This function runs though all player's structures to check if any of then is a repair facility. Returns the structure if any was found, and NULL else.*/
 static STRUCTURE *FindARepairFacility(unsigned player)
 {
-	for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != nullptr; psStruct = psStruct->psNext)
-	{
-		if (psStruct->pStructureType->type == REF_REPAIR_FACILITY)
-		{
-			return psStruct;
-		}
-	}
-
-	return nullptr;
+	std::vector<STRUCTURE *> const &repairFacilities = structuresOfType(player, REF_REPAIR_FACILITY);
+	return !repairFacilities.empty() ? repairFacilities.front() : nullptr;
 }
 
 
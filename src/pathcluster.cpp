@@ -0,0 +1,399 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical path-finding, see pathcluster.h.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/math_ext.h"
+
+#include "map.h"
+#include "pathcluster.h"
+
+#include <algorithm>
+
+/// Propulsion domains which have a cluster map. Air units are rarely blocked, so don't need one.
+enum PathClusterDomain
+{
+	PCD_LAND,
+	PCD_WATER,
+	PCD_HOVER,
+	PCD_MAX
+};
+
+struct PathClusterDomainState
+{
+	std::shared_ptr<PathClusterMap> clusterMap;
+	std::vector<bool> dirty;            ///< Clusters to rebuild before the map is next used.
+	bool anyDirty = false;
+};
+
+static PathClusterDomainState clusterDomains[PCD_MAX];
+
+/// State of the map which the cluster maps were built for. If any of this changes, everything is rebuilt.
+static MAPTILE *clusterMapTiles = nullptr;
+static int clusterMapWidth = 0, clusterMapHeight = 0;
+static int clusterScrollMinX = 0, clusterScrollMinY = 0, clusterScrollMaxX = 0, clusterScrollMaxY = 0;
+
+/// Same costs as used by A*, so that the corridor found is similar to what A* would have found.
+static inline unsigned clusterEstimate(Vector2i s, Vector2i f)
+{
+	unsigned xDelta = abs(s.x - f.x), yDelta = abs(s.y - f.y);
+	return std::min(xDelta, yDelta) * (198 - 140) + std::max(xDelta, yDelta) * 140;
+}
+
+/// Finds the connected regions of a cluster. Regions are 4-connected, since A* does not cut corners.
+static void clusterBuildRegions(PathClusterMap &map, int cluster)
+{
+	int x1 = cluster % map.clustersX * PATH_CLUSTER_SIZE;
+	int y1 = cluster / map.clustersX * PATH_CLUSTER_SIZE;
+	int x2 = std::min(x1 + PATH_CLUSTER_SIZE, map.width);
+	int y2 = std::min(y1 + PATH_CLUSTER_SIZE, map.height);
+
+	static const uint8_t unvisited = PATH_REGION_BLOCKED - 1;  // Can't be a real region, since there are at most PATH_CLUSTER_MAX_REGIONS.
+	for (int y = y1; y < y2; ++y)
+	{
+		for (int x = x1; x < x2; ++x)
+		{
+			map.tileRegion[x + y * map.width] = fpathBlockingTile(x, y, map.propulsion) ? PATH_REGION_BLOCKED : unvisited;
+		}
+	}
+
+	std::vector<PathRegion> &regions = map.clusters[cluster].regions;
+	regions.clear();
+	std::vector<Vector2i> stack;
+	for (int y = y1; y < y2; ++y)
+	{
+		for (int x = x1; x < x2; ++x)
+		{
+			if (map.tileRegion[x + y * map.width] != unvisited)
+			{
+				continue;
+			}
+
+			// Flood fill a new region.
+			uint8_t index = regions.size();
+			Vector2i sum(0, 0);
+			int count = 0;
+			map.tileRegion[x + y * map.width] = index;
+			stack.push_back(Vector2i(x, y));
+			while (!stack.empty())
+			{
+				Vector2i p = stack.back();
+				stack.pop_back();
+				sum += p;
+				++count;
+
+				static const Vector2i dirs[4] = {Vector2i(1, 0), Vector2i(0, 1), Vector2i(-1, 0), Vector2i(0, -1)};
+				for (Vector2i const &dir : dirs)
+				{
+					Vector2i n = p + dir;
+					if (n.x >= x1 && n.x < x2 && n.y >= y1 && n.y < y2 && map.tileRegion[n.x + n.y * map.width] == unvisited)
+					{
+						map.tileRegion[n.x + n.y * map.width] = index;
+						stack.push_back(n);
+					}
+				}
+			}
+
+			PathRegion region;
+			region.centre = Vector2i(sum.x / count, sum.y / count);
+			regions.push_back(region);
+		}
+	}
+}
+
+/// Finds the regions in neighbouring clusters touching each region of the cluster.
+static void clusterBuildNeighbours(PathClusterMap &map, int cluster)
+{
+	int x1 = cluster % map.clustersX * PATH_CLUSTER_SIZE;
+	int y1 = cluster / map.clustersX * PATH_CLUSTER_SIZE;
+	int x2 = std::min(x1 + PATH_CLUSTER_SIZE, map.width);
+	int y2 = std::min(y1 + PATH_CLUSTER_SIZE, map.height);
+
+	std::vector<PathRegion> &regions = map.clusters[cluster].regions;
+	for (PathRegion &region : regions)
+	{
+		region.neighbours.clear();
+	}
+
+	auto connect = [&](int x, int y, int nx, int ny) {
+		uint32_t id = map.regionId(x, y);
+		uint32_t other = map.regionId(nx, ny);
+		if (id != UINT32_MAX && other != UINT32_MAX)
+		{
+			regions[id % PATH_CLUSTER_MAX_REGIONS].neighbours.push_back(other);
+		}
+	};
+	for (int x = x1; x < x2; ++x)
+	{
+		connect(x, y1, x, y1 - 1);
+		connect(x, y2 - 1, x, y2);
+	}
+	for (int y = y1; y < y2; ++y)
+	{
+		connect(x1, y, x1 - 1, y);
+		connect(x2 - 1, y, x2, y);
+	}
+
+	for (PathRegion &region : regions)
+	{
+		std::sort(region.neighbours.begin(), region.neighbours.end());
+		region.neighbours.erase(std::unique(region.neighbours.begin(), region.neighbours.end()), region.neighbours.end());
+	}
+}
+
+static PROPULSION_TYPE clusterDomainPropulsion(PathClusterDomain domain)
+{
+	switch (domain)
+	{
+	case PCD_WATER: return PROPULSION_TYPE_PROPELLOR;
+	case PCD_HOVER: return PROPULSION_TYPE_HOVER;
+	default:        return PROPULSION_TYPE_WHEELED;  // All land propulsions block identically.
+	}
+}
+
+static std::shared_ptr<PathClusterMap> clusterBuildMap(PathClusterDomain domain)
+{
+	std::shared_ptr<PathClusterMap> map = std::make_shared<PathClusterMap>();
+	map->propulsion = clusterDomainPropulsion(domain);
+	map->width = mapWidth;
+	map->height = mapHeight;
+	map->clustersX = (mapWidth + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	map->clustersY = (mapHeight + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	map->tileRegion.resize(mapWidth * mapHeight);
+	map->clusters.resize(map->clustersX * map->clustersY);
+
+	for (unsigned cluster = 0; cluster < map->clusters.size(); ++cluster)
+	{
+		clusterBuildRegions(*map, cluster);
+	}
+	for (unsigned cluster = 0; cluster < map->clusters.size(); ++cluster)
+	{
+		clusterBuildNeighbours(*map, cluster);
+	}
+	return map;
+}
+
+/// Rebuilds the dirty clusters, and the neighbours of the clusters which regions may have been renumbered.
+static void clusterUpdateMap(PathClusterDomainState &state)
+{
+	if (state.clusterMap.use_count() > 1)
+	{
+		// Path-finding threads may be using the map, so don't touch it.
+		state.clusterMap = std::make_shared<PathClusterMap>(*state.clusterMap);
+	}
+	PathClusterMap &map = *state.clusterMap;
+
+	std::vector<bool> neighboursDirty(map.clusters.size(), false);
+	for (int cluster = 0; cluster < (int)map.clusters.size(); ++cluster)
+	{
+		if (!state.dirty[cluster])
+		{
+			continue;
+		}
+		clusterBuildRegions(map, cluster);
+		int cx = cluster % map.clustersX, cy = cluster / map.clustersX;
+		neighboursDirty[cluster] = true;
+		if (cx > 0)
+		{
+			neighboursDirty[cluster - 1] = true;
+		}
+		if (cx < map.clustersX - 1)
+		{
+			neighboursDirty[cluster + 1] = true;
+		}
+		if (cy > 0)
+		{
+			neighboursDirty[cluster - map.clustersX] = true;
+		}
+		if (cy < map.clustersY - 1)
+		{
+			neighboursDirty[cluster + map.clustersX] = true;
+		}
+	}
+	for (int cluster = 0; cluster < (int)map.clusters.size(); ++cluster)
+	{
+		if (neighboursDirty[cluster])
+		{
+			clusterBuildNeighbours(map, cluster);
+		}
+	}
+
+	state.dirty.assign(map.clusters.size(), false);
+	state.anyDirty = false;
+}
+
+std::shared_ptr<PathClusterMap const> fpathGetClusterMap(PROPULSION_TYPE propulsion)
+{
+	PathClusterDomain domain;
+	switch (propulsion)
+	{
+	case PROPULSION_TYPE_LIFT:      return nullptr;
+	case PROPULSION_TYPE_PROPELLOR: domain = PCD_WATER; break;
+	case PROPULSION_TYPE_HOVER:     domain = PCD_HOVER; break;
+	default:                        domain = PCD_LAND; break;
+	}
+
+	if (clusterMapTiles != psMapTiles || clusterMapWidth != mapWidth || clusterMapHeight != mapHeight
+	    || clusterScrollMinX != scrollMinX || clusterScrollMinY != scrollMinY || clusterScrollMaxX != scrollMaxX || clusterScrollMaxY != scrollMaxY)
+	{
+		// Different map, or the scroll limits changed, which affects blocking everywhere.
+		fpathClustersReset();
+		clusterMapTiles = psMapTiles;
+		clusterMapWidth = mapWidth;
+		clusterMapHeight = mapHeight;
+		clusterScrollMinX = scrollMinX;
+		clusterScrollMinY = scrollMinY;
+		clusterScrollMaxX = scrollMaxX;
+		clusterScrollMaxY = scrollMaxY;
+	}
+
+	PathClusterDomainState &state = clusterDomains[domain];
+	if (!state.clusterMap)
+	{
+		state.clusterMap = clusterBuildMap(domain);
+		state.dirty.assign(state.clusterMap->clusters.size(), false);
+		state.anyDirty = false;
+	}
+	else if (state.anyDirty)
+	{
+		clusterUpdateMap(state);
+	}
+	return state.clusterMap;
+}
+
+void fpathClustersChanged(StructureBounds const &area)
+{
+	for (PathClusterDomainState &state : clusterDomains)
+	{
+		if (!state.clusterMap)
+		{
+			continue;
+		}
+		PathClusterMap const &map = *state.clusterMap;
+		// Blocking changes can't affect regions further away than the neighbouring tiles, which are handled by rebuilding the neighbours.
+		int cx1 = clip(area.map.x, 0, map.width - 1) / PATH_CLUSTER_SIZE;
+		int cy1 = clip(area.map.y, 0, map.height - 1) / PATH_CLUSTER_SIZE;
+		int cx2 = clip(area.map.x + area.size.x - 1, 0, map.width - 1) / PATH_CLUSTER_SIZE;
+		int cy2 = clip(area.map.y + area.size.y - 1, 0, map.height - 1) / PATH_CLUSTER_SIZE;
+		for (int cy = cy1; cy <= cy2; ++cy)
+		{
+			for (int cx = cx1; cx <= cx2; ++cx)
+			{
+				state.dirty[cx + cy * map.clustersX] = true;
+			}
+		}
+		state.anyDirty = true;
+	}
+}
+
+void fpathClustersReset()
+{
+	for (PathClusterDomainState &state : clusterDomains)
+	{
+		state.clusterMap.reset();
+		state.dirty.clear();
+		state.anyDirty = false;
+	}
+	clusterMapTiles = nullptr;
+}
+
+namespace
+{
+struct PathRegionNode
+{
+	bool operator <(PathRegionNode const &z) const
+	{
+		// Same ordering as PathNode, so the heap has the best node at the front, and ties are broken deterministically.
+		if (est != z.est)
+		{
+			return est > z.est;
+		}
+		if (dist != z.dist)
+		{
+			return dist < z.dist;
+		}
+		return id < z.id;
+	}
+
+	uint32_t id;
+	unsigned dist, est;
+};
+}
+
+bool fpathClusterCorridor(PathClusterMap const &map, Vector2i origTile, Vector2i destTile, PathClusterCorridor &corridor)
+{
+	uint32_t origId = map.regionId(origTile.x, origTile.y);
+	uint32_t destId = map.regionId(destTile.x, destTile.y);
+	if (origId == UINT32_MAX || destId == UINT32_MAX)
+	{
+		return false;  // Starting or ending on a blocking tile, probably going into a structure. Let A* deal with it.
+	}
+
+	size_t numIds = map.clusters.size() * PATH_CLUSTER_MAX_REGIONS;
+	corridor.clusterMap = &map;
+	corridor.regions.assign(numIds, false);
+	corridor.dist.assign(numIds, UINT_MAX);
+	corridor.previous.assign(numIds, UINT32_MAX);
+
+	std::vector<PathRegionNode> nodes;
+	corridor.dist[origId] = 0;
+	nodes.push_back({origId, 0, clusterEstimate(map.region(origId).centre, destTile)});
+	bool found = false;
+	while (!nodes.empty())
+	{
+		std::pop_heap(nodes.begin(), nodes.end());
+		PathRegionNode node = nodes.back();
+		nodes.pop_back();
+		if (node.dist != corridor.dist[node.id])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		if (node.id == destId)
+		{
+			found = true;
+			break;
+		}
+
+		Vector2i centre = map.region(node.id).centre;
+		for (uint32_t neighbour : map.region(node.id).neighbours)
+		{
+			Vector2i neighbourCentre = map.region(neighbour).centre;
+			unsigned dist = node.dist + clusterEstimate(centre, neighbourCentre);
+			if (dist < corridor.dist[neighbour])
+			{
+				corridor.dist[neighbour] = dist;
+				corridor.previous[neighbour] = node.id;
+				nodes.push_back({neighbour, dist, dist + clusterEstimate(neighbourCentre, destTile)});
+				std::push_heap(nodes.begin(), nodes.end());
+			}
+		}
+	}
+	if (!found)
+	{
+		return false;
+	}
+
+	for (uint32_t id = destId; id != UINT32_MAX; id = corridor.previous[id])
+	{
+		corridor.regions[id] = true;
+	}
+	return true;
+}
@@ -0,0 +1,132 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical path-finding.
+ *
+ *  The map is split into square clusters, and each cluster is split into regions of tiles which are connected
+ *  within the cluster. Regions in neighbouring clusters are connected if they touch. Long routes are first
+ *  planned over the graph of regions, and then refined by A*, only exploring tiles in the regions found.
+ *
+ *  The cluster maps are built using fpathBlockingTile(), so all structures block, and updated incrementally
+ *  when structures or features change. They only depend on the synchronised game state.
+ */
+
+#ifndef __INCLUDED_SRC_PATHCLUSTER_H__
+#define __INCLUDED_SRC_PATHCLUSTER_H__
+
+#include "fpath.h"
+
+#include <memory>
+#include <vector>
+
+#define PATH_CLUSTER_SIZE        16     ///< Width and height of a cluster, in tiles.
+#define PATH_CLUSTER_MAX_REGIONS (PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE / 2)  ///< A checkerboard pattern has the most regions.
+#define PATH_REGION_BLOCKED      0xFF   ///< Region index of a blocking tile.
+
+/** A set of connected tiles within a cluster
+ *
+ *  @ingroup pathfinding
+ */
+struct PathRegion
+{
+	Vector2i centre;                    ///< Average tile coordinate of the region, which may not be in the region.
+	std::vector<uint32_t> neighbours;   ///< Ids of touching regions in other clusters, sorted.
+};
+
+struct PathCluster
+{
+	std::vector<PathRegion> regions;
+};
+
+/** Cluster map for one propulsion domain
+ *
+ *  @ingroup pathfinding
+ */
+struct PathClusterMap
+{
+	/// Returns the id of the region containing the given tile, or UINT32_MAX if the tile is blocking or off the map.
+	uint32_t regionId(int x, int y) const
+	{
+		if (x < 0 || y < 0 || x >= width || y >= height || tileRegion[x + y * width] == PATH_REGION_BLOCKED)
+		{
+			return UINT32_MAX;
+		}
+		return clusterIndex(x, y) * PATH_CLUSTER_MAX_REGIONS + tileRegion[x + y * width];
+	}
+	int clusterIndex(int x, int y) const
+	{
+		return x / PATH_CLUSTER_SIZE + y / PATH_CLUSTER_SIZE * clustersX;
+	}
+	PathRegion const &region(uint32_t id) const
+	{
+		return clusters[id / PATH_CLUSTER_MAX_REGIONS].regions[id % PATH_CLUSTER_MAX_REGIONS];
+	}
+
+	PROPULSION_TYPE propulsion;         ///< Propulsion type used for fpathBlockingTile().
+	int width, height;                  ///< Size of the map, in tiles.
+	int clustersX, clustersY;           ///< Size of the map, in clusters.
+	std::vector<uint8_t> tileRegion;    ///< Region index within its cluster for each tile.
+	std::vector<PathCluster> clusters;
+};
+
+/** The regions a route must go through, found by fpathClusterCorridor()
+ *
+ *  @ingroup pathfinding
+ */
+struct PathClusterCorridor
+{
+	bool contains(int x, int y) const
+	{
+		uint32_t id = clusterMap->regionId(x, y);
+		return id != UINT32_MAX && regions[id];
+	}
+
+	PathClusterMap const *clusterMap = nullptr;  ///< Map searched, which must be kept alive by the caller.
+	std::vector<bool> regions;          ///< Indexed by region id.
+
+	// Scratch space for the search, kept to save allocations.
+	std::vector<unsigned> dist;
+	std::vector<uint32_t> previous;
+};
+
+/** Returns the cluster map to use for the given propulsion type, brought up to date with the current blocking
+ *  tiles, or nullptr if hierarchical path-finding is not used for this propulsion type.
+ *
+ *  Call from main thread. The returned map is never modified, so can be used from the path-finding threads.
+ */
+std::shared_ptr<PathClusterMap const> fpathGetClusterMap(PROPULSION_TYPE propulsion);
+
+/** Notify the cluster maps that the blocking state of the given area has changed.
+ *
+ *  Call from main thread. The affected clusters are rebuilt next time fpathGetClusterMap() is called.
+ */
+void fpathClustersChanged(StructureBounds const &area);
+
+/// Forget all cluster maps.
+void fpathClustersReset();
+
+/** Search the cluster map for a route from origTile to destTile, and store the regions it goes through in corridor.
+ *
+ *  Thread-safe, as long as corridor is not shared.
+ *
+ *  @return false if no route was found.
+ */
+bool fpathClusterCorridor(PathClusterMap const &clusterMap, Vector2i origTile, Vector2i destTile, PathClusterCorridor &corridor);
+
+#endif // __INCLUDED_SRC_PATHCLUSTER_H__
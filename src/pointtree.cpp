@@ -35,7 +35,7 @@ may overlap, in which case they are combined.
 
 For illustrations, run "make check" and look at tests/pointtree.ppm. (Different image each time.)
 The coloured areas are the points in the ranges (note that each range also contains some points
-outside the rectangles). The orange points are the search results.
+outside the rectangles).
 */
 
 // Expands bit pattern abcd efgh to 0a0b 0c0d 0e0f 0g0h
@@ -77,6 +77,11 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
+uint64_t PointTree::key(int32_t x, int32_t y)
+{
+	return interleave(x, y);
+}
+
 void PointTree::insert(void *pointData, int32_t x, int32_t y)
 {
 	points.push_back(Point(interleave(x, y), pointData));
@@ -109,27 +114,7 @@ struct PointTreeRange
 	uint64_t a, z;
 };
 
-// If !IsFiltered, function is trivially optimised to "return i;".
-template<bool IsFiltered>
-static unsigned current(std::vector<unsigned> &filterData, unsigned i)
-{
-	unsigned ret = i;
-	while (IsFiltered && filterData[ret])
-	{
-		ret += filterData[ret];
-	}
-	while (IsFiltered && filterData[i])
-	{
-		unsigned next = i + filterData[i];
-		filterData[i] = ret - i;
-		i = next;
-	}
-
-	return ret;
-}
-
-template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+PointTree::Ranges PointTree::findRanges(int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,38 +210,17 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
-	if (IsFiltered)
-	{
-		lastFilteredQueryIndices.clear();
-	}
+	Ranges ret;
+	ret.minX = minX;
+	ret.maxX = maxX;
+	ret.minY = minY;
+	ret.maxY = maxY;
+	ret.count = numRanges;
 	for (int r = 0; r != numRanges; ++r)
 	{
-		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
-		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
-		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
-
-		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
-		{
-			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
-			uint64_t py = points[i].first & 0x5555555555555555ULL;
-			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
-			{
-				lastQueryResults.push_back(points[i].second);
-				if (IsFiltered)
-				{
-					lastFilteredQueryIndices.push_back(i);
-				}
-#ifdef DUMP_IMAGE
-				if (doDump)
-				{
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][0] = 192;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][1] = 128;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][2] = 0;
-				}
-#endif //DUMP_IMAGE
-			}
-		}
+		// Find range of points which may be close enough. Range is [begin ... end - 1]. The pointers are ignored when searching.
+		ret.begin[r] = std::lower_bound(points.begin(),                points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
+		ret.end[r]   = std::upper_bound(points.begin() + ret.begin[r], points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
 	}
 
 #ifdef DUMP_IMAGE
@@ -267,30 +231,5 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 	}
 #endif //DUMP_IMAGE
 
-	return lastQueryResults;
-}
-
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
-{
-	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
-}
-
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
-{
-	Filter unused;
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
-}
-
-PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
-{
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	return ret;
 }
@@ -27,8 +27,6 @@
 class PointTree
 {
 public:
-	typedef std::vector<void *> ResultVector;
-	typedef std::vector<unsigned> IndexVector;
 	class Filter  ///< Filters are invalidated when modifying the PointTree.
 	{
 	public:
@@ -54,26 +52,87 @@ public:
 	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
 	void clear();                                                             ///< Clears the PointTree.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
-	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns all objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults.
-	ResultVector &query(int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults, lastFilteredQueryIndices and the internal filter representation for faster lookups.
-	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
-	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
-
-	ResultVector lastQueryResults;
-	IndexVector lastFilteredQueryIndices;
+	static uint64_t key(int32_t x, int32_t y);                                ///< Points are sorted and visited in order of increasing key.
+
+	/// Calls visit(pointData) for all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
+	/// (More specifically, visits all points in a square with edge length 2*radius.)
+	/// Thread safe, as long as the PointTree is not modified at the same time.
+	template<class Visitor>
+	void visit(int32_t x, int32_t y, uint32_t radius, Visitor &&visitor) const
+	{
+		visitMaybeFilter<false>(nullptr, x - radius, y - radius, x + radius, y + radius, [&visitor](void *pointData, unsigned) { visitor(pointData); });
+	}
+	/// Calls visit(pointData, index) for all points which have not been filtered away, less than or equal to radius from (x, y),
+	/// possibly plus some extra nearby points. The index can be passed to Filter::erase.
+	/// (More specifically, visits points in a square with edge length 2*radius.)
+	/// Thread safe, as long as no other thread uses the same filter, and the PointTree is not modified at the same time.
+	template<class Visitor>
+	void visit(Filter &filter, int32_t x, int32_t y, uint32_t radius, Visitor &&visitor) const
+	{
+		visitMaybeFilter<true>(&filter, x - radius, y - radius, x + radius, y + radius, visitor);
+	}
+	/// Calls visit(pointData) for all points within given rectangle. See function above on thread safety.
+	template<class Visitor>
+	void visitArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Visitor &&visitor) const
+	{
+		visitMaybeFilter<false>(nullptr, x, y, x2, y2, [&visitor](void *pointData, unsigned) { visitor(pointData); });
+	}
 
 private:
 	typedef std::pair<uint64_t, void *> Point;
 	typedef std::vector<Point> Vector;
 
+	/// Ranges of points which may be in the square being searched, and the bounds of the square, as interleaved coordinates.
+	struct Ranges
+	{
+		uint64_t minX, maxX, minY, maxY;
+		unsigned begin[4], end[4];
+		int count;
+	};
+
+	Ranges findRanges(int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const;
+
+	// Returns the first point from i onwards which has not been filtered away.
 	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	static unsigned current(Filter *filter, unsigned i)
+	{
+		if (!IsFiltered)
+		{
+			return i;
+		}
+		std::vector<unsigned> &filterData = filter->data;
+		unsigned ret = i;
+		while (filterData[ret])
+		{
+			ret += filterData[ret];
+		}
+		while (filterData[i])
+		{
+			unsigned next = i + filterData[i];
+			filterData[i] = ret - i;
+			i = next;
+		}
+
+		return ret;
+	}
+
+	template<bool IsFiltered, class Visitor>
+	void visitMaybeFilter(Filter *filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo, Visitor &&visitor) const
+	{
+		Ranges ranges = findRanges(minXo, minYo, maxXo, maxYo);
+		for (int r = 0; r != ranges.count; ++r)
+		{
+			for (unsigned i = current<IsFiltered>(filter, ranges.begin[r]); i < ranges.end[r]; i = current<IsFiltered>(filter, i + 1))
+			{
+				uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
+				uint64_t py = points[i].first & 0x5555555555555555ULL;
+				if (px >= ranges.minX && px <= ranges.maxX && py >= ranges.minY && py <= ranges.maxY)  // Only visit point if it's at least in the desired square.
+				{
+					visitor(points[i].second, i);
+				}
+			}
+		}
+	}
 
 	Vector points;
 };
@@ -62,6 +62,7 @@
 #include "transporter.h"
 #include "template.h"
 #include "multiint.h"
+#include "droidhot.h"
 
 #include "qtscript.h"
 #include "qtscriptfuncs.h"
@@ -711,7 +712,7 @@ void ScriptDebugger::selected(const BASE_OBJECT *psObj)
 		setPair(row, selectedModel, "Action position", QString::fromStdString(glm::to_string(psDroid->actionPos)));
 		setPair(row, selectedModel, "Action started", QString::number(psDroid->actionStarted));
 		setPair(row, selectedModel, "Action points", QString::number(psDroid->actionPoints));
-		setPair(row, selectedModel, "Illumination", QString::number(psDroid->illumination));
+		setPair(row, selectedModel, "Illumination", QString::number(droidHot.illumination[psDroid->hotSlot]));
 		setPair(row, selectedModel, "Blocked bits", QString::number(psDroid->blockedBits));
 		setPair(row, selectedModel, "Move status", QString::number(psDroid->sMove.Status));
 		setPair(row, selectedModel, "Move index", QString::number(psDroid->sMove.pathIndex));
@@ -99,6 +99,7 @@ enum Scrcb {
 
 // TODO, move this stuff into a script common subsystem
 #include "scriptfuncs.h"
+#include "tickprofile.h"
 extern bool structDoubleCheck(BASE_STATS *psStat, UDWORD xx, UDWORD yy, SDWORD maxBlockingTiles);
 extern Vector2i positions[MAX_PLAYERS];
 extern std::vector<Vector2i> derricks;
@@ -2896,6 +2897,10 @@ static QScriptValue js_gameOverMessage(QScriptContext *context, QScriptEngine *e
 	if (autogame_enabled())
 	{
 		debug(LOG_WARNING, "Autogame completed successfully!");
+		if (tickProfileEnabled())
+		{
+			tickProfileWriteTrace("tickprofile.json");
+		}
 		exit(0);
 	}
 	return QScriptValue();
@@ -3731,7 +3736,7 @@ static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(4).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
+	gridQuery(gridList, x, y, range);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -3796,7 +3801,7 @@ static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(nextparam - 1).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateArea(x1, y1, x2, y2);
+	gridQueryArea(gridList, x1, y1, x2, y2);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -49,6 +49,7 @@
 #include "intdisplay.h"
 #include "texture.h"
 #include "warzoneconfig.h"
+#include "droidhot.h"
 #include <glm/gtx/transform.hpp>
 
 #define HIT_NOTIFICATION	(GAME_TICKS_PER_SEC * 2)
@@ -399,58 +400,66 @@ static void DrawRadarObjects()
 	PIELIGHT			flashCol;
 	int				x, y;
 
-	/* Show droids on map - go through all players */
+	droidHotUpdate();
+
+	/* Work out the colours of each player's droids */
+	PIELIGHT clanCol[MAX_PLAYERS];
+	PIELIGHT clanFlashCol[MAX_PLAYERS];
+	bool clanSharesVision[MAX_PLAYERS];
 	for (clan = 0; clan < MAX_PLAYERS; clan++)
 	{
-		DROID		*psDroid;
-
 		//see if have to draw enemy/ally color
 		if (bEnemyAllyRadarColor)
 		{
 			if (clan == selectedPlayer)
 			{
-				playerCol = colRadarMe;
+				clanCol[clan] = colRadarMe;
 			}
 			else
 			{
-				playerCol = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly : colRadarEnemy);
+				clanCol[clan] = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly : colRadarEnemy);
 			}
 		}
 		else
 		{
 			//original 8-color mode
 			STATIC_ASSERT(MAX_PLAYERS <= ARRAY_SIZE(clanColours));
-			playerCol = clanColours[getPlayerColour(clan)];
+			clanCol[clan] = clanColours[getPlayerColour(clan)];
 		}
 
 		STATIC_ASSERT(MAX_PLAYERS <= ARRAY_SIZE(flashColours));
-		flashCol = flashColours[getPlayerColour(clan)];
+		clanFlashCol[clan] = flashColours[getPlayerColour(clan)];
+		clanSharesVision[clan] = bMultiPlayer && alliancesSharedVision(game.alliance) && aiCheckAlliances(selectedPlayer, clan);
+	}
 
-		/* Go through all droids */
-		for (psDroid = apsDroidLists[clan]; psDroid != nullptr; psDroid = psDroid->psNext)
+	/* Show droids on map - go through all droids once */
+	for (size_t slot = 0; slot < droidHot.size(); ++slot)
+	{
+		if (!droidHot.listed[slot])
+		{
+			continue;
+		}
+		clan = droidHot.player[slot];
+		Position const &droidPos = droidHot.pos[slot];
+		if (droidPos.x < world_coord(scrollMinX) || droidPos.y < world_coord(scrollMinY)
+		    || droidPos.x >= world_coord(scrollMaxX) || droidPos.y >= world_coord(scrollMaxY))
 		{
-			if (psDroid->pos.x < world_coord(scrollMinX) || psDroid->pos.y < world_coord(scrollMinY)
-			    || psDroid->pos.x >= world_coord(scrollMaxX) || psDroid->pos.y >= world_coord(scrollMaxY))
+			continue;
+		}
+		if (droidHot.visible[slot][selectedPlayer] || clanSharesVision[clan])
+		{
+			int	x = droidPos.x / TILE_UNITS;
+			int	y = droidPos.y / TILE_UNITS;
+			size_t	pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
+
+			ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
+			if (clan == selectedPlayer && gameTime - droidHot.droid[slot]->timeLastHit < HIT_NOTIFICATION)
 			{
-				continue;
+				radarBuffer[pos] = clanFlashCol[clan].rgba;
 			}
-			if (psDroid->visible[selectedPlayer]
-			    || (bMultiPlayer && alliancesSharedVision(game.alliance)
-			        && aiCheckAlliances(selectedPlayer, psDroid->player)))
+			else
 			{
-				int	x = psDroid->pos.x / TILE_UNITS;
-				int	y = psDroid->pos.y / TILE_UNITS;
-				size_t	pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
-
-				ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
-				if (clan == selectedPlayer && gameTime - psDroid->timeLastHit < HIT_NOTIFICATION)
-				{
-					radarBuffer[pos] = flashCol.rgba;
-				}
-				else
-				{
-					radarBuffer[pos] = playerCol.rgba;
-				}
+				radarBuffer[pos] = clanCol[clan].rgba;
 			}
 		}
 	}
@@ -0,0 +1,353 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording multiplayer and skirmish games, and playing them back, see replay.h.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/ivis_opengl/screen.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <physfs.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "replay.h"
+#include "ai.h"
+#include "component.h"
+#include "console.h"
+#include "frontend.h"
+#include "init.h"
+#include "levels.h"
+#include "multiplay.h"
+#include "random.h"
+#include "version.h"
+
+static bool replayReported = false;
+static uint32_t replayStartGameTime = 0;
+static uint32_t replayStartRealTime = 0;
+static bool replayStarted = false;
+static bool replayRecording = true;  ///< whether to record games, see replaySetRecording()
+static unsigned replayMaxKept = 20;  ///< replays to keep, see replaySetMaxKept()
+
+void replaySetRecording(bool enable)
+{
+	replayRecording = enable;
+}
+
+bool replayGetRecording()
+{
+	return replayRecording;
+}
+
+void replaySetMaxKept(unsigned count)
+{
+	replayMaxKept = count;
+}
+
+unsigned replayGetMaxKept()
+{
+	return replayMaxKept;
+}
+
+/// Deletes the oldest replays, leaving at most keep. The file names start with the date, so they sort oldest first.
+static void replayPrune(unsigned keep)
+{
+	std::vector<std::string> replays;
+	char **files = PHYSFS_enumerateFiles("replay");
+	for (char **i = files; *i != nullptr; ++i)
+	{
+		std::string name = *i;
+		if (name.size() > 5 && name.compare(name.size() - 5, 5, ".wzrp") == 0)
+		{
+			replays.push_back(name);
+		}
+	}
+	PHYSFS_freeList(files);
+
+	std::sort(replays.begin(), replays.end());
+	for (size_t i = 0; i + keep < replays.size(); ++i)
+	{
+		std::string path = "replay/" + replays[i];
+		if (!PHYSFS_delete(path.c_str()))
+		{
+			debug(LOG_WARNING, "Could not delete old replay %s: %s", path.c_str(), PHYSFS_getLastError());
+		}
+	}
+}
+
+bool replaySaveStart(uint32_t randomSeed)
+{
+	if (!replayRecording)
+	{
+		return false;
+	}
+
+	QJsonObject settings;
+	settings["version"] = version_getVersionString();
+	settings["randomSeed"] = (double)randomSeed;
+	settings["selectedPlayer"] = (int)selectedPlayer;
+	settings["level"] = aLevelName;
+
+	QJsonObject gameObj;
+	gameObj["type"] = game.type;
+	gameObj["scavengers"] = game.scavengers;
+	gameObj["map"] = game.map;
+	gameObj["maxPlayers"] = game.maxPlayers;
+	gameObj["name"] = game.name;
+	gameObj["hash"] = QString::fromStdString(game.hash.toString());
+	QJsonArray modHashes;
+	for (Sha256 const &hash : game.modHashes)
+	{
+		modHashes.append(QString::fromStdString(hash.toString()));
+	}
+	gameObj["modHashes"] = modHashes;
+	gameObj["power"] = (double)game.power;
+	gameObj["base"] = game.base;
+	gameObj["alliance"] = game.alliance;
+	QJsonArray skDiff;
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		skDiff.append(game.skDiff[i]);
+	}
+	gameObj["skDiff"] = skDiff;
+	gameObj["mapHasScavengers"] = game.mapHasScavengers;
+	gameObj["isMapMod"] = game.isMapMod;
+	gameObj["deltaEncoding"] = game.deltaEncoding;
+	settings["game"] = gameObj;
+
+	QJsonArray allianceList;
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		QJsonArray allies;
+		for (int j = 0; j < MAX_PLAYERS; ++j)
+		{
+			allies.append(alliances[i][j]);
+		}
+		allianceList.append(allies);
+	}
+	settings["alliances"] = allianceList;
+
+	QJsonArray limits;
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		QJsonArray limit;
+		limit.append((double)ingame.pStructureLimits[i].id);
+		limit.append((double)ingame.pStructureLimits[i].limit);
+		limits.append(limit);
+	}
+	settings["structureLimits"] = limits;
+	settings["flags"] = ingame.flags;
+
+	QJsonArray players;
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PLAYER const &p = NetPlay.players[i];
+		QJsonObject player;
+		player["name"] = p.name;
+		player["position"] = p.position;
+		player["colour"] = p.colour;
+		player["allocated"] = p.allocated;
+		player["team"] = p.team;
+		player["ai"] = p.ai;
+		player["difficulty"] = p.difficulty;
+		player["autoGame"] = p.autoGame;
+		players.append(player);
+	}
+	settings["players"] = players;
+
+	time_t aclock;
+	time(&aclock);
+	struct tm *t = localtime(&aclock);
+	char filename[256];
+	snprintf(filename, sizeof(filename), "replay/%04d%02d%02d_%02d%02d%02d_%s.wzrp", t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec, game.map);
+	PHYSFS_mkdir("replay");
+	if (replayMaxKept != 0)
+	{
+		replayPrune(replayMaxKept - 1);
+	}
+
+	QByteArray json = QJsonDocument(settings).toJson(QJsonDocument::Compact);
+	return NETreplaySaveStart(filename, std::string(json.constData(), json.size()));
+}
+
+bool replayLoadStart(std::string const &filename)
+{
+	std::string settingsData;
+	if (!NETreplayLoadStart(filename, settingsData))
+	{
+		return false;
+	}
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson(QByteArray(settingsData.data(), settingsData.size()), &error);
+	if (doc.isNull() || !doc.isObject())
+	{
+		debug(LOG_ERROR, "Bad settings in replay %s: %s", filename.c_str(), error.errorString().toUtf8().constData());
+		NETreplayLoadStop();
+		return false;
+	}
+	QJsonObject settings = doc.object();
+
+	if (settings["version"].toString() != version_getVersionString())
+	{
+		debug(LOG_WARNING, "Replay %s was recorded with version %s, and will probably not replay correctly.", filename.c_str(), settings["version"].toString().toUtf8().constData());
+	}
+
+	SPinit();
+
+	QJsonObject gameObj = settings["game"].toObject();
+	game.type = gameObj["type"].toInt();
+	game.scavengers = gameObj["scavengers"].toBool();
+	sstrcpy(game.map, gameObj["map"].toString().toUtf8().constData());
+	game.maxPlayers = gameObj["maxPlayers"].toInt();
+	sstrcpy(game.name, gameObj["name"].toString().toUtf8().constData());
+	game.hash.fromString(gameObj["hash"].toString().toStdString());
+	game.modHashes.clear();
+	for (QJsonValue const &hash : gameObj["modHashes"].toArray())
+	{
+		game.modHashes.emplace_back();
+		game.modHashes.back().fromString(hash.toString().toStdString());
+	}
+	game.power = gameObj["power"].toDouble();
+	game.base = gameObj["base"].toInt();
+	game.alliance = gameObj["alliance"].toInt();
+	QJsonArray skDiff = gameObj["skDiff"].toArray();
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		game.skDiff[i] = skDiff[i].toInt();
+	}
+	game.mapHasScavengers = gameObj["mapHasScavengers"].toBool();
+	game.isMapMod = gameObj["isMapMod"].toBool();
+	game.deltaEncoding = gameObj["deltaEncoding"].toBool(true);
+
+	QJsonArray allianceList = settings["alliances"].toArray();
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		QJsonArray allies = allianceList[i].toArray();
+		for (int j = 0; j < MAX_PLAYERS; ++j)
+		{
+			alliances[i][j] = allies[j].toInt();
+		}
+	}
+
+	if (ingame.numStructureLimits)
+	{
+		ingame.numStructureLimits = 0;
+		free(ingame.pStructureLimits);
+		ingame.pStructureLimits = nullptr;
+	}
+	QJsonArray limits = settings["structureLimits"].toArray();
+	ingame.numStructureLimits = limits.size();
+	if (ingame.numStructureLimits)
+	{
+		ingame.pStructureLimits = (MULTISTRUCTLIMITS *)malloc(ingame.numStructureLimits * sizeof(MULTISTRUCTLIMITS));
+	}
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		ingame.pStructureLimits[i].id = limits[i].toArray()[0].toDouble();
+		ingame.pStructureLimits[i].limit = limits[i].toArray()[1].toDouble();
+	}
+	ingame.flags = settings["flags"].toInt();
+
+	QJsonArray players = settings["players"].toArray();
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		QJsonObject player = players[i].toObject();
+		PLAYER &p = NetPlay.players[i];
+		sstrcpy(p.name, player["name"].toString().toUtf8().constData());
+		p.position = player["position"].toInt();
+		setPlayerColour(i, player["colour"].toInt());
+		p.allocated = player["allocated"].toBool();
+		p.team = player["team"].toInt();
+		p.ai = player["ai"].toInt();
+		p.difficulty = player["difficulty"].toInt();
+		p.autoGame = player["autoGame"].toBool();
+		ingame.JoiningInProgress[i] = false;
+	}
+
+	selectedPlayer = settings["selectedPlayer"].toInt();
+	realSelectedPlayer = selectedPlayer;
+	NetPlay.isHost = false;
+	NetPlay.bComms = false;
+	bMultiPlayer = true;
+	bMultiMessages = true;
+	ingame.localJoiningInProgress = false;
+	ingame.localOptionsReceived = true;
+
+	// Find the map, the same way as when getting the options from the host.
+	levShutDown();
+	levInitialise();
+	rebuildSearchPath(mod_multiplay, true);
+	buildMapList();
+	sstrcpy(aLevelName, settings["level"].toString().toUtf8().constData());
+	if (levFindDataSet(game.map, &game.hash) == nullptr)
+	{
+		debug(LOG_ERROR, "Don't have the map %s needed by replay %s.", game.map, filename.c_str());
+		NETreplayLoadStop();
+		return false;
+	}
+
+	gameSRand(settings["randomSeed"].toDouble());
+
+	replayReported = false;
+	replayStarted = false;
+	debug(LOG_INFO, "Replaying %s, map %s, as player %u.", filename.c_str(), game.map, selectedPlayer);
+	return true;
+}
+
+void replayCheckEnded()
+{
+	if (!NETisReplay() || replayReported)
+	{
+		return;
+	}
+	if (!replayStarted)
+	{
+		replayStarted = true;
+		replayStartGameTime = gameTime;
+		replayStartRealTime = wzGetTicks();
+	}
+	if (!NETreplayLoadEnded())
+	{
+		return;
+	}
+
+	replayReported = true;
+	unsigned ticks = (gameTime - replayStartGameTime) / GAME_TICKS_PER_UPDATE;
+	double seconds = (wzGetTicks() - replayStartRealTime) / 1000.;
+	unsigned checked, mismatched;
+	NETreplayCheckpoints(checked, mismatched);
+	char msg[256];
+	snprintf(msg, sizeof(msg), "Replay ended at gameTime %u: %u ticks in %.2f s, %.1f ticks/s. %u of %u sync checks failed.",
+	         gameTime, ticks, seconds, seconds > 0 ? ticks / seconds : 0., mismatched, checked);
+	debug(mismatched != 0 ? LOG_ERROR : LOG_INFO, "%s", msg);
+	addConsoleMessage(msg, DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+
+	if (wz_headless)
+	{
+		wzQuit();
+	}
+}
@@ -0,0 +1,52 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording multiplayer and skirmish games, and playing them back.
+ *
+ *  The game settings and random seed are saved with the game messages recorded by lib/netplay/netreplay.h. Playing a
+ *  replay back (with --replay, and --headless to run it as fast as possible) gives the same game, and reports the
+ *  number of ticks per second and whether the sync debug CRCs all matched.
+ */
+
+#ifndef __INCLUDED_SRC_REPLAY_H__
+#define __INCLUDED_SRC_REPLAY_H__
+
+#include "lib/framework/types.h"
+
+#include <string>
+
+/// Starts recording a game about to start with the given random seed, to replay/<date>_<map>.wzrp, unless recording
+/// is turned off. Deletes the oldest replays, to keep at most replayGetMaxKept(). Returns false if not recording.
+bool replaySaveStart(uint32_t randomSeed);
+
+/// Whether to record multiplayer and skirmish games.
+void replaySetRecording(bool enable);
+bool replayGetRecording();
+
+/// How many recorded replays to keep in the replay directory, including the one being recorded. 0 keeps them all.
+void replaySetMaxKept(unsigned count);
+unsigned replayGetMaxKept();
+
+/// Loads a replay, and sets up the game settings to start playing it.
+bool replayLoadStart(std::string const &filename);
+
+/// Called each game loop. Once the replay has run out of messages, reports the results, and quits if headless.
+void replayCheckEnded();
+
+#endif // __INCLUDED_SRC_REPLAY_H__
@@ -224,6 +224,11 @@ static void seq_SetUserResolution()
 //full screenvideo functions
 static bool seq_StartFullScreenVideo(const QString& videoName, const QString& audioName, VIDEO_RESOLUTION resolution)
 {
+	if (wz_headless)
+	{
+		return false;  // Behave as if the sequence was missing.
+	}
+
 	QString aAudioName("sequenceaudio/" + audioName);
 
 	bHoldSeqForAudio = false;
@@ -166,6 +166,7 @@ static void auxStructureNonblocking(STRUCTURE *psStructure)
 			auxClearAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING | AUXBITS_OUR_BUILDING | AUXBITS_NONPASSABLE);
 		}
 	}
+	fpathBlockingTilesChanged(b);
 }
 
 static void auxStructureBlocking(STRUCTURE *psStructure)
@@ -180,6 +181,7 @@ static void auxStructureBlocking(STRUCTURE *psStructure)
 			auxSetAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING | AUXBITS_NONPASSABLE);
 		}
 	}
+	fpathBlockingTilesChanged(b);
 }
 
 static void auxStructureOpenGate(STRUCTURE *psStructure)
@@ -193,6 +195,7 @@ static void auxStructureOpenGate(STRUCTURE *psStructure)
 			auxClearAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING);
 		}
 	}
+	fpathBlockingTilesChanged(b);
 }
 
 static void auxStructureClosedGate(STRUCTURE *psStructure)
@@ -207,6 +210,7 @@ static void auxStructureClosedGate(STRUCTURE *psStructure)
 			auxSetAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING);
 		}
 	}
+	fpathBlockingTilesChanged(b);
 }
 
 bool IsStatExpansionModule(const STRUCTURE_STATS *psStats)
@@ -1397,6 +1401,10 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 				}
 			}
 		}
+		if (psBuilding->sDisplay.imd->max.y > TALLOBJECT_YMAX)
+		{
+			fpathBlockingTilesChanged(StructureBounds(map, size));  // Not all structures call auxStructureBlocking().
+		}
 
 		switch (pStructureType->type)
 		{
@@ -3518,7 +3526,7 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 			bool		found = false;
 
 			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
+			gridQuery(gridList, psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
 			for (GridIterator gi = gridList.begin(); !found && gi != gridList.end(); ++gi)
 			{
 				found = isDroid(*gi);
@@ -4724,23 +4732,15 @@ bool  structureIdle(STRUCTURE *psBuilding)
 /*checks to see if any structure exists of a specified type with a specified status */
 bool checkStructureStatus(STRUCTURE_STATS *psStats, UDWORD player, UDWORD status)
 {
-	STRUCTURE	*psStructure;
-	bool		found = false;
-
-	for (psStructure = apsStructLists[player]; psStructure != nullptr;
-	     psStructure = psStructure->psNext)
+	for (STRUCTURE *psStructure : structuresOfType(player, psStats->type))
 	{
-		if (psStructure->pStructureType->type == psStats->type)
+		//need to check if THIS instance of the type has the correct status
+		if (psStructure->status == status)
 		{
-			//need to check if THIS instance of the type has the correct status
-			if (psStructure->status == status)
-			{
-				found = true;
-				break;
-			}
+			return true;
 		}
 	}
-	return found;
+	return false;
 }
 
 
@@ -4748,25 +4748,16 @@ bool checkStructureStatus(STRUCTURE_STATS *psStats, UDWORD player, UDWORD status
 stat type*/
 bool checkSpecificStructExists(UDWORD structInc, UDWORD player)
 {
-	STRUCTURE	*psStructure;
-	bool		found = false;
-
 	ASSERT_OR_RETURN(false, structInc < numStructureStats, "Invalid structure inc");
 
-	for (psStructure = apsStructLists[player]; psStructure != nullptr;
-	     psStructure = psStructure->psNext)
+	for (STRUCTURE *psStructure : structuresOfType(player, asStructureStats[structInc].type))
 	{
-		if (psStructure->status == SS_BUILT)
+		if (psStructure->status == SS_BUILT && psStructure->pStructureType->ref - REF_STRUCTURE_START == structInc)
 		{
-			if ((psStructure->pStructureType->ref - REF_STRUCTURE_START) ==
-			    structInc)
-			{
-				found = true;
-				break;
-			}
+			return true;
 		}
 	}
-	return found;
+	return false;
 }
 
 
@@ -5130,9 +5121,9 @@ void checkForPowerGen(STRUCTURE *psBuilding)
 	// Find a power generator, if possible with a power module.
 	STRUCTURE *bestPowerGen = nullptr;
 	int bestSlot = 0;
-	for (STRUCTURE *psCurr = apsStructLists[psBuilding->player]; psCurr != nullptr; psCurr = psCurr->psNext)
+	for (STRUCTURE *psCurr : structuresOfType(psBuilding->player, REF_POWER_GEN))
 	{
-		if (psCurr->pStructureType->type == REF_POWER_GEN && psCurr->status == SS_BUILT)
+		if (psCurr->status == SS_BUILT)
 		{
 			if (bestPowerGen != nullptr && bestPowerGen->capacity >= psCurr->capacity)
 			{
@@ -6662,10 +6653,9 @@ STRUCTURE *findNearestReArmPad(DROID *psDroid, STRUCTURE *psTarget, bool bClear)
 	totallyDist = SDWORD_MAX;
 	psNearest = nullptr;
 	psTotallyClear = nullptr;
-	for (STRUCTURE *psStruct = apsStructLists[psDroid->player]; psStruct; psStruct = psStruct->psNext)
+	for (STRUCTURE *psStruct : structuresOfType(psDroid->player, REF_REARM_PAD))
 	{
-		if (psStruct->pStructureType->type == REF_REARM_PAD
-		    && (!bClear || clearRearmPad(psStruct)))
+		if (!bClear || clearRearmPad(psStruct))
 		{
 			xdiff = (SDWORD)psStruct->pos.x - cx;
 			ydiff = (SDWORD)psStruct->pos.y - cy;
@@ -6699,6 +6689,81 @@ STRUCTURE *findNearestReArmPad(DROID *psDroid, STRUCTURE *psTarget, bool bClear)
 	return psNearest;
 }
 
+#define NEAREST_STRUCTURE_SCAN_MAX 32  ///< Above this many structures of the type, search the grid instead of all of them.
+
+static int64_t structureDistSq(STRUCTURE const *psStruct, Vector2i pos)
+{
+	int64_t dx = psStruct->pos.x - pos.x;
+	int64_t dy = psStruct->pos.y - pos.y;
+	return dx * dx + dy * dy;
+}
+
+// Whether psStruct at distSq from pos is nearer than psBest at bestDistSq, using the lowest id if equally near.
+static bool nearerStructure(STRUCTURE const *psStruct, int64_t distSq, STRUCTURE const *psBest, int64_t bestDistSq)
+{
+	return psBest == nullptr || distSq < bestDistSq || (distSq == bestDistSq && psStruct->id < psBest->id);
+}
+
+STRUCTURE *findNearestStructureOfType(unsigned player, STRUCTURE_TYPE type, Vector2i pos, bool builtOnly, std::function<bool (STRUCTURE *)> const &accept)
+{
+	std::vector<STRUCTURE *> const &structs = structuresOfType(player, type);
+	STRUCTURE *psBest = nullptr;
+	int64_t bestDistSq = 0;
+
+	if (structs.size() > NEAREST_STRUCTURE_SCAN_MAX)
+	{
+		// Search a growing circle, until it contains the nearest structure found. The grid may not yet contain
+		// structures added this tick, so if the whole map has been searched without finding one, scan them all.
+		static GridList gridList;  // static to avoid allocations.
+		int maxRadius = world_coord(std::max(mapWidth, mapHeight)) * 3 / 2;
+		for (int radius = world_coord(8); psBest == nullptr && radius < maxRadius * 2; radius *= 2)
+		{
+			gridQuery(gridList, pos.x, pos.y, radius);
+			for (BASE_OBJECT *psObj : gridList)
+			{
+				if (psObj->type != OBJ_STRUCTURE || psObj->player != player || psObj->died)
+				{
+					continue;
+				}
+				STRUCTURE *psStruct = castStructure(psObj);
+				if (psStruct->pStructureType->type != type || (builtOnly && psStruct->status != SS_BUILT))
+				{
+					continue;
+				}
+				int64_t distSq = structureDistSq(psStruct, pos);
+				if (nearerStructure(psStruct, distSq, psBest, bestDistSq) && (!accept || accept(psStruct)))
+				{
+					psBest = psStruct;
+					bestDistSq = distSq;
+				}
+			}
+			if (psBest != nullptr && bestDistSq > (int64_t)radius * radius)
+			{
+				psBest = nullptr;  // Something nearer may be just outside the circle, so look further.
+			}
+		}
+		if (psBest != nullptr)
+		{
+			return psBest;
+		}
+	}
+
+	for (STRUCTURE *psStruct : structs)
+	{
+		if (builtOnly && psStruct->status != SS_BUILT)
+		{
+			continue;
+		}
+		int64_t distSq = structureDistSq(psStruct, pos);
+		if (nearerStructure(psStruct, distSq, psBest, bestDistSq) && (!accept || accept(psStruct)))
+		{
+			psBest = psStruct;
+			bestDistSq = distSq;
+		}
+	}
+	return psBest;
+}
+
 
 // clear a rearm pad for a droid to land on it
 void ensureRearmPadClear(STRUCTURE *psStruct, DROID *psDroid)
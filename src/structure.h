@@ -26,6 +26,8 @@
 
 #include "lib/framework/string_ext.h"
 
+#include <functional>
+
 #include "objectdef.h"
 #include "structuredef.h"
 #include "visibility.h"
@@ -320,6 +322,11 @@ bool structVTOLCBSensor(const STRUCTURE *psStruct);
 // psTarget can be NULL
 STRUCTURE *findNearestReArmPad(DROID *psDroid, STRUCTURE *psTarget, bool bClear);
 
+/// Returns the structure of the given type belonging to player nearest to pos, or nullptr if there is none.
+/// If builtOnly, ignores structures which are not yet fully built. If accept is given, ignores structures it returns false for.
+/// Equally near structures are picked by lowest id.
+STRUCTURE *findNearestStructureOfType(unsigned player, STRUCTURE_TYPE type, Vector2i pos, bool builtOnly, std::function<bool (STRUCTURE *)> const &accept = nullptr);
+
 // check whether a rearm pad is clear
 bool clearRearmPad(const STRUCTURE *psStruct);
 
@@ -598,6 +598,11 @@ bool initTerrain()
 	int maxSectorSizeIndices, maxSectorSizeVertices;
 	bool decreasedSize = false;
 
+	if (wz_headless)
+	{
+		return true;  // Nothing is drawn, so keep terrainInitialised false and skip building the sectors.
+	}
+
 	// this information is useful to prevent crashes with buggy opengl implementations
 	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &GLmaxElementsVertices);
 	glGetIntegerv(GL_MAX_ELEMENTS_INDICES,  &GLmaxElementsIndices);
@@ -942,6 +947,10 @@ bool initTerrain()
 /// free all memory and opengl buffers used by the terrain renderer
 void shutdownTerrain()
 {
+	if (wz_headless)
+	{
+		return;
+	}
 	if (!sectors)
 	{
 		// This happens in some cases when loading a savegame from level init
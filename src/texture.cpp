@@ -28,9 +28,14 @@
 
 #include <string.h>
 #include <physfs.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
+#include "lib/framework/crc.h"
 #include "lib/framework/file.h"
 #include "lib/framework/string_ext.h"
+#include "lib/framework/wzworkers.h"
 
 #include "lib/ivis_opengl/pietypes.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -54,6 +59,28 @@ static int firstPage; // the last used page before we start adding terrain textu
 int terrainPage; // texture ID of the terrain page
 static int mipmap_max, mipmap_levels;
 static int maxTextureSize = 2048; ///< the maximum size texture we will create
+static bool textureCache = true; ///< whether to keep the decoded tiles in the write directory, see texLoadCache()
+
+#define TEXCACHE_VERSION	1
+
+/// A tile of a tileset, at one mipmap level.
+struct TexTile
+{
+	std::string fileName;
+	unsigned size;          ///< Width and height, in pixels.
+	size_t offset;          ///< Where its size × size RGBA pixels are in the tile data.
+};
+
+/// Start of a tile cache file, followed by the tile data.
+struct TexCacheHeader
+{
+	char magic[4];                          ///< "WZTC"
+	uint32_t version;                       ///< TEXCACHE_VERSION
+	uint32_t key;                           ///< texCacheKey() of the tiles.
+	uint32_t mipmapMax;
+	uint32_t mipmapLevels;
+	uint32_t numTiles[MIPMAP_LEVELS];       ///< Number of tiles at each mipmap level.
+};
 
 void setTextureSize(int texSize)
 {
@@ -71,6 +98,113 @@ int getTextureSize()
 	return maxTextureSize;
 }
 
+void setTextureCache(bool enable)
+{
+	textureCache = enable;
+}
+
+bool getTextureCache()
+{
+	return textureCache;
+}
+
+/// Identifies which files the tiles were decoded from, so the cache is not used if a tile is changed, or a mod replaces it.
+static uint32_t texCacheKey(std::vector<TexTile> const &tiles)
+{
+	std::string key;
+	for (TexTile const &tile : tiles)
+	{
+		const char *realDir = PHYSFS_getRealDir(tile.fileName.c_str());
+		PHYSFS_sint64 modTime = PHYSFS_getLastModTime(tile.fileName.c_str());
+		key += tile.fileName;
+		key += realDir != nullptr ? realDir : "";
+		key.append((const char *)&modTime, sizeof(modTime));
+	}
+	return crcSum(0, key.data(), key.size());
+}
+
+/// Loads the tiles decoded by an earlier texSaveCache(), if the cache was made from the same files.
+static bool texLoadCache(const char *cacheName, TexCacheHeader const &expected, std::vector<unsigned char> &tileData)
+{
+	char *buffer;
+	unsigned size;
+
+	if (!PHYSFS_exists(cacheName) || !loadFile(cacheName, &buffer, &size))
+	{
+		return false;
+	}
+	TexCacheHeader header;
+	bool ok = size == sizeof(header) + tileData.size();
+	if (ok)
+	{
+		memcpy(&header, buffer, sizeof(header));
+		ok = memcmp(&header, &expected, sizeof(header)) == 0;
+	}
+	if (ok)
+	{
+		memcpy(tileData.data(), buffer + sizeof(header), tileData.size());
+		debug(LOG_TEXTURE, "Loaded tiles from %s", cacheName);
+	}
+	else
+	{
+		debug(LOG_TEXTURE, "Tiles changed since %s was saved", cacheName);
+	}
+	free(buffer);
+	return ok;
+}
+
+/// Saves the decoded tiles, so the next texLoad() of the tileset at the same size can skip decoding them.
+static void texSaveCache(const char *cacheName, TexCacheHeader const &header, std::vector<unsigned char> const &tileData)
+{
+	std::vector<char> data(sizeof(header) + tileData.size());
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), tileData.data(), tileData.size());
+	PHYSFS_mkdir("cache");
+	if (!saveFile(cacheName, data.data(), data.size()))
+	{
+		debug(LOG_WARNING, "Could not save tile cache %s", cacheName);
+	}
+}
+
+/// Decodes the tiles into tileData, on the worker threads.
+static bool texDecodeTiles(std::vector<TexTile> const &tiles, std::vector<unsigned char> &tileData)
+{
+	std::vector<char> loaded(tiles.size());
+	wzWorkersParallelFor(tiles.size(), [&](unsigned n) {
+		TexTile const &tile = tiles[n];
+		iV_Image image;
+		loaded[n] = iV_loadImage_PNG(tile.fileName.c_str(), &image);
+		if (!loaded[n])
+		{
+			return;
+		}
+		// Clip anything bigger than the other tiles, so it can't overwrite them.
+		unsigned width = std::min(image.width, tile.size);
+		unsigned height = std::min(image.height, tile.size);
+		for (unsigned y = 0; y < height; ++y)
+		{
+			memcpy(&tileData[tile.offset + y * tile.size * 4], image.bmp + y * image.width * 4, width * 4);
+		}
+		free(image.bmp);
+	});
+	for (size_t n = 0; n < tiles.size(); ++n)
+	{
+		ASSERT_OR_RETURN(false, loaded[n], "Could not load %s!", tiles[n].fileName.c_str());
+	}
+	return true;
+}
+
+/// Uploads a page of tiles to the given mipmap level of the texture page, and clears it for the next page.
+static void texUploadPage(int texPage, int level, int width, int height, std::vector<unsigned char> &pageData)
+{
+	if (wz_headless)
+	{
+		return;
+	}
+	pie_Texture(texPage).upload(level, 0, 0, width, height, gfx_api::pixel_format::rgba, pageData.data());
+	std::fill(pageData.begin(), pageData.end(), 0);
+}
+
 // Generate a new texture page both in the texture page table, and on the graphics card
 static int newPage(const char *name, int level, int width, int height, int count)
 {
@@ -80,11 +214,18 @@ static int newPage(const char *name, int level, int width, int height, int count
 	{
 		// We need to create a new texture page; create it and increase texture table to store it
 		pie_ReserveTexture(name, width, height);
-		pie_AssignTexture(texPage,
-			gfx_api::context::get().create_texture(width, height,
-				wz_texture_compression ? gfx_api::pixel_format::compressed_rgba : gfx_api::pixel_format::rgba));
+		if (!wz_headless)
+		{
+			pie_AssignTexture(texPage,
+				gfx_api::context::get().create_texture(width, height,
+					wz_texture_compression ? gfx_api::pixel_format::compressed_rgba : gfx_api::pixel_format::rgba));
+		}
 	}
 	terrainPage = texPage;
+	if (wz_headless)
+	{
+		return texPage;
+	}
 	pie_SetTexturePage(texPage);
 
 	// Specify first and last mipmap level to be used
@@ -131,7 +272,14 @@ bool texLoad(const char *fileName)
 	mipmap_max = MIPMAP_MAX;
 	mipmap_levels = MIPMAP_LEVELS;
 
-	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &glval);
+	if (wz_headless)
+	{
+		glval = mipmap_max * TILES_IN_PAGE_COLUMN;
+	}
+	else
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &glval);
+	}
 
 	while (glval < mipmap_max * TILES_IN_PAGE_COLUMN)
 	{
@@ -179,10 +327,71 @@ bool texLoad(const char *fileName)
 	while (k >= 3 && j + 6 < size);
 	free(buffer);
 
-	/* Now load the actual tiles */
+	/* Now find the actual tiles */
 
+	std::vector<TexTile> tiles;  // For every mipmap level, largest first.
+	unsigned numTiles[MIPMAP_LEVELS];
+	size_t dataSize = 0;
 	i = mipmap_max; // i is used to keep track of the tile dimensions
 	for (j = 0; j < mipmap_levels; j++)
+	{
+		for (k = 0; k < MAX_TILES; k++)
+		{
+			sprintf(fullPath, "%s-%d/tile-%02d.png", fileName, i, k);
+			if (!PHYSFS_exists(fullPath)) // avoid dire warning
+			{
+				// no more textures in this set
+				ASSERT_OR_RETURN(false, k > 0, "Could not find %s", fullPath);
+				break;
+			}
+			TexTile tile;
+			tile.fileName = fullPath;
+			tile.size = i;
+			tile.offset = dataSize;
+			tiles.push_back(tile);
+			dataSize += i * i * 4;
+		}
+		numTiles[j] = k;
+		i /= 2;
+	}
+
+	/* Decode them all at once, or load them from the cache if decoded before */
+
+	std::vector<unsigned char> tileData;
+	if (!wz_headless)
+	{
+		const char *baseName = strrchr(fileName, '/');
+		char cacheName[PATH_MAX];
+		ssprintf(cacheName, "cache/%s-%d.tiles", baseName != nullptr ? baseName + 1 : fileName, mipmap_max);
+
+		TexCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "WZTC", 4);
+		header.version = TEXCACHE_VERSION;
+		header.key = texCacheKey(tiles);
+		header.mipmapMax = mipmap_max;
+		header.mipmapLevels = mipmap_levels;
+		std::copy(numTiles, numTiles + mipmap_levels, header.numTiles);
+
+		tileData.resize(dataSize);
+		if (!textureCache || !texLoadCache(cacheName, header, tileData))
+		{
+			if (!texDecodeTiles(tiles, tileData))
+			{
+				return false;
+			}
+			if (textureCache)
+			{
+				texSaveCache(cacheName, header, tileData);
+			}
+		}
+	}
+
+	/* Then put them on texture pages, uploading a page at a time */
+
+	const TexTile *tile = tiles.data();
+	i = mipmap_max;
+	for (j = 0; j < mipmap_levels; j++)
 	{
 		int xOffset = 0, yOffset = 0; // offsets into the texture atlas
 		int xSize = 1;
@@ -196,36 +405,31 @@ bool texLoad(const char *fileName)
 
 		// Generate the empty texture buffer in VRAM
 		texPage = newPage(fileName, j, xSize, ySize, 0);
+		std::vector<unsigned char> pageData;
+		if (!wz_headless)
+		{
+			pageData.resize(xSize * ySize * 4);
+		}
 
 		sprintf(partialPath, "%s-%d", fileName, i);
 
-		// Load until we cannot find anymore of them
-		for (k = 0; k < MAX_TILES; k++)
+		for (k = 0; k < numTiles[j]; k++, tile++)
 		{
-			iV_Image tile;
-
-			sprintf(fullPath, "%s/tile-%02d.png", partialPath, k);
-			if (PHYSFS_exists(fullPath)) // avoid dire warning
+			if (!wz_headless)
 			{
-				bool retval = iV_loadImage_PNG(fullPath, &tile);
-				ASSERT_OR_RETURN(false, retval, "Could not load %s!", fullPath);
-			}
-			else
-			{
-				// no more textures in this set
-				ASSERT_OR_RETURN(false, k > 0, "Could not find %s", fullPath);
-				break;
+				// Insert into texture page
+				for (unsigned y = 0; y < i; ++y)
+				{
+					memcpy(&pageData[((yOffset + y) * xSize + xOffset) * 4], &tileData[tile->offset + y * i * 4], i * 4);
+				}
 			}
-			// Insert into texture page
-			pie_Texture(texPage).upload(j, xOffset, yOffset, tile.width, tile.height, gfx_api::pixel_format::rgba, tile.bmp);
-			free(tile.bmp);
 			if (i == mipmap_max) // dealing with main texture page; so register coordinates
 			{
 				tileTexInfo[k].uOffset = (float)xOffset / (float)xSize;
 				tileTexInfo[k].vOffset = (float)yOffset / (float)ySize;
 				tileTexInfo[k].texPage = texPage;
 				debug(LOG_TEXTURE, "  texLoad: Registering k=%d i=%d u=%f v=%f xoff=%d yoff=%d xsize=%d ysize=%d tex=%d (%s)",
-				      k, i, tileTexInfo[k].uOffset, tileTexInfo[k].vOffset, xOffset, yOffset, xSize, ySize, texPage, fullPath);
+				      k, i, tileTexInfo[k].uOffset, tileTexInfo[k].vOffset, xOffset, yOffset, xSize, ySize, texPage, tile->fileName.c_str());
 			}
 			xOffset += i; // i is width of tile
 			if (xOffset + i > xLimit)
@@ -236,6 +440,7 @@ bool texLoad(const char *fileName)
 			if (yOffset + i > yLimit)
 			{
 				/* Change to next texture page */
+				texUploadPage(texPage, j, xSize, ySize, pageData);
 				xOffset = 0;
 				yOffset = 0;
 				debug(LOG_TEXTURE, "texLoad: Extra page added at %d for %s, was page %d, opengl id %u",
@@ -243,6 +448,7 @@ bool texLoad(const char *fileName)
 				texPage = newPage(fileName, j, xSize, ySize, k);
 			}
 		}
+		texUploadPage(texPage, j, xSize, ySize, pageData);
 		debug(LOG_TEXTURE, "texLoad: Found %d textures for %s mipmap level %d, added to page %d, opengl id %u",
 		      k, partialPath, i, texPage, (unsigned)pie_Texture(texPage).id());
 		i /= 2;	// halve the dimensions for the next series; OpenGL mipmaps start with largest at level zero
@@ -44,5 +44,8 @@ extern int terrainPage;
 
 void setTextureSize(int texSize);
 int getTextureSize();
+/// Whether texLoad() keeps the decoded terrain tiles in the cache directory, so it can skip decoding them next time.
+void setTextureCache(bool enable);
+bool getTextureCache();
 
 #endif // __INCLUDED_SRC_TEXTURE_H__
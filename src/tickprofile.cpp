@@ -0,0 +1,183 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Timing of the phases of each game state update, see tickprofile.h.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/gamelib/gtime.h"
+
+#include "tickprofile.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define TICK_PROFILE_MAX_EVENTS (1 << 18)  ///< Size of the ring buffer. About 60 phases are recorded per tick.
+#define TICK_PROFILE_MAX_DEPTH  8
+
+static const char *tickPhaseNames[TICK_PHASE_COUNT] =
+{
+	"Tick",
+	"Network",
+	"Scripts",
+	"Abandoned structures",
+	"Grid",
+	"Visibility",
+	"Map",
+	"Path-finding",
+	"Commanders",
+	"Callbacks",
+	"Power",
+	"Droids",
+	"Mission droids",
+	"Structures",
+	"Mission structures",
+	"Mission timer",
+	"Projectiles",
+	"Features",
+	"User interface",
+	"Object memory",
+	"Counts",
+};
+
+struct TickProfileEvent
+{
+	uint64_t start;             ///< Microseconds since recording started.
+	uint32_t duration;          ///< Microseconds.
+	uint32_t gameTime;
+	uint32_t count;
+	uint8_t phase;
+	int8_t player;
+};
+
+struct TickProfileOpen
+{
+	std::chrono::steady_clock::time_point start;
+	TICK_PHASE phase;
+	int player;
+	uint32_t gameTime;          ///< Game time when the phase started, since gameTimeUpdateEnd() changes it.
+};
+
+static bool tickProfileOn = false;
+static std::vector<TickProfileEvent> tickProfileEvents;  ///< Ring buffer.
+static size_t tickProfileTotal = 0;                      ///< Number of events recorded, including those since overwritten.
+static std::chrono::steady_clock::time_point tickProfileStart;
+static TickProfileOpen tickProfileStack[TICK_PROFILE_MAX_DEPTH];
+static int tickProfileDepth = 0;
+
+void tickProfileEnable(bool enable)
+{
+	tickProfileOn = enable;
+	tickProfileEvents.clear();
+	tickProfileEvents.shrink_to_fit();
+	if (enable)
+	{
+		tickProfileEvents.resize(TICK_PROFILE_MAX_EVENTS);
+	}
+	tickProfileTotal = 0;
+	tickProfileDepth = 0;
+	tickProfileStart = std::chrono::steady_clock::now();
+}
+
+bool tickProfileEnabled()
+{
+	return tickProfileOn;
+}
+
+void tickProfileBegin(TICK_PHASE phase, int player)
+{
+	if (!tickProfileOn)
+	{
+		return;
+	}
+	ASSERT_OR_RETURN(, tickProfileDepth < TICK_PROFILE_MAX_DEPTH, "Phases nested too deeply");
+	TickProfileOpen &open = tickProfileStack[tickProfileDepth++];
+	open.phase = phase;
+	open.player = player;
+	open.gameTime = gameTime;
+	open.start = std::chrono::steady_clock::now();
+}
+
+void tickProfileEnd(TICK_PHASE phase, unsigned count)
+{
+	if (!tickProfileOn)
+	{
+		return;
+	}
+	auto end = std::chrono::steady_clock::now();
+	ASSERT_OR_RETURN(, tickProfileDepth > 0 && tickProfileStack[tickProfileDepth - 1].phase == phase, "Mismatched tickProfileBegin...End");
+	TickProfileOpen const &open = tickProfileStack[--tickProfileDepth];
+
+	TickProfileEvent &event = tickProfileEvents[tickProfileTotal++ % TICK_PROFILE_MAX_EVENTS];
+	event.start = std::chrono::duration_cast<std::chrono::microseconds>(open.start - tickProfileStart).count();
+	event.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - open.start).count();
+	event.gameTime = open.gameTime;
+	event.count = count;
+	event.phase = phase;
+	event.player = open.player;
+}
+
+bool tickProfileWriteTrace(const char *fileName)
+{
+	ASSERT_OR_RETURN(false, tickProfileOn, "Tick profiling not enabled");
+
+	size_t first = tickProfileTotal > TICK_PROFILE_MAX_EVENTS ? tickProfileTotal - TICK_PROFILE_MAX_EVENTS : 0;
+	uint64_t totals[TICK_PHASE_COUNT] = {0};
+	uint32_t maximums[TICK_PHASE_COUNT] = {0};
+	uint32_t worstTickTime = 0;
+
+	std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (size_t n = first; n < tickProfileTotal; ++n)
+	{
+		TickProfileEvent const &event = tickProfileEvents[n % TICK_PROFILE_MAX_EVENTS];
+		char line[256];
+		ssprintf(line, "{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%u,\"args\":{\"gameTime\":%u",
+		         tickPhaseNames[event.phase], (unsigned long long)event.start, event.duration, event.gameTime);
+		trace += line;
+		if (event.player >= 0)
+		{
+			ssprintf(line, ",\"player\":%d", event.player);
+			trace += line;
+		}
+		if (event.count > 0)
+		{
+			ssprintf(line, ",\"objects\":%u", event.count);
+			trace += line;
+		}
+		trace += n + 1 < tickProfileTotal ? "}},\n" : "}}\n";
+
+		totals[event.phase] += event.duration;
+		maximums[event.phase] = std::max(maximums[event.phase], event.duration);
+		if (event.phase == TICK_PHASE_TICK && event.duration >= maximums[TICK_PHASE_TICK])
+		{
+			worstTickTime = event.gameTime;
+		}
+	}
+	trace += "]}\n";
+
+	debug(LOG_INFO, "Tick profile of %u phases, slowest tick was at game time %u:", (unsigned)(tickProfileTotal - first), worstTickTime);
+	for (int phase = 0; phase < TICK_PHASE_COUNT; ++phase)
+	{
+		debug(LOG_INFO, "  %-22s total %8llu us, max %6u us", tickPhaseNames[phase], (unsigned long long)totals[phase], maximums[phase]);
+	}
+
+	return saveFile(fileName, trace.data(), trace.size());
+}
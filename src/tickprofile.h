@@ -0,0 +1,91 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2017  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Timing of the phases of each game state update.
+ *
+ *  When enabled, each phase of gameStateUpdate() is timed, and recorded in a ring buffer holding the most recent
+ *  phases. The buffer can be written out in the Chrome trace event format, which can be viewed with chrome://tracing
+ *  or similar tools. Only used from the main thread.
+ */
+
+#ifndef __INCLUDED_SRC_TICKPROFILE_H__
+#define __INCLUDED_SRC_TICKPROFILE_H__
+
+#include "lib/framework/types.h"
+
+enum TICK_PHASE
+{
+	TICK_PHASE_TICK,            ///< The whole of gameStateUpdate().
+	TICK_PHASE_NETWORK,
+	TICK_PHASE_SCRIPTS,
+	TICK_PHASE_ABANDONED,
+	TICK_PHASE_GRID,
+	TICK_PHASE_VISIBILITY,
+	TICK_PHASE_MAP,
+	TICK_PHASE_PATHFINDING,
+	TICK_PHASE_COMMANDERS,
+	TICK_PHASE_CALLBACKS,
+	TICK_PHASE_POWER,
+	TICK_PHASE_DROIDS,
+	TICK_PHASE_MISSION_DROIDS,
+	TICK_PHASE_STRUCTURES,
+	TICK_PHASE_MISSION_STRUCTURES,
+	TICK_PHASE_MISSION_TIMER,
+	TICK_PHASE_PROJECTILES,
+	TICK_PHASE_FEATURES,
+	TICK_PHASE_UI,
+	TICK_PHASE_OBJMEM,
+	TICK_PHASE_COUNTS,
+	TICK_PHASE_COUNT
+};
+
+/// Start or stop recording. Starting clears anything recorded before.
+void tickProfileEnable(bool enable);
+bool tickProfileEnabled();
+
+/// Writes the recorded phases to the given file in the write directory, in Chrome trace event format, and logs a summary.
+bool tickProfileWriteTrace(const char *fileName);
+
+/// Start timing a phase. Phases may be nested, but must end in the reverse order.
+/// The player is -1 if the phase is not for a single player.
+void tickProfileBegin(TICK_PHASE phase, int player = -1);
+/// Stop timing a phase. The count is the number of objects processed, if meaningful.
+void tickProfileEnd(TICK_PHASE phase, unsigned count = 0);
+
+/// Times the phase until the end of the scope.
+class TickProfileScope
+{
+public:
+	TickProfileScope(TICK_PHASE phase_, int player = -1) : phase(phase_), count(0)
+	{
+		tickProfileBegin(phase, player);
+	}
+	~TickProfileScope()
+	{
+		tickProfileEnd(phase, count);
+	}
+
+	TickProfileScope(TickProfileScope const &) = delete;
+	TickProfileScope &operator =(TickProfileScope const &) = delete;
+
+	TICK_PHASE phase;
+	unsigned count;             ///< Number of objects processed during the phase.
+};
+
+#endif // __INCLUDED_SRC_TICKPROFILE_H__
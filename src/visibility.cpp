@@ -22,8 +22,11 @@
  * Handles object visibility.
  * Pumpkin Studios, Eidos Interactive 1996.
  */
+#include <thread>
+
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
+#include "lib/framework/wzapp.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
@@ -47,6 +50,7 @@
 #include "multiplay.h"
 #include "qtscript.h"
 #include "wavecast.h"
+#include "droidhot.h"
 
 // rate to change visibility level
 static const int VIS_LEVEL_INC = 255 * 2;
@@ -76,6 +80,23 @@ public:
 };
 static std::vector<SPOTTER *> apsInvisibleViewers;
 
+/// Per-player state used while working out what the player's objects can see, possibly on another thread.
+struct VisibilityLane
+{
+	GridList gridList;                                              ///< Scratch space for gridQueryUnseen.
+	std::vector<std::pair<BASE_OBJECT *, BASE_OBJECT *>> seen;      ///< Viewer and object for each triggerEventSeen call, in order.
+};
+static VisibilityLane visLanes[MAX_PLAYERS];
+
+/// Players whose vision is processed together. Players sharing vision write to each other's seenThisTick, so must be in the same group.
+static std::vector<std::vector<unsigned>> visGroups;
+static unsigned         visNextGroup;               ///< Next group in visGroups for a thread to process.
+static std::vector<WZ_THREAD *> visThreads;
+static WZ_MUTEX         *visMutex = nullptr;
+static WZ_SEMAPHORE     *visStartSemaphore = nullptr;   ///< Posted once per thread to start processing visGroups.
+static WZ_SEMAPHORE     *visDoneSemaphore = nullptr;    ///< Posted by each thread when there are no more groups left.
+static bool             visQuit = false;
+
 // horrible hack because this code is full of them and I ain't rewriting it all - Per
 #define MAX_SEEN_TILES (29*29 * 355/113)  // Increased hack to support 28 tile sensor radius. - Cyp
 
@@ -84,15 +105,80 @@ static std::vector<SPOTTER *> apsInvisibleViewers;
 // forward declarations
 static void setSeenBy(BASE_OBJECT *psObj, unsigned viewer, int val);
 
+static void processVisibilityGroups();
+
+/** This runs in separate threads */
+static int visThreadFunc(void *)
+{
+	for (;;)
+	{
+		wzSemaphoreWait(visStartSemaphore);
+		if (visQuit)
+		{
+			break;
+		}
+		processVisibilityGroups();
+		wzSemaphorePost(visDoneSemaphore);
+	}
+	return 0;
+}
+
 // initialise the visibility stuff
 bool visInitialise()
 {
 	visLevelInc = 1;
 	visLevelDec = 0;
 
+	if (visThreads.empty())
+	{
+		int count = 0;
+#if !defined(WZ_CC_MINGW)
+		// The main thread also does some of the work. No point having more threads than players.
+		count = std::min<int>(std::thread::hardware_concurrency(), MAX_PLAYERS) - 1;
+#endif
+		if (count > 0)
+		{
+			visQuit = false;
+			visMutex = wzMutexCreate();
+			visStartSemaphore = wzSemaphoreCreate(0);
+			visDoneSemaphore = wzSemaphoreCreate(0);
+			for (int i = 0; i < count; ++i)
+			{
+				WZ_THREAD *thread = wzThreadCreate(visThreadFunc, nullptr);
+				visThreads.push_back(thread);
+				wzThreadStart(thread);
+			}
+			debug(LOG_INFO, "Started %d visibility threads", count);
+		}
+	}
+
 	return true;
 }
 
+// shutdown the visibility stuff
+void visShutdown()
+{
+	if (!visThreads.empty())
+	{
+		visQuit = true;
+		for (size_t i = 0; i < visThreads.size(); ++i)
+		{
+			wzSemaphorePost(visStartSemaphore);  // Wake up threads.
+		}
+		for (WZ_THREAD *thread : visThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		visThreads.clear();
+		wzMutexDestroy(visMutex);
+		visMutex = nullptr;
+		wzSemaphoreDestroy(visStartSemaphore);
+		visStartSemaphore = nullptr;
+		wzSemaphoreDestroy(visDoneSemaphore);
+		visDoneSemaphore = nullptr;
+	}
+}
+
 // update the visibility change levels
 void visUpdateLevel()
 {
@@ -183,7 +269,7 @@ static void updateSpotters()
 			continue;
 		}
 		// else, ie if not expired, show objects around it
-		gridList = gridStartIterateUnseen(world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player);
+		gridQueryUnseen(gridList, world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player);
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psObj = *gi;
@@ -612,6 +698,7 @@ static void processVisibilitySelf(BASE_OBJECT *psObj)
 }
 
 // Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
+// Only touches the seenThisTick of players sharing vision with the viewer, and the viewer's lane, so may run on any thread.
 static void processVisibilityVision(BASE_OBJECT *psViewer)
 {
 	if (psViewer->type == OBJ_FEATURE)
@@ -619,11 +706,12 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 		return;
 	}
 
+	VisibilityLane &lane = visLanes[psViewer->player];
+
 	// get all the objects from the grid the droid is in
 	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	gridQueryUnseen(lane.gridList, psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
+	for (GridIterator gi = lane.gridList.begin(); gi != lane.gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
 
@@ -635,8 +723,82 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 			// Tell system that this side can see this object
 			setSeenBy(psObj, psViewer->player, val);
 
-			// Check if scripting system wants to trigger an event for this
-			triggerEventSeen(psViewer, psObj);
+			// Check if scripting system wants to trigger an event for this, once all vision has been calculated
+			lane.seen.push_back(std::make_pair(psViewer, psObj));
+		}
+	}
+}
+
+// Process the vision of each player in the group, in order.
+static void processVisibilityGroup(std::vector<unsigned> const &group)
+{
+	for (unsigned player : group)
+	{
+		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
+		unsigned list;
+		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
+		{
+			for (BASE_OBJECT *psObj = lists[list]; psObj != nullptr; psObj = psObj->psNext)
+			{
+				processVisibilityVision(psObj);
+			}
+		}
+	}
+}
+
+// Process groups from visGroups until there are none left. Runs on the main thread and the visibility threads at the same time.
+static void processVisibilityGroups()
+{
+	for (;;)
+	{
+		wzMutexLock(visMutex);
+		unsigned group = visNextGroup++;
+		wzMutexUnlock(visMutex);
+		if (group >= visGroups.size())
+		{
+			break;
+		}
+		processVisibilityGroup(visGroups[group]);
+	}
+}
+
+// Split the players into groups, such that players sharing vision in either direction are in the same group.
+static void findVisibilityGroups()
+{
+	unsigned groupOf[MAX_PLAYERS];
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		groupOf[player] = player;
+	}
+	for (unsigned a = 0; a < MAX_PLAYERS; ++a)
+	{
+		for (unsigned b = a + 1; b < MAX_PLAYERS; ++b)
+		{
+			if (groupOf[a] != groupOf[b] && (hasSharedVision(a, b) || hasSharedVision(b, a)))
+			{
+				// Merge the group of b into the group of a.
+				unsigned from = groupOf[b], to = groupOf[a];
+				for (unsigned &group : groupOf)
+				{
+					group = group == from ? to : group;
+				}
+			}
+		}
+	}
+
+	visGroups.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		if (groupOf[player] == player)
+		{
+			visGroups.emplace_back();
+			for (unsigned member = player; member < MAX_PLAYERS; ++member)
+			{
+				if (groupOf[member] == player)
+				{
+					visGroups.back().push_back(member);
+				}
+			}
 		}
 	}
 }
@@ -722,9 +884,18 @@ static void processVisibilityLevel(BASE_OBJECT *psObj)
 void processVisibility()
 {
 	updateSpotters();
+	// Each droid only changes itself or raises the levels of others, so the droids can go in slot order instead of list order.
+	droidHotUpdate();
+	for (unsigned slot = 0; slot < droidHot.size(); ++slot)
+	{
+		if (droidHot.listed[slot])
+		{
+			processVisibilitySelf(droidHot.droid[slot]);
+		}
+	}
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
-		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
+		BASE_OBJECT *lists[] = {apsStructLists[player], apsFeatureLists[player]};
 		unsigned list;
 		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
 		{
@@ -734,18 +905,40 @@ void processVisibility()
 			}
 		}
 	}
-	for (int player = 0; player < MAX_PLAYERS; ++player)
+
+	// Groups of players not sharing vision don't affect each other, so can be processed in parallel.
+	// Each group is processed in player order, so the results don't depend on the number of threads.
+	findVisibilityGroups();
+	visNextGroup = 0;
+	if (visGroups.size() > 1 && !visThreads.empty())
 	{
-		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
-		unsigned list;
-		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
+		for (size_t i = 0; i < visThreads.size(); ++i)
 		{
-			for (BASE_OBJECT *psObj = lists[list]; psObj != nullptr; psObj = psObj->psNext)
-			{
-				processVisibilityVision(psObj);
-			}
+			wzSemaphorePost(visStartSemaphore);
+		}
+		processVisibilityGroups();
+		for (size_t i = 0; i < visThreads.size(); ++i)
+		{
+			wzSemaphoreWait(visDoneSemaphore);
+		}
+	}
+	else
+	{
+		for (auto const &group : visGroups)
+		{
+			processVisibilityGroup(group);
 		}
 	}
+
+	// Trigger the script events in the same order as if all vision had been processed in player order on one thread.
+	for (VisibilityLane &lane : visLanes)
+	{
+		for (auto const &seen : lane.seen)
+		{
+			triggerEventSeen(seen.first, seen.second);
+		}
+		lane.seen.clear();
+	}
 	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
 	{
 		if (objRadarDetector(psObj))
@@ -761,9 +954,18 @@ void processVisibility()
 			}
 		}
 	}
+	// The script events may have added or removed droids.
+	droidHotUpdate();
+	for (unsigned slot = 0; slot < droidHot.size(); ++slot)
+	{
+		if (droidHot.listed[slot])
+		{
+			processVisibilityLevel(droidHot.droid[slot]);
+		}
+	}
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
-		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
+		BASE_OBJECT *lists[] = {apsStructLists[player], apsFeatureLists[player]};
 		unsigned list;
 		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
 		{
@@ -41,6 +41,8 @@
 #include "multiint.h"
 #include "multilimit.h"
 #include "multistat.h"
+#include "clparse.h"
+#include "replay.h"
 #include "warzoneconfig.h"
 #include "wrappers.h"
 
@@ -159,6 +161,10 @@ TITLECODE titleLoop()
 			NETinit(true);
 			joinGame(iptoconnect, 0);
 		}
+		else if (!replay_file().empty() && replayLoadStart(replay_file()))
+		{
+			changeTitleMode(STARTGAME);
+		}
 		else
 		{
 			changeTitleMode(TITLE);			// normal game, run main title screen.
@@ -291,7 +297,7 @@ void loadingScreenCallback()
 	const uint32_t currTick = wzGetTicks();
 	unsigned int i;
 
-	if (currTick - lastTick < 50)
+	if (wz_headless || currTick - lastTick < 50)
 	{
 		return;
 	}
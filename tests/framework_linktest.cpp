@@ -1,6 +1,9 @@
 #include "lib/framework/wzglobal.h"
 #include "lib/framework/types.h"
 #include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+
+#include <stdlib.h>
 
 // --- dummy rendering library implementation ----
 
@@ -26,6 +29,62 @@ void inputInitialise()
 {
 }
 
+// Only needed by the resource loader's worker threads, which this test doesn't start.
+WZ_THREAD *wzThreadCreate(int (*)(void *), void *)
+{
+	abort();
+}
+
+int wzThreadJoin(WZ_THREAD *)
+{
+	abort();
+}
+
+void wzThreadStart(WZ_THREAD *)
+{
+	abort();
+}
+
+WZ_MUTEX *wzMutexCreate()
+{
+	abort();
+}
+
+void wzMutexDestroy(WZ_MUTEX *)
+{
+	abort();
+}
+
+void wzMutexLock(WZ_MUTEX *)
+{
+	abort();
+}
+
+void wzMutexUnlock(WZ_MUTEX *)
+{
+	abort();
+}
+
+WZ_SEMAPHORE *wzSemaphoreCreate(int)
+{
+	abort();
+}
+
+void wzSemaphoreDestroy(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
+void wzSemaphoreWait(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
+void wzSemaphorePost(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
 // --- end linking hacks ---
 
 int main(void)
@@ -0,0 +1,368 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netqueue.h"
+#include "lib/netplay/netlog.h"
+#include "lib/netplay/netreplay.h"
+#include "src/droidinfo.h"
+
+#include <stdio.h>
+#include <zlib.h>
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+// --- dummy network library implementation, for nettypes.cpp ----
+
+bool NETisReplay()
+{
+	return false;
+}
+
+void NETlogPacket(uint8_t, uint32_t, bool)
+{
+}
+
+const char *messageTypeToString(unsigned)
+{
+	return "";
+}
+
+bool NETsend(NETQUEUE, NetMessage const *)
+{
+	return true;
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "netcompresstest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+#define NUM_PLAYERS 4
+#define NUM_TICKS 6000  // Ten minutes.
+
+static void appendUint32(std::vector<uint8_t> &data, uint32_t v)
+{
+	bool moreBytes = true;
+	for (unsigned n = 0; moreBytes; ++n)
+	{
+		uint8_t b;
+		moreBytes = encode_uint32_t(b, v, n);
+		data.push_back(b);
+	}
+}
+
+static void appendInt32(std::vector<uint8_t> &data, int32_t v)
+{
+	appendUint32(data, (uint32_t)v << 1 ^ (-((uint32_t)v >> 31)));
+}
+
+static void appendUint16(std::vector<uint8_t> &data, uint16_t v)
+{
+	data.push_back(v >> 8);
+	data.push_back(v);
+}
+
+static void appendRaw(std::vector<uint8_t> &stream, NetMessage const &message)
+{
+	uint8_t header[NET_MESSAGE_MAX_HEADER];
+	size_t headerLen = message.rawHeader(header);
+	stream.insert(stream.end(), header, header + headerLen);
+	stream.insert(stream.end(), message.data.begin(), message.data.end());
+}
+
+/// Wraps a game message, the way the host broadcasts it.
+static void appendShared(std::vector<uint8_t> &stream, uint8_t player, NetMessage const &message)
+{
+	NetMessage share(NET_SHARE_GAME_QUEUE);
+	share.data.push_back(player);
+	appendUint32(share.data, 1);
+	appendRaw(share.data, message);
+	appendRaw(stream, share);
+}
+
+/// What the host sends to a client each tick, with the game messages encoded the old way, or with deltas.
+static std::vector<std::vector<uint8_t>> simulateTraffic(bool delta)
+{
+	std::vector<std::vector<uint8_t>> ticks(NUM_TICKS);
+	uint32_t lastCheckTime[NUM_PLAYERS] = {0};
+	int32_t lastX[NUM_PLAYERS] = {0}, lastY[NUM_PLAYERS] = {0};
+	uint32_t lastDroidId[NUM_PLAYERS] = {0};
+	uint32_t seed = 12345;
+	auto random = [&seed](uint32_t n) { seed = seed * 1103515245 + 12345; return (seed >> 16) % n; };
+
+	for (unsigned tick = 0; tick < NUM_TICKS; ++tick)
+	{
+		uint32_t gameTime = 5000 + tick * GAME_TICKS_PER_UPDATE;
+		for (uint8_t player = 0; player < NUM_PLAYERS; ++player)
+		{
+			// Someone gives an order now and then, to droids and places near the last ones.
+			if (random(8) == 0)
+			{
+				NetMessage message(GAME_DROIDINFO);
+				int32_t x = 2000 + 128 * player + random(2048), y = 2000 + random(2048);
+				uint32_t droidId = 10000 + player * 1000 + random(64);
+				message.data.push_back(player);
+				appendUint32(message.data, 1);  // LocOrder.
+				appendUint32(message.data, 2);  // DORDER_MOVE.
+				appendInt32(message.data, delta ? x - lastX[player] : x);
+				appendInt32(message.data, delta ? y - lastY[player] : y);
+				message.data.push_back(0);  // add.
+				appendUint32(message.data, 1);
+				appendInt32(message.data, delta ? droidId - lastDroidId[player] : droidId);
+				appendShared(ticks[tick], player, message);
+				lastX[player] = x;
+				lastY[player] = y;
+				lastDroidId[player] = droidId;
+			}
+
+			NetMessage message(GAME_GAME_TIME);
+			appendUint32(message.data, 2);
+			if (delta)
+			{
+				appendInt32(message.data, gameTime - lastCheckTime[player]);
+			}
+			else
+			{
+				appendUint32(message.data, gameTime);
+			}
+			appendUint16(message.data, random(65536));  // checkCrc.
+			appendUint16(message.data, GAME_TICKS_PER_UPDATE * 2 + random(3) * 10);
+			appendShared(ticks[tick], player, message);
+			lastCheckTime[player] = gameTime;
+		}
+	}
+	return ticks;
+}
+
+/// Compresses the data like a socket does, flushing after each tick. Returns the compressed size, and checks it decompresses back.
+static size_t compress(std::vector<std::vector<uint8_t>> const &ticks)
+{
+	z_stream zDeflate, zInflate;
+	memset(&zDeflate, 0, sizeof(zDeflate));
+	memset(&zInflate, 0, sizeof(zInflate));
+	CHECK(deflateInit(&zDeflate, 6) == Z_OK);
+	CHECK(inflateInit(&zInflate) == Z_OK);
+
+	size_t total = 0;
+	std::vector<uint8_t> compressed, decompressed;
+	for (std::vector<uint8_t> const &tick : ticks)
+	{
+		compressed.resize(deflateBound(&zDeflate, tick.size()) + 64);
+		zDeflate.next_in = const_cast<uint8_t *>(tick.data());
+		zDeflate.avail_in = tick.size();
+		zDeflate.next_out = compressed.data();
+		zDeflate.avail_out = compressed.size();
+		CHECK(deflate(&zDeflate, Z_PARTIAL_FLUSH) == Z_OK);
+		compressed.resize(compressed.size() - zDeflate.avail_out);
+		total += compressed.size();
+
+		decompressed.resize(tick.size() + 1);
+		zInflate.next_in = compressed.data();
+		zInflate.avail_in = compressed.size();
+		zInflate.next_out = decompressed.data();
+		zInflate.avail_out = decompressed.size();
+		CHECK(inflate(&zInflate, Z_NO_FLUSH) == Z_OK);
+		decompressed.resize(decompressed.size() - zInflate.avail_out);
+		CHECK(decompressed == tick);
+	}
+	deflateEnd(&zDeflate);
+	inflateEnd(&zInflate);
+	return total;
+}
+
+/// An order of each kind NETQueuedDroidInfo() handles, near the previous one, the way a player clicks around.
+static QueuedDroidInfo makeOrder(unsigned player, unsigned n)
+{
+	QueuedDroidInfo info = QueuedDroidInfo();
+	info.player = player;
+	info.droidId = 10000 + n % 7;
+	switch (n % 5)
+	{
+	case 0:
+		info.subType = LocOrder;
+		info.order = DORDER_MOVE;
+		info.pos = Vector2i(3000 + n * 37 % 512, 5000 - n * 53 % 512);
+		info.add = n % 2 != 0;
+		break;
+	case 1:
+		info.subType = ObjOrder;
+		info.order = DORDER_ATTACK;
+		info.destId = 20000 + n % 11;
+		info.destType = OBJ_STRUCTURE;
+		break;
+	case 2:
+		info.subType = LocOrder;
+		info.order = DORDER_LINEBUILD;
+		info.pos = Vector2i(3000 + n * 128, 5000);
+		info.pos2 = Vector2i(3000 + n * 128, 5000 + 1024);
+		info.structRef = 0x50000 + n % 3;
+		info.direction = 0x4000;
+		break;
+	case 3:
+		info.subType = LocOrder;
+		info.order = DORDER_BUILDMODULE;
+		info.pos = Vector2i(2944, 4992);
+		info.index = n % 3;
+		break;
+	case 4:
+		info.subType = SecondaryOrder;
+		info.secOrder = DSO_ATTACK_LEVEL;
+		info.secState = DSS_ALEV_ATTACKED;
+		break;
+	}
+	return info;
+}
+
+/// Encodes a GAME_DROIDINFO for one droid into the player's game queue, like sendQueuedDroidInfo().
+static void sendOrder(QueuedDroidInfo info)
+{
+	NETbeginEncode(NETgameQueue(info.player), GAME_DROIDINFO);
+	NETQueuedDroidInfo(&info);
+	uint32_t num = 1;
+	NETuint32_t(&num);
+	NETdeltaUint32(&info.droidId, DROIDINFO_FIRST_DROID_ID);
+	NETend();
+}
+
+/// Decodes the next GAME_DROIDINFO in the player's game queue, like recvDroidInfo().
+static QueuedDroidInfo receiveOrder(unsigned player)
+{
+	QueuedDroidInfo info = QueuedDroidInfo();
+	NETbeginDecode(NETgameQueue(player), GAME_DROIDINFO);
+	NETQueuedDroidInfo(&info);
+	uint32_t num = 0;
+	NETuint32_t(&num);
+	CHECK(num == 1);
+	NETdeltaUint32(&info.droidId, DROIDINFO_FIRST_DROID_ID);
+	CHECK(NETend());
+	NETpop(NETgameQueue(player));
+	return info;
+}
+
+/// Checks that orders come out of NETQueuedDroidInfo() as they went in, with and without delta encoding. Returns the bytes sent.
+static size_t testRoundTrip(bool delta)
+{
+	NETsetDeltaEncoding(delta);
+	NETinitQueue(NETgameQueue(1));
+
+	size_t bytes = 0;
+	for (unsigned n = 0; n < 200; ++n)
+	{
+		QueuedDroidInfo sent = makeOrder(1, n);
+		sendOrder(sent);
+		bytes += NETgetMessage(NETgameQueue(1))->data.size();
+		QueuedDroidInfo received = receiveOrder(1);
+		CHECK(received.orderCompare(sent) == 0);
+		CHECK(received.droidId == sent.droidId);
+	}
+
+	// Messages which are decoded some time after being encoded, as our own messages are.
+	for (unsigned n = 0; n < 20; ++n)
+	{
+		sendOrder(makeOrder(1, n));
+		NETbeginEncode(NETgameQueue(1), GAME_GAME_TIME);
+		uint32_t checkTime = 1000 + n * GAME_TICKS_PER_UPDATE;
+		NETdeltaUint32(&checkTime, 0);
+		NETend();
+	}
+	for (unsigned n = 0; n < 20; ++n)
+	{
+		CHECK(receiveOrder(1).orderCompare(makeOrder(1, n)) == 0);
+		NETbeginDecode(NETgameQueue(1), GAME_GAME_TIME);
+		uint32_t checkTime = 0;
+		NETdeltaUint32(&checkTime, 0);
+		CHECK(NETend());
+		NETpop(NETgameQueue(1));
+		CHECK(checkTime == 1000 + n * GAME_TICKS_PER_UPDATE);
+	}
+	return bytes;
+}
+
+/// Checks that GAME_PLAYER_LEFT resets the deltas, so that whoever sends the next messages in that game queue doesn't need to know the previous ones.
+static void testPlayerLeft()
+{
+	NETsetDeltaEncoding(true);
+	NETinitQueue(NETgameQueue(2));
+
+	// What the host would send for the player who left, starting from nothing.
+	sendOrder(makeOrder(2, 7));
+	NetMessage fresh = *NETgetMessage(NETgameQueue(2));
+	CHECK(receiveOrder(2).orderCompare(makeOrder(2, 7)) == 0);
+
+	NETinitQueue(NETgameQueue(2));
+	for (unsigned n = 0; n < 5; ++n)
+	{
+		sendOrder(makeOrder(2, n));
+	}
+	NETbeginEncode(NETgameQueue(2), GAME_PLAYER_LEFT);
+	uint32_t leftPlayer = 2;
+	NETuint32_t(&leftPlayer);
+	NETend();
+	sendOrder(makeOrder(2, 7));
+
+	for (unsigned n = 0; n < 5; ++n)
+	{
+		CHECK(receiveOrder(2).orderCompare(makeOrder(2, n)) == 0);
+	}
+	NETbeginDecode(NETgameQueue(2), GAME_PLAYER_LEFT);
+	NETuint32_t(&leftPlayer);
+	CHECK(NETend());
+	NETpop(NETgameQueue(2));
+
+	NetMessage const &afterLeft = *NETgetMessage(NETgameQueue(2));
+	CHECK(afterLeft.data == fresh.data);
+	QueuedDroidInfo received = receiveOrder(2);
+	CHECK(received.orderCompare(makeOrder(2, 7)) == 0);
+	CHECK(received.droidId == makeOrder(2, 7).droidId);
+}
+
+/// The bytes sent per tick by the host to each client, in a simulated game.
+static void benchmark()
+{
+	std::vector<std::vector<uint8_t>> absolute = simulateTraffic(false);
+	std::vector<std::vector<uint8_t>> delta = simulateTraffic(true);
+	size_t rawAbsolute = 0, rawDelta = 0;
+	for (unsigned tick = 0; tick < NUM_TICKS; ++tick)
+	{
+		rawAbsolute += absolute[tick].size();
+		rawDelta += delta[tick].size();
+	}
+
+	size_t oldBytes = compress(absolute);
+	size_t deltaBytes = compress(delta);
+	CHECK(deltaBytes < oldBytes);
+
+	printf("netcompresstest: %u players, %u ticks\n", NUM_PLAYERS, NUM_TICKS);
+	printf("netcompresstest: absolute:              %.1f bytes/tick uncompressed, %.1f bytes/tick compressed\n", rawAbsolute / double(NUM_TICKS), oldBytes / double(NUM_TICKS));
+	printf("netcompresstest: delta:                 %.1f bytes/tick uncompressed, %.1f bytes/tick compressed\n", rawDelta / double(NUM_TICKS), deltaBytes / double(NUM_TICKS));
+}
+
+int main(void)
+{
+	size_t plainBytes = testRoundTrip(false);
+	size_t deltaBytes = testRoundTrip(true);
+	CHECK(deltaBytes < plainBytes);
+	printf("netcompresstest: 200 GAME_DROIDINFO messages, %u bytes plain, %u bytes delta-encoded\n", (unsigned)plainBytes, (unsigned)deltaBytes);
+	testPlayerLeft();
+	NETdeleteQueue();
+
+	benchmark();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netqueue.h"
+#include "lib/netplay/netreplay.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+// --- dummy network library implementation, for nettypes.cpp ----
+
+void NETlogPacket(uint8_t, uint32_t, bool)
+{
+}
+
+const char *messageTypeToString(unsigned)
+{
+	return "";
+}
+
+bool NETsend(NETQUEUE, NetMessage const *)
+{
+	return true;
+}
+
+// --- end linking hacks ---
+
+// Trains a preset dictionary for the compressed sockets on recorded replays, and measures what it saves on other
+// replays. The replays aren't shipped, so this is built by make check but only run by hand:
+//   netdictionarytest training.wzrp... -- test.wzrp...
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "netdictionarytest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+#define DICTIONARY_SIZE 32768   // The size of the deflate window, anything further back can't be referenced.
+#define DICTIONARY_WINDOW 8     // Length of the byte sequences counted when training.
+#define EARLY_TICKS 100         // Ten seconds, before the stream has much history of its own to refer back to.
+
+typedef std::vector<std::vector<uint8_t>> Ticks;
+
+static void appendUint32(std::vector<uint8_t> &data, uint32_t v)
+{
+	bool moreBytes = true;
+	for (unsigned n = 0; moreBytes; ++n)
+	{
+		uint8_t b;
+		moreBytes = encode_uint32_t(b, v, n);
+		data.push_back(b);
+	}
+}
+
+static void appendRaw(std::vector<uint8_t> &stream, NetMessage const &message)
+{
+	uint8_t header[NET_MESSAGE_MAX_HEADER];
+	size_t headerLen = message.rawHeader(header);
+	stream.insert(stream.end(), header, header + headerLen);
+	stream.insert(stream.end(), message.data.begin(), message.data.end());
+}
+
+/// Reads a replay with NETreplayLoadNetMessages(), and rebuilds what the host sends a client each tick: for each
+/// player, a NET_SHARE_GAME_QUEUE with that player's game messages up to and including their next GAME_GAME_TIME.
+static bool loadReplay(char const *path, Ticks &ticks)
+{
+	char *fullPath = realpath(path, nullptr);
+	if (fullPath == nullptr)
+	{
+		fprintf(stderr, "netdictionarytest: Can't find %s\n", path);
+		return false;
+	}
+	char *slash = strrchr(fullPath, '/');
+	*slash = '\0';
+	std::string dir = slash == fullPath ? "/" : fullPath;
+	std::string name = slash + 1;
+	free(fullPath);
+
+	PHYSFS_addToSearchPath(dir.c_str(), PHYSFS_PREPEND);
+	std::string settings;
+	bool loaded = NETreplayLoadStart(name, settings);
+	PHYSFS_removeFromSearchPath(dir.c_str());
+	if (!loaded)
+	{
+		return false;
+	}
+
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		NETinitQueue(NETgameQueue(player));
+		NETsetNoSendOverNetwork(NETgameQueue(player));
+	}
+	// Nobody is player MAX_PLAYERS, so this moves every recorded message into the game queues.
+	NETreplayLoadNetMessages(MAX_PLAYERS);
+	NETreplayLoadStop();
+
+	ticks.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		NETQUEUE queue = NETgameQueue(player);
+		unsigned tick = 0;
+		std::vector<uint8_t> messages;
+		uint32_t count = 0;
+		for (; NETisMessageReady(queue); NETpop(queue))
+		{
+			NetMessage const &message = *NETgetMessage(queue);
+			appendRaw(messages, message);
+			++count;
+			if (message.type != GAME_GAME_TIME)
+			{
+				continue;
+			}
+			NetMessage share(NET_SHARE_GAME_QUEUE);
+			share.data.push_back(player);
+			appendUint32(share.data, count);
+			share.data.insert(share.data.end(), messages.begin(), messages.end());
+			ticks.resize(std::max<size_t>(ticks.size(), tick + 1));
+			appendRaw(ticks[tick], share);
+			messages.clear();
+			count = 0;
+			++tick;
+		}
+	}
+	return !ticks.empty();
+}
+
+/// Picks the byte sequences repeated most often in the training ticks, with the most common last, where deflate
+/// finds them with the shortest distances.
+static std::vector<uint8_t> trainDictionary(std::vector<Ticks> const &replays)
+{
+	std::unordered_map<uint64_t, unsigned> counts;
+	for (Ticks const &ticks : replays)
+	{
+		for (std::vector<uint8_t> const &tick : ticks)
+		{
+			for (size_t i = 0; i + DICTIONARY_WINDOW <= tick.size(); ++i)
+			{
+				uint64_t window;
+				memcpy(&window, &tick[i], DICTIONARY_WINDOW);
+				++counts[window];
+			}
+		}
+	}
+
+	std::vector<std::pair<unsigned, uint64_t>> common;
+	for (auto const &count : counts)
+	{
+		if (count.second > 1)
+		{
+			common.emplace_back(count.second, count.first);
+		}
+	}
+	std::sort(common.begin(), common.end(), std::greater<std::pair<unsigned, uint64_t>>());
+	common.resize(std::min<size_t>(common.size(), DICTIONARY_SIZE / DICTIONARY_WINDOW));
+
+	std::vector<uint8_t> dictionary(common.size() * DICTIONARY_WINDOW);
+	for (size_t i = 0; i < common.size(); ++i)
+	{
+		memcpy(&dictionary[dictionary.size() - (i + 1) * DICTIONARY_WINDOW], &common[i].second, DICTIONARY_WINDOW);
+	}
+	return dictionary;
+}
+
+/// Compresses the ticks like a socket does, flushing after each tick, and checks they decompress back. Returns the
+/// compressed size, and the compressed size of the first EARLY_TICKS ticks in early.
+static size_t compress(Ticks const &ticks, std::vector<uint8_t> const &dictionary, size_t &early)
+{
+	z_stream zDeflate, zInflate;
+	memset(&zDeflate, 0, sizeof(zDeflate));
+	memset(&zInflate, 0, sizeof(zInflate));
+	CHECK(deflateInit(&zDeflate, 6) == Z_OK);
+	CHECK(inflateInit(&zInflate) == Z_OK);
+	if (!dictionary.empty())
+	{
+		CHECK(deflateSetDictionary(&zDeflate, dictionary.data(), dictionary.size()) == Z_OK);
+	}
+
+	size_t total = 0;
+	early = 0;
+	std::vector<uint8_t> compressed, decompressed;
+	for (size_t tick = 0; tick < ticks.size(); ++tick)
+	{
+		compressed.resize(deflateBound(&zDeflate, ticks[tick].size()) + 64);
+		zDeflate.next_in = const_cast<uint8_t *>(ticks[tick].data());
+		zDeflate.avail_in = ticks[tick].size();
+		zDeflate.next_out = compressed.data();
+		zDeflate.avail_out = compressed.size();
+		CHECK(deflate(&zDeflate, Z_PARTIAL_FLUSH) == Z_OK);
+		compressed.resize(compressed.size() - zDeflate.avail_out);
+		total += compressed.size();
+		early += tick < EARLY_TICKS ? compressed.size() : 0;
+
+		decompressed.resize(ticks[tick].size() + 1);
+		zInflate.next_in = compressed.data();
+		zInflate.avail_in = compressed.size();
+		zInflate.next_out = decompressed.data();
+		zInflate.avail_out = decompressed.size();
+		int ret = inflate(&zInflate, Z_NO_FLUSH);
+		if (ret == Z_NEED_DICT)
+		{
+			CHECK(inflateSetDictionary(&zInflate, dictionary.data(), dictionary.size()) == Z_OK);
+			ret = inflate(&zInflate, Z_NO_FLUSH);
+		}
+		CHECK(ret == Z_OK);
+		decompressed.resize(decompressed.size() - zInflate.avail_out);
+		CHECK(decompressed == ticks[tick]);
+	}
+	deflateEnd(&zDeflate);
+	inflateEnd(&zInflate);
+	return total;
+}
+
+int main(int argc, char **argv)
+{
+	int split = 1;
+	while (split < argc && strcmp(argv[split], "--") != 0)
+	{
+		++split;
+	}
+	if (split == 1 || split >= argc - 1)
+	{
+		fprintf(stderr, "Usage: %s training.wzrp... -- test.wzrp...\n", argv[0]);
+		return 1;
+	}
+	PHYSFS_init(argv[0]);
+
+	std::vector<Ticks> training;
+	for (int arg = 1; arg < split; ++arg)
+	{
+		training.emplace_back();
+		if (!loadReplay(argv[arg], training.back()))
+		{
+			fprintf(stderr, "netdictionarytest: Couldn't load %s\n", argv[arg]);
+			training.pop_back();
+		}
+	}
+	std::vector<uint8_t> dictionary = trainDictionary(training);
+	printf("netdictionarytest: %u byte dictionary, from %u replays\n", (unsigned)dictionary.size(), (unsigned)training.size());
+
+	size_t totalTicks = 0, totalPlain = 0, totalDictionary = 0, totalEarlyPlain = 0, totalEarlyDictionary = 0;
+	for (int arg = split + 1; arg < argc; ++arg)
+	{
+		Ticks ticks;
+		if (!loadReplay(argv[arg], ticks))
+		{
+			fprintf(stderr, "netdictionarytest: Couldn't load %s\n", argv[arg]);
+			continue;
+		}
+		size_t earlyPlain, earlyDictionary;
+		size_t plain = compress(ticks, std::vector<uint8_t>(), earlyPlain);
+		size_t withDictionary = compress(ticks, dictionary, earlyDictionary);
+		printf("netdictionarytest: %s: %u ticks, %.1f bytes/tick compressed, %.1f bytes/tick with the dictionary, %d bytes saved in the first %u ticks\n",
+		       argv[arg], (unsigned)ticks.size(), plain / double(ticks.size()), withDictionary / double(ticks.size()), int(earlyPlain - earlyDictionary), EARLY_TICKS);
+		totalTicks += ticks.size();
+		totalPlain += plain;
+		totalDictionary += withDictionary;
+		totalEarlyPlain += earlyPlain;
+		totalEarlyDictionary += earlyDictionary;
+	}
+	if (totalTicks > 0)
+	{
+		printf("netdictionarytest: all: %.2f%% saved by the dictionary, %.2f%% in the first %u ticks\n",
+		       100.0 * (1 - totalDictionary / double(totalPlain)), 100.0 * (1 - totalEarlyDictionary / double(totalEarlyPlain)), EARLY_TICKS);
+	}
+
+	NETdeleteQueue();
+	PHYSFS_deinit();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,621 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netsocket.h"
+
+#include "src/console.h"       // HACK
+#include "src/component.h"     // HACK
+#include "src/modding.h"       // HACK
+#include "src/multijoin.h"     // HACK
+#include "src/multiint.h"      // HACK
+#include "src/multiplay.h"     // HACK
+#include "src/multistat.h"     // HACK
+#include "src/version.h"       // HACK
+#include "src/warzoneconfig.h" // HACK
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <arpa/inet.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// --- dummy backend implementation, threads for the socket thread ---
+
+struct WZ_THREAD
+{
+	int (*function)(void *);
+	void *data;
+	int result;
+	std::thread thread;
+};
+
+struct WZ_MUTEX
+{
+	std::mutex mutex;
+};
+
+struct WZ_SEMAPHORE
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	int count;
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data)
+{
+	WZ_THREAD *thread = new WZ_THREAD;
+	thread->function = threadFunc;
+	thread->data = data;
+	thread->result = 0;
+	return thread;
+}
+
+void wzThreadStart(WZ_THREAD *thread)
+{
+	thread->thread = std::thread([thread]() { thread->result = thread->function(thread->data); });
+}
+
+int wzThreadJoin(WZ_THREAD *thread)
+{
+	thread->thread.join();
+	int result = thread->result;
+	delete thread;
+	return result;
+}
+
+void wzThreadDetach(WZ_THREAD *thread)
+{
+	thread->thread.detach();
+}
+
+void wzYieldCurrentThread()
+{
+	std::this_thread::yield();
+}
+
+WZ_MUTEX *wzMutexCreate()
+{
+	return new WZ_MUTEX;
+}
+
+void wzMutexDestroy(WZ_MUTEX *mutex)
+{
+	delete mutex;
+}
+
+void wzMutexLock(WZ_MUTEX *mutex)
+{
+	mutex->mutex.lock();
+}
+
+void wzMutexUnlock(WZ_MUTEX *mutex)
+{
+	mutex->mutex.unlock();
+}
+
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue)
+{
+	WZ_SEMAPHORE *semaphore = new WZ_SEMAPHORE;
+	semaphore->count = startValue;
+	return semaphore;
+}
+
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore)
+{
+	delete semaphore;
+}
+
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore)
+{
+	std::unique_lock<std::mutex> lock(semaphore->mutex);
+	semaphore->condition.wait(lock, [semaphore]() { return semaphore->count > 0; });
+	--semaphore->count;
+}
+
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore)
+{
+	std::lock_guard<std::mutex> lock(semaphore->mutex);
+	++semaphore->count;
+	semaphore->condition.notify_one();
+}
+
+int wzGetTicks()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void wzDelay(unsigned int delay)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+}
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+// --- game dummy implementations ---
+
+MULTIPLAYERGAME game;
+MULTIPLAYERINGAME ingame;
+UDWORD gameTime;
+UDWORD realTime;
+
+bool addConsoleMessage(const char *, CONSOLE_TEXT_JUSTIFICATION, SDWORD, bool)
+{
+	return true;
+}
+
+bool MultiPlayerJoin(UDWORD)
+{
+	return true;
+}
+
+bool MultiPlayerLeave(UDWORD)
+{
+	return true;
+}
+
+void ShowMOTD()
+{
+}
+
+bool changeColour(unsigned, int, bool)
+{
+	return true;
+}
+
+bool setPlayerColour(UDWORD, UDWORD)
+{
+	return true;
+}
+
+LOBBY_ERROR_TYPES getLobbyError()
+{
+	return ERROR_NOERROR;
+}
+
+void setLobbyError(LOBBY_ERROR_TYPES)
+{
+}
+
+void kickPlayer(uint32_t, const char *, LOBBY_ERROR_TYPES)
+{
+}
+
+bool sendTextMessage(const char *, bool, uint32_t)
+{
+	return true;
+}
+
+void printConsoleNameChange(const char *, const char *)
+{
+}
+
+void recvMultiStats(NETQUEUE)
+{
+}
+
+bool responsibleFor(int player, int playerinquestion)
+{
+	return player == playerinquestion;
+}
+
+const char *version_getVersionString()
+{
+	return "netplaytest";
+}
+
+int war_getMPcolour()
+{
+	return -1;
+}
+
+std::string const &getModList()
+{
+	static std::string modList;
+	return modList;
+}
+
+/// There are no GAME_GAME_TIME messages, so deliver game messages as soon as they arrive.
+bool checkPlayerGameTime(unsigned player)
+{
+	return !NETisMessageReady(NETgameQueue(player));
+}
+
+void recvPlayerGameTime(NETQUEUE)
+{
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "netplaytest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+#define NUM_CLIENTS 3
+#define NUM_TICKS 300
+#define TICK_MILLISECONDS 10
+#define MESSAGES_PER_TICK 4
+#define PAYLOAD_SIZE 24
+#define TIMEOUT_MILLISECONDS 20000
+
+/// The synthetic game message, with the type of a real one so that it goes through the game queues the same way.
+#define TEST_MESSAGE GAME_SYNC_REQUEST
+enum TestMessageKind
+{
+	TEST_START,    ///< Sent by the host when everyone has joined.
+	TEST_TRAFFIC,
+	TEST_DONE,     ///< Sent after the last TEST_TRAFFIC.
+};
+
+/// What each peer measured, sent to the host process through a pipe, followed by the delays.
+struct PeerResults
+{
+	uint32_t player;
+	uint32_t sent;                 ///< TEST_TRAFFIC messages sent.
+	uint32_t received;             ///< TEST_TRAFFIC messages received from the others.
+	uint32_t rawBytesSent;         ///< Bytes on the wire, from nStats.
+	uint32_t uncompressedBytesSent;
+	uint32_t rawBytesReceived;
+	uint32_t milliseconds;         ///< From TEST_START until getting everyone's TEST_DONE.
+	uint32_t numDelays;
+	bool ok;
+};
+
+static uint64_t nowMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Handles the messages the game would handle in the lobby, which here means dropping them, and sends what was queued.
+static void pumpNet()
+{
+	NETQUEUE queue;
+	uint8_t type;
+	while (NETrecvNet(&queue, &type))
+	{
+		NETpop(queue);
+	}
+	NETflush();
+}
+
+/// Returns the kinds of game messages received, and records the one-way delay of the TEST_TRAFFIC ones.
+static void receiveGame(PeerResults &results, std::vector<uint32_t> &delays, bool started[MAX_PLAYERS], bool done[MAX_PLAYERS])
+{
+	NETQUEUE queue;
+	uint8_t type;
+	while (NETrecvGame(&queue, &type))
+	{
+		if (type == TEST_MESSAGE && queue.index != selectedPlayer)
+		{
+			uint8_t kind = 0;
+			uint32_t sequence = 0;
+			uint64_t sentTime = 0;
+			uint8_t payload[PAYLOAD_SIZE];
+			NETbeginDecode(queue, TEST_MESSAGE);
+			NETuint8_t(&kind);
+			NETuint32_t(&sequence);
+			NETuint64_t(&sentTime);
+			NETbin(payload, sizeof(payload));
+			NETend();
+
+			switch (kind)
+			{
+			case TEST_START:   started[queue.index] = true; break;
+			case TEST_DONE:    done[queue.index] = true;    break;
+			case TEST_TRAFFIC:
+				++results.received;
+				delays.push_back(nowMicroseconds() - sentTime);
+				break;
+			}
+		}
+		NETpop(queue);
+	}
+}
+
+static void sendTestMessage(uint8_t kind, uint32_t sequence)
+{
+	uint64_t sentTime = nowMicroseconds();
+	uint8_t payload[PAYLOAD_SIZE];
+	memset(payload, sequence, sizeof(payload));
+	NETbeginEncode(NETgameQueue(selectedPlayer), TEST_MESSAGE);
+	NETuint8_t(&kind);
+	NETuint32_t(&sequence);
+	NETuint64_t(&sentTime);
+	NETbin(payload, sizeof(payload));
+	NETend();
+}
+
+static void initNetplay(unsigned numPlayers, unsigned gamePort, unsigned lobbyPort)
+{
+	game.maxPlayers = numPlayers;
+	NetPlay.isUPNP = false;
+	NETsetGameserverPort(gamePort);
+	NETsetMasterserverName("127.0.0.1");
+	NETsetMasterserverPort(lobbyPort);
+	NETinit(true);
+}
+
+/// Sets up the game queues once we know which player we are, like stageTwoInitialise() does.
+static void initGameQueues()
+{
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		NETinitQueue(NETgameQueue(player));
+		if (player != selectedPlayer)
+		{
+			NETsetNoSendOverNetwork(NETgameQueue(player));
+		}
+	}
+}
+
+/// Sends NUM_TICKS ticks of traffic, and receives everyone else's, once the host says to start.
+static void runGame(PeerResults &results, std::vector<uint32_t> &delays, unsigned numPlayers)
+{
+	bool started[MAX_PLAYERS] = {false};
+	bool done[MAX_PLAYERS] = {false};
+	auto everyone = [numPlayers](bool const flags[MAX_PLAYERS]) {
+		for (unsigned player = 0; player < numPlayers; ++player)
+		{
+			if (player != selectedPlayer && !flags[player])
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	initGameQueues();
+
+	int startTicks = wzGetTicks();
+	if (NetPlay.isHost)
+	{
+		sendTestMessage(TEST_START, 0);
+		NETflush();
+	}
+	else
+	{
+		while (!started[NET_HOST_ONLY] && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS)
+		{
+			pumpNet();
+			receiveGame(results, delays, started, done);
+			wzDelay(1);
+		}
+	}
+
+	startTicks = wzGetTicks();
+	for (unsigned tick = 0; tick < NUM_TICKS; ++tick)
+	{
+		for (unsigned n = 0; n < MESSAGES_PER_TICK; ++n)
+		{
+			sendTestMessage(TEST_TRAFFIC, results.sent++);
+		}
+		NETflush();
+
+		while (wzGetTicks() - startTicks < (int)((tick + 1) * TICK_MILLISECONDS))
+		{
+			pumpNet();
+			receiveGame(results, delays, started, done);
+			wzDelay(1);
+		}
+	}
+
+	sendTestMessage(TEST_DONE, results.sent);
+	NETflush();
+	while (!everyone(done) && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS)
+	{
+		pumpNet();
+		receiveGame(results, delays, started, done);
+		wzDelay(1);
+	}
+
+	results.milliseconds = wzGetTicks() - startTicks;
+	results.rawBytesSent = NETgetStatistic(NetStatisticRawBytes, true, true);
+	results.uncompressedBytesSent = NETgetStatistic(NetStatisticUncompressedBytes, true, true);
+	results.rawBytesReceived = NETgetStatistic(NetStatisticRawBytes, false, true);
+	results.ok = everyone(done) && results.received == (numPlayers - 1) * NUM_TICKS * MESSAGES_PER_TICK;
+}
+
+/// A stand-in for the lobby server, which gives the host a game ID, and accepts the game registration and updates.
+static bool runLobby(unsigned port)
+{
+	GAMESTRUCT const *g = nullptr;
+	const size_t gameStructSize = sizeof(g->GAMESTRUCT_VERSION) + sizeof(g->name) + sizeof(g->desc.host) + (sizeof(int32_t) * 8) +
+	                              sizeof(g->secondaryHosts) + sizeof(g->extra) + sizeof(g->mapname) + sizeof(g->hostname) + sizeof(g->versionstring) +
+	                              sizeof(g->modlist) + (sizeof(uint32_t) * 9);
+
+	SOCKETinit();
+	Socket *listenSocket = socketListen(port);
+	ASSERT_OR_RETURN(false, listenSocket != nullptr, "Can't listen on port %u", port);
+
+	Socket *sock = nullptr;
+	for (int startTicks = wzGetTicks(); sock == nullptr && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS; wzDelay(10))
+	{
+		sock = socketAccept(listenSocket);
+	}
+	ASSERT_OR_RETURN(false, sock != nullptr, "The host never registered the game.");
+
+	char command[5];
+	uint32_t gameId = htonl(1);
+	std::vector<char> gameStruct(gameStructSize);
+	bool ok = readAll(sock, command, sizeof(command), TIMEOUT_MILLISECONDS) == sizeof(command) && strcmp(command, "gaId") == 0
+	          && writeAll(sock, &gameId, sizeof(gameId)) == sizeof(gameId)
+	          && readAll(sock, command, sizeof(command), TIMEOUT_MILLISECONDS) == sizeof(command) && strcmp(command, "addg") == 0
+	          && readAll(sock, gameStruct.data(), gameStruct.size(), TIMEOUT_MILLISECONDS) == (ssize_t)gameStruct.size();
+	const char motd[] = "Welcome to the loopback lobby.";
+	uint32_t response[2] = {htonl(200), htonl(strlen(motd))};
+	ok = ok && writeAll(sock, response, sizeof(response)) == sizeof(response)
+	     && writeAll(sock, motd, strlen(motd)) == (ssize_t)strlen(motd);
+
+	// Player count updates, until the host stops accepting players.
+	SocketSet *set = allocSocketSet();
+	SocketSet_AddSocket(set, sock);
+	for (int startTicks = wzGetTicks(); ok && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS;)
+	{
+		if (checkSockets(set, 100) > 0 && socketReadReady(sock))
+		{
+			char buffer[4096];
+			ssize_t size = readNoInt(sock, buffer, sizeof(buffer));
+			if (size == 0 || size == SOCKET_ERROR)
+			{
+				break;
+			}
+		}
+	}
+	SocketSet_DelSocket(set, sock);
+	deleteSocketSet(set);
+	socketClose(sock);
+	socketClose(listenSocket);
+	SOCKETshutdown();
+	return ok;
+}
+
+static bool runClient(unsigned numPlayers, unsigned gamePort, unsigned lobbyPort, int resultFd)
+{
+	initNetplay(numPlayers, gamePort, lobbyPort);
+
+	bool joined = false;
+	for (int startTicks = wzGetTicks(); !joined && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS;)
+	{
+		joined = NETjoinGame("127.0.0.1", gamePort, "client");
+		if (!joined)
+		{
+			wzDelay(100);  // The host probably isn't listening yet.
+		}
+	}
+
+	PeerResults results;
+	memset(&results, 0, sizeof(results));
+	std::vector<uint32_t> delays;
+	if (joined)
+	{
+		runGame(results, delays, numPlayers);
+	}
+	results.player = selectedPlayer;
+	results.numDelays = delays.size();
+
+	bool ok = write(resultFd, &results, sizeof(results)) == sizeof(results)
+	          && write(resultFd, delays.data(), delays.size() * sizeof(uint32_t)) == (ssize_t)(delays.size() * sizeof(uint32_t));
+	close(resultFd);
+	NETclose();
+	NETshutdown();
+	return joined && ok && results.ok;
+}
+
+static uint32_t percentile(std::vector<uint32_t> const &sorted, unsigned percent)
+{
+	return sorted.empty() ? 0 : sorted[std::min<size_t>(sorted.size() * percent / 100, sorted.size() - 1)];
+}
+
+/// Hosts a game with NUM_CLIENTS clients, each in their own process since the netplay state is global, and reports the throughput and delays.
+static void testLoopback()
+{
+	const unsigned numPlayers = NUM_CLIENTS + 1;
+	const unsigned gamePort = 20000 + getpid() % 10000 * 2;
+	const unsigned lobbyPort = gamePort + 1;
+
+	// Fork before any threads are started.
+	fflush(stdout);
+	fflush(stderr);
+	pid_t lobby = fork();
+	if (lobby == 0)
+	{
+		_exit(runLobby(lobbyPort) ? 0 : 1);
+	}
+	pid_t clients[NUM_CLIENTS];
+	int resultFds[NUM_CLIENTS];
+	for (unsigned n = 0; n < NUM_CLIENTS; ++n)
+	{
+		int fds[2];
+		CHECK(pipe(fds) == 0);
+		clients[n] = fork();
+		if (clients[n] == 0)
+		{
+			close(fds[0]);
+			_exit(runClient(numPlayers, gamePort, lobbyPort, fds[1]) ? 0 : 1);
+		}
+		close(fds[1]);
+		resultFds[n] = fds[0];
+	}
+
+	initNetplay(numPlayers, gamePort, lobbyPort);
+	CHECK(NEThostGame("netplaytest", "host", 0, 0, 0, 0, numPlayers));
+	for (int startTicks = wzGetTicks(); NetPlay.playercount < numPlayers && wzGetTicks() - startTicks < TIMEOUT_MILLISECONDS;)
+	{
+		pumpNet();
+		wzDelay(1);
+	}
+	CHECK(NetPlay.playercount == numPlayers);
+	NEThaltJoining();  // Like when the game starts, and lets the lobby stand-in finish.
+
+	PeerResults hostResults;
+	memset(&hostResults, 0, sizeof(hostResults));
+	std::vector<uint32_t> delays;
+	runGame(hostResults, delays, numPlayers);
+	CHECK(hostResults.ok);
+
+	uint64_t received = hostResults.received, rawBytes = hostResults.rawBytesSent, uncompressedBytes = hostResults.uncompressedBytesSent;
+	uint32_t milliseconds = hostResults.milliseconds;
+	for (unsigned n = 0; n < NUM_CLIENTS; ++n)
+	{
+		PeerResults results;
+		memset(&results, 0, sizeof(results));
+		CHECK(read(resultFds[n], &results, sizeof(results)) == sizeof(results));
+		size_t oldSize = delays.size();
+		delays.resize(oldSize + results.numDelays);
+		size_t bytes = results.numDelays * sizeof(uint32_t);
+		for (size_t got = 0; got < bytes;)
+		{
+			ssize_t len = read(resultFds[n], (char *)&delays[oldSize] + got, bytes - got);
+			if (len <= 0)
+			{
+				delays.resize(oldSize + got / sizeof(uint32_t));
+				break;
+			}
+			got += len;
+		}
+		close(resultFds[n]);
+		received += results.received;
+		rawBytes += results.rawBytesSent;
+		uncompressedBytes += results.uncompressedBytesSent;
+		milliseconds = std::max(milliseconds, results.milliseconds);
+		CHECK(results.ok);
+
+		int status = 0;
+		CHECK(waitpid(clients[n], &status, 0) == clients[n] && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+	NETclose();
+	NETshutdown();
+	int status = 0;
+	CHECK(waitpid(lobby, &status, 0) == lobby && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	std::sort(delays.begin(), delays.end());
+	double seconds = std::max(milliseconds, 1u) / 1000.;
+	printf("netplaytest: 1 host and %u clients, %u ticks of %u messages: %u messages received in %.2f s, %.0f messages/s\n",
+	       NUM_CLIENTS, NUM_TICKS, MESSAGES_PER_TICK, (unsigned)received, seconds, received / seconds);
+	printf("netplaytest: %.1f kB sent on the wire, %.1f kB uncompressed; one-way delay p50 %.2f ms, p99 %.2f ms\n",
+	       rawBytes / 1e3, uncompressedBytes / 1e3, percentile(delays, 50) / 1e3, percentile(delays, 99) / 1e3);
+}
+
+int main(void)
+{
+	testLoopback();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/netplay/netqueue.h"
+
+#include <chrono>
+#include <stdio.h>
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "netqueuetest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+static NetMessage makeMessage(unsigned n)
+{
+	NetMessage message(n % 256);
+	message.data.assign(n * 37 % 3000, (uint8_t)n);
+	return message;
+}
+
+static bool isMessage(NetMessage const &message, unsigned n)
+{
+	NetMessage expected = makeMessage(n);
+	return message.type == expected.type && message.data == expected.data;
+}
+
+static void appendRaw(std::vector<uint8_t> &stream, NetMessage const &message)
+{
+	uint8_t header[NET_MESSAGE_MAX_HEADER];
+	size_t headerLen = message.rawHeader(header);
+	stream.insert(stream.end(), header, header + headerLen);
+	stream.insert(stream.end(), message.data.begin(), message.data.end());
+}
+
+/// Messages sent over the network and got by ourselves are popped separately, and only forgotten once popped by both.
+static void testPositions()
+{
+	NetQueue queue;
+	unsigned sent = 0, got = 0;
+	for (unsigned n = 0; n < 1000; ++n)
+	{
+		queue.pushMessage(makeMessage(n));
+		CHECK(queue.numMessagesForNet() == n + 1 - sent);
+
+		// Send every 3rd time, get every 5th time, so the queue has to grow while messages are unpopped.
+		while (n % 3 == 0 && queue.numMessagesForNet() > 0)
+		{
+			CHECK(isMessage(queue.getMessageForNet(), sent));
+			queue.popMessageForNet();
+			++sent;
+		}
+		while (n % 5 == 0 && queue.haveMessage())
+		{
+			CHECK(isMessage(queue.getMessage(), got));
+			queue.popMessage();
+			++got;
+		}
+	}
+	while (queue.numMessagesForNet() > 0)
+	{
+		CHECK(isMessage(queue.getMessageForNet(), sent));
+		queue.popMessageForNet();
+		++sent;
+	}
+	while (queue.haveMessage())
+	{
+		CHECK(isMessage(queue.getMessage(), got));
+		queue.popMessage();
+		++got;
+	}
+	CHECK(sent == 1000 && got == 1000);
+}
+
+/// The data of the current message doesn't move while more messages are pushed.
+static void testStableData()
+{
+	NetQueue queue;
+	queue.pushMessage(makeMessage(100));
+	MessageReader reader(queue.getMessage());
+	for (unsigned n = 0; n < 1000; ++n)
+	{
+		queue.pushMessage(makeMessage(n));
+	}
+	CHECK(reader.data == queue.getMessage().data.data());
+	CHECK(isMessage(queue.getMessage(), 100));
+}
+
+/// Data from the network, arriving in pieces of any size, gives back the same messages.
+static void testRawData()
+{
+	NetQueuePair pair;
+	std::vector<uint8_t> stream;
+	for (unsigned n = 0; n < 1000; ++n)
+	{
+		appendRaw(stream, makeMessage(n));
+	}
+
+	unsigned got = 0;
+	for (size_t pos = 0; pos < stream.size();)
+	{
+		size_t len = std::min<size_t>(stream.size() - pos, 1 + pos % 777);
+		pair.receive.writeRawData(&stream[pos], len);
+		pos += len;
+		while (pair.receive.haveMessage())
+		{
+			CHECK(isMessage(pair.receive.getMessage(), got));
+			pair.receive.popMessage();
+			++got;
+		}
+	}
+	CHECK(got == 1000);
+}
+
+/// Time sending messages through a send queue, and splitting them in a receive queue.
+static void benchmark()
+{
+	const unsigned numMessages = 1000000;
+	NetQueuePair sender, receiver;
+	NetMessage message(42);
+	std::vector<uint8_t> stream;
+	uint64_t bytes = 0;
+	unsigned received = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned n = 0; n < numMessages; ++n)
+	{
+		message.data.assign(8 + n % 64, (uint8_t)n);
+		sender.send.pushMessage(message);
+		appendRaw(stream, sender.send.getMessageForNet());
+		sender.send.popMessageForNet();
+
+		if (stream.size() >= 1400 || n + 1 == numMessages)  // About a packet at a time.
+		{
+			receiver.receive.writeRawData(stream.data(), stream.size());
+			bytes += stream.size();
+			stream.clear();
+			while (receiver.receive.haveMessage())
+			{
+				MessageReader reader(receiver.receive.getMessage());
+				uint8_t first;
+				reader.byte(first);
+				receiver.receive.popMessage();
+				++received;
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	CHECK(received == numMessages);
+	printf("netqueuetest: %u messages, %.1f MB, in %.3f s: %.2f million messages/s, %.1f MB/s\n",
+	       numMessages, bytes / 1e6, seconds, numMessages / seconds / 1e6, bytes / seconds / 1e6);
+}
+
+int main(void)
+{
+	testPositions();
+	testStableData();
+	testRawData();
+	benchmark();
+	return failures == 0 ? 0 : 1;
+}
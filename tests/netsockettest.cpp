@@ -0,0 +1,245 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/netplay/netsocket.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// --- dummy backend implementation, threads for the socket thread ---
+
+struct WZ_THREAD
+{
+	int (*function)(void *);
+	void *data;
+	int result;
+	std::thread thread;
+};
+
+struct WZ_MUTEX
+{
+	std::mutex mutex;
+};
+
+struct WZ_SEMAPHORE
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	int count;
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data)
+{
+	WZ_THREAD *thread = new WZ_THREAD;
+	thread->function = threadFunc;
+	thread->data = data;
+	thread->result = 0;
+	return thread;
+}
+
+void wzThreadStart(WZ_THREAD *thread)
+{
+	thread->thread = std::thread([thread]() { thread->result = thread->function(thread->data); });
+}
+
+int wzThreadJoin(WZ_THREAD *thread)
+{
+	thread->thread.join();
+	int result = thread->result;
+	delete thread;
+	return result;
+}
+
+WZ_MUTEX *wzMutexCreate()
+{
+	return new WZ_MUTEX;
+}
+
+void wzMutexDestroy(WZ_MUTEX *mutex)
+{
+	delete mutex;
+}
+
+void wzMutexLock(WZ_MUTEX *mutex)
+{
+	mutex->mutex.lock();
+}
+
+void wzMutexUnlock(WZ_MUTEX *mutex)
+{
+	mutex->mutex.unlock();
+}
+
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue)
+{
+	WZ_SEMAPHORE *semaphore = new WZ_SEMAPHORE;
+	semaphore->count = startValue;
+	return semaphore;
+}
+
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore)
+{
+	delete semaphore;
+}
+
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore)
+{
+	std::unique_lock<std::mutex> lock(semaphore->mutex);
+	semaphore->condition.wait(lock, [semaphore]() { return semaphore->count > 0; });
+	--semaphore->count;
+}
+
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore)
+{
+	std::lock_guard<std::mutex> lock(semaphore->mutex);
+	++semaphore->count;
+	semaphore->condition.notify_one();
+}
+
+int wzGetTicks()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "netsockettest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+#define TIMEOUT_MILLISECONDS 2000
+
+/// Not a zlib stream, so inflate() fails on the header.
+static const uint8_t garbage[] = {0xFF, 0x00, 0x13, 0x37, 0xDE, 0xAD, 0xBE, 0xEF, 0x55, 0xAA, 0x55, 0xAA};
+
+/// Makes a compressed Socket of one end of a socketpair(), and returns the descriptor of the other end to write to.
+static Socket *makeCompressedSocket(int *peer)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		CHECK(!"socketpair failed");
+		return nullptr;
+	}
+	Socket *sock = socketFromDescriptor(fds[0]);
+	CHECK(sock != nullptr);
+	if (sock != nullptr)
+	{
+		socketBeginCompression(sock);
+	}
+	*peer = fds[1];
+	return sock;
+}
+
+/// Bad compressed data is reported as a broken connection, not as "nothing to read", even if errno was left at EAGAIN by an earlier read.
+static void testReadGarbage()
+{
+	int peer;
+	Socket *sock = makeCompressedSocket(&peer);
+	if (sock == nullptr)
+	{
+		return;
+	}
+	CHECK(write(peer, garbage, sizeof(garbage)) == sizeof(garbage));
+
+	uint8_t buffer[256];
+	size_t rawBytes = 0;
+	setSockErr(EAGAIN);
+	ssize_t size = readNoInt(sock, buffer, sizeof(buffer), &rawBytes);
+	CHECK(size == SOCKET_ERROR);
+	CHECK(getSockErr() == ECONNRESET);
+	CHECK(rawBytes == sizeof(garbage));
+
+	socketClose(sock);
+	close(peer);
+}
+
+struct ThreadReadState
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool disconnected = false;
+	unsigned calls = 0;
+};
+
+static void threadRead(void *context, uint8_t const *, size_t, size_t, bool disconnected)
+{
+	ThreadReadState *state = (ThreadReadState *)context;
+	std::lock_guard<std::mutex> lock(state->mutex);
+	++state->calls;
+	state->disconnected = state->disconnected || disconnected;
+	state->condition.notify_all();
+}
+
+/// The socket thread drops a peer that sends bad compressed data, rather than trying to read it again every pass.
+static void testThreadReadGarbage()
+{
+	int peer;
+	Socket *sock = makeCompressedSocket(&peer);
+	if (sock == nullptr)
+	{
+		return;
+	}
+
+	// Leave a stale EAGAIN behind on the socket thread, the way reading another socket with nothing to read would.
+	int idlePeer;
+	Socket *idle = makeCompressedSocket(&idlePeer);
+	ThreadReadState idleState;
+	if (idle != nullptr)
+	{
+		socketReadInThread(idle, threadRead, &idleState);
+	}
+
+	ThreadReadState state;
+	socketReadInThread(sock, threadRead, &state);
+	CHECK(write(peer, garbage, sizeof(garbage)) == sizeof(garbage));
+
+	{
+		std::unique_lock<std::mutex> lock(state.mutex);
+		CHECK(state.condition.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MILLISECONDS), [&state]() { return state.disconnected; }));
+		CHECK(state.calls == 1);
+	}
+	{
+		std::lock_guard<std::mutex> lock(idleState.mutex);
+		CHECK(!idleState.disconnected);
+	}
+
+	socketClose(sock);
+	close(peer);
+	if (idle != nullptr)
+	{
+		socketClose(idle);
+		close(idlePeer);
+	}
+}
+
+int main(int, char **)
+{
+	SOCKETinit();
+
+	testReadGarbage();
+	testThreadReadGarbage();
+
+	SOCKETshutdown();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/framework/wzconfig.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+
+#include <chrono>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// Only needed for writing files in the background, which this test doesn't do.
+WZ_THREAD *wzThreadCreate(int (*)(void *), void *)
+{
+	abort();
+}
+
+int wzThreadJoin(WZ_THREAD *)
+{
+	abort();
+}
+
+void wzThreadStart(WZ_THREAD *)
+{
+	abort();
+}
+
+WZ_MUTEX *wzMutexCreate()
+{
+	abort();
+}
+
+void wzMutexDestroy(WZ_MUTEX *)
+{
+	abort();
+}
+
+void wzMutexLock(WZ_MUTEX *)
+{
+	abort();
+}
+
+void wzMutexUnlock(WZ_MUTEX *)
+{
+	abort();
+}
+
+WZ_SEMAPHORE *wzSemaphoreCreate(int)
+{
+	abort();
+}
+
+void wzSemaphoreDestroy(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
+void wzSemaphoreWait(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
+void wzSemaphorePost(WZ_SEMAPHORE *)
+{
+	abort();
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "wzconfigtest: %s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); ++failures; } } while (0)
+
+#define REPEATS 10
+#define ARRAY_ITEMS 2000
+
+static const char *fixtureFile = "wzconfigtest.json";
+
+static const char *statsFiles[] =
+{
+	"stats/body.json", "stats/construction.json", "stats/ecm.json", "stats/propulsion.json", "stats/propulsionsounds.json",
+	"stats/propulsiontype.json", "stats/repair.json", "stats/research.json", "stats/sensor.json", "stats/structure.json",
+	"stats/structuremodifier.json", "stats/templates.json", "stats/weaponmodifier.json", "stats/weapons.json"
+};
+
+/// Reads every value in the current group, and in the groups in it, the way the stats loaders do.
+static unsigned walkGroup(WzConfig &ini)
+{
+	unsigned values = 0;
+	QStringList groups = ini.childGroups();
+	for (QString const &key : ini.childKeys())
+	{
+		if (groups.contains(key))
+		{
+			CHECK(ini.beginGroup(key));
+			values += walkGroup(ini);
+			ini.endGroup();
+			continue;
+		}
+		QVariant value = ini.value(key, QString("missing"));
+		CHECK(value != QVariant(QString("missing")));
+		CHECK(ini.json(key) == QJsonValue::fromVariant(value));
+		++values;
+	}
+	CHECK(!ini.contains("no such key"));
+	CHECK(ini.value("no such key", 42).toInt() == 42);
+	CHECK(!ini.beginGroup("no such group"));
+	ini.endGroup();
+	return values;
+}
+
+/// Writes the file that testArrays() and testVectors() read, with vectors written both as numbers and as strings of them.
+static void writeFixture()
+{
+	QJsonObject vectors;
+	vectors.insert("v2", QJsonArray({1, "2"}));
+	vectors.insert("v3i", QJsonArray({"3", 4, -5}));
+	vectors.insert("v3f", QJsonArray({0.5, "1.5", -2}));
+	vectors.insert("short", QJsonArray({1, 2}));
+	vectors.insert("long", QJsonArray({1, 2, 3, 4}));
+	vectors.insert("notArray", 7);
+
+	QJsonArray items;
+	for (int i = 0; i < ARRAY_ITEMS; ++i)
+	{
+		QJsonObject item;
+		item.insert("id", i);
+		item.insert("pos", QJsonArray({i, QString::number(-i)}));
+		item.insert("dir", QJsonArray({QString::number(i), 0, i}));
+		items.append(item);
+	}
+
+	QJsonObject root;
+	root.insert("vectors", vectors);
+	root.insert("items", items);
+	QByteArray data = QJsonDocument(root).toJson();
+
+	PHYSFS_file *file = PHYSFS_openWrite(fixtureFile);
+	CHECK(file != nullptr);
+	if (file != nullptr)
+	{
+		CHECK(PHYSFS_write(file, data.constData(), data.size(), 1) == 1);
+		PHYSFS_close(file);
+	}
+}
+
+/// Steps through the items the way the loaders do, and returns how many there were.
+static unsigned testArrays(WzConfig &ini)
+{
+	unsigned count = 0;
+	ini.beginArray("items");
+	while (ini.remainingArrayItems() > 0)
+	{
+		CHECK(ini.remainingArrayItems() == ARRAY_ITEMS - (int)count);
+		int id = ini.value("id", -1).toInt();
+		CHECK(id == (int)count);
+		CHECK(ini.vector2i("pos") == Vector2i(id, -id));
+		CHECK(ini.vector3i("dir") == Vector3i(id, 0, id));
+		ini.nextArrayItem();
+		++count;
+	}
+	CHECK(ini.remainingArrayItems() == 0);
+	ini.endArray();
+	CHECK(ini.contains("vectors"));  // Back in the top level object.
+
+	ini.beginArray("no such array");
+	CHECK(ini.remainingArrayItems() == 0);
+	ini.endArray();
+	CHECK(ini.contains("items"));
+
+	// Going through the same array again starts from the first item.
+	ini.beginArray("items");
+	CHECK(ini.remainingArrayItems() == ARRAY_ITEMS);
+	CHECK(ini.value("id", -1).toInt() == 0);
+	ini.endArray();
+	return count;
+}
+
+static void testVectors(WzConfig &ini)
+{
+	CHECK(ini.beginGroup("vectors"));
+	CHECK(ini.vector2i("v2") == Vector2i(1, 2));
+	CHECK(ini.vector3i("v3i") == Vector3i(3, 4, -5));
+	CHECK(ini.vector3f("v3f") == Vector3f(0.5f, 1.5f, -2.f));
+
+	// Missing keys give zero, without asserting.
+	CHECK(ini.vector2i("no such key") == Vector2i(0, 0));
+	CHECK(ini.vector3i("no such key") == Vector3i(0, 0, 0));
+	CHECK(ini.vector3f("no such key") == Vector3f(0.f, 0.f, 0.f));
+
+	// Lists of the wrong length, and values that aren't lists, assert and give zero.
+	bool wasEnabled = assertEnabled;
+	assertEnabled = false;
+	CHECK(ini.vector2i("long") == Vector2i(0, 0));
+	CHECK(ini.vector3i("short") == Vector3i(0, 0, 0));
+	CHECK(ini.vector3f("long") == Vector3f(0.f, 0.f, 0.f));
+	CHECK(ini.vector2i("notArray") == Vector2i(0, 0));
+	CHECK(ini.vector3i("notArray") == Vector3i(0, 0, 0));
+	assertEnabled = wasEnabled;
+	ini.endGroup();
+}
+
+int main(int argc, char **argv)
+{
+	char datapath[PATH_MAX];
+
+	PHYSFS_init(argv[0]);
+	strcpy(datapath, getenv("srcdir"));
+	strcat(datapath, "/../data/mp");
+	PHYSFS_addToSearchPath(datapath, 1);
+
+	unsigned values = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		values = 0;
+		for (const char *file : statsFiles)
+		{
+			WzConfig ini(file, WzConfig::ReadOnlyAndRequired);
+			unsigned fileValues = walkGroup(ini);
+			CHECK(fileValues > 0);
+			values += fileValues;
+		}
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+	printf("wzconfigtest: loaded %u files, %u values, in %.2f ms\n", (unsigned)ARRAY_SIZE(statsFiles), values, ms);
+
+	// The stats files have no arrays of objects, so time those on a file of our own.
+	PHYSFS_setWriteDir(".");
+	PHYSFS_addToSearchPath(".", 0);
+	writeFixture();
+	unsigned items = 0;
+	start = std::chrono::steady_clock::now();
+	for (int repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		WzConfig ini(fixtureFile, WzConfig::ReadOnlyAndRequired);
+		items = testArrays(ini);
+	}
+	ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+	CHECK(items == ARRAY_ITEMS);
+
+	printf("wzconfigtest: read %u array items, in %.2f ms\n", items, ms);
+
+	WzConfig ini(fixtureFile, WzConfig::ReadOnlyAndRequired);
+	testVectors(ini);
+	PHYSFS_delete(fixtureFile);
+
+	PHYSFS_deinit();
+	return failures != 0;
+}